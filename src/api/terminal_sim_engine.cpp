@@ -0,0 +1,194 @@
+#include "terminal_sim_engine.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <stdexcept>
+
+namespace TerminalSim
+{
+
+namespace
+{
+
+QList<ContainerCore::Container> containersFromJson(const QJsonArray &array)
+{
+    QList<ContainerCore::Container> containers;
+    containers.reserve(array.size());
+    for (const QJsonValue &value : array)
+    {
+        if (value.isObject())
+            containers.append(ContainerCore::Container(value.toObject()));
+    }
+    return containers;
+}
+
+ContainerReservationResult reservationFromJson(const QJsonObject &json)
+{
+    ContainerReservationResult result;
+    result.reservationId =
+        json.value(QStringLiteral("reservation_id")).toString();
+    result.state  = json.value(QStringLiteral("state")).toString();
+    result.reason = json.value(QStringLiteral("reason")).toString();
+    result.containers =
+        containersFromJson(json.value(QStringLiteral("containers")).toArray());
+    result.containerCount =
+        json.value(QStringLiteral("container_count")).toInt();
+    return result;
+}
+
+} // namespace
+
+TerminalSimEngine::TerminalSimEngine(const QString &terminalsDirectory)
+    : m_graph(std::make_unique<TerminalGraph>(terminalsDirectory))
+{
+}
+
+TerminalSimEngine::TerminalSimEngine(std::unique_ptr<TerminalGraph> graph)
+    : m_graph(std::move(graph))
+{
+}
+
+TerminalSimEngine::~TerminalSimEngine() = default;
+
+TerminalGraph &TerminalSimEngine::graph()
+{
+    return *m_graph;
+}
+
+std::unique_ptr<TerminalSimEngine> TerminalSimEngine::fork()
+{
+    return std::unique_ptr<TerminalSimEngine>(new TerminalSimEngine(
+        std::unique_ptr<TerminalGraph>(m_graph->fork())));
+}
+
+QMap<QString, Terminal *>
+TerminalSimEngine::addTerminals(const QList<QVariantMap> &terminals)
+{
+    return m_graph->addTerminals(terminals);
+}
+
+QList<QPair<QString, QString>>
+TerminalSimEngine::addRoutes(const QList<QVariantMap> &routes)
+{
+    return m_graph->addRoutes(routes);
+}
+
+QList<PathSegment>
+TerminalSimEngine::findShortestPath(const QString &start, const QString &end,
+                                    TransportationModeMask modes)
+{
+    return m_graph->findShortestPath(start, end, modes);
+}
+
+QList<Path> TerminalSimEngine::findTopPaths(const TopPathsQuery &query)
+{
+    return query.transferAwareSearch
+               ? m_graph->findTopNTransferAwarePaths(
+                     query.start, query.end, query.n, query.modes,
+                     query.skipSameModeTerminalDelaysAndCosts)
+               : m_graph->findTopNShortestPaths(
+                     query.start, query.end, query.n, query.modes,
+                     query.skipSameModeTerminalDelaysAndCosts);
+}
+
+void TerminalSimEngine::addContainers(
+    const QString                         &terminalId,
+    const QList<ContainerCore::Container> &containers,
+    const ContainerArrivalOptions         &options)
+{
+    terminal(terminalId)->addContainers(containers, options.addingTime,
+                                        options.mode, options.semantics);
+}
+
+QList<ContainerCore::Container> TerminalSimEngine::getContainers(
+    const QString                                   &terminalId,
+    const ContainerCore::ContainerSelectionCriteria &criteria)
+{
+    return containersFromJson(terminal(terminalId)->getContainers(criteria));
+}
+
+QList<ContainerCore::Container> TerminalSimEngine::dequeueContainers(
+    const QString                                   &terminalId,
+    const ContainerCore::ContainerSelectionCriteria &criteria,
+    double                                           operationTime)
+{
+    return containersFromJson(
+        terminal(terminalId)->dequeueContainers(criteria, operationTime));
+}
+
+int TerminalSimEngine::containerCount(const QString &terminalId)
+{
+    return terminal(terminalId)->getContainerCount();
+}
+
+ContainerReservationResult TerminalSimEngine::reserveContainers(
+    const QString &terminalId, const QString &reservationId,
+    const ContainerCore::ContainerSelectionCriteria &criteria)
+{
+    return reservationFromJson(
+        terminal(terminalId)->reserveContainers(reservationId, criteria));
+}
+
+ContainerReservationResult TerminalSimEngine::commitContainerReservation(
+    const QString &terminalId, const QString &reservationId,
+    double operationTime)
+{
+    return reservationFromJson(terminal(terminalId)->commitContainerReservation(
+        reservationId, operationTime));
+}
+
+ContainerReservationResult TerminalSimEngine::releaseContainerReservation(
+    const QString &terminalId, const QString &reservationId)
+{
+    return reservationFromJson(
+        terminal(terminalId)->releaseContainerReservation(reservationId));
+}
+
+SystemDynamicsState
+TerminalSimEngine::updateSystemDynamics(const QString &terminalId,
+                                        double currentTime, double deltaT)
+{
+    Terminal *target = terminal(terminalId);
+    target->updateSystemDynamics(currentTime, deltaT);
+    return target->systemDynamicsState();
+}
+
+QMap<QString, SystemDynamicsState>
+TerminalSimEngine::updateAllSystemDynamics(double currentTime, double deltaT)
+{
+    // Like update_all_terminals_sd, terminals without SD are left out
+    QMap<QString, SystemDynamicsState> states;
+    const QStringList names = m_graph->getAllTerminalNames(false).keys();
+    for (const QString &name : names)
+    {
+        Terminal *target = m_graph->getTerminal(name);
+        if (target && target->isSystemDynamicsEnabled())
+        {
+            target->updateSystemDynamics(currentTime, deltaT);
+            states.insert(name, target->systemDynamicsState());
+        }
+    }
+    return states;
+}
+
+SystemDynamicsState
+TerminalSimEngine::systemDynamicsState(const QString &terminalId)
+{
+    return terminal(terminalId)->systemDynamicsState();
+}
+
+int TerminalSimEngine::resetRuntimeState(const QStringList &terminalIds)
+{
+    return m_graph->resetRuntimeState(terminalIds);
+}
+
+Terminal *TerminalSimEngine::terminal(const QString &terminalId) const
+{
+    if (terminalId.isEmpty())
+    {
+        throw std::invalid_argument("Terminal ID must be provided");
+    }
+    return m_graph->getTerminal(terminalId);
+}
+
+} // namespace TerminalSim
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <memory>
+
+#include <containerLib/container.h>
+#include <containerLib/containermap.h>
+
+#include "terminal/terminal.h"
+#include "terminal/terminal_graph.h"
+
+namespace TerminalSim
+{
+
+/**
+ * @brief Options of a container arrival, as add_containers takes them
+ */
+struct ContainerArrivalOptions
+{
+    double                   addingTime = -1.0; ///< Seconds; -1 uses the SD clock
+    TransportationMode       mode       = TransportationMode::Any;
+    TerminalArrivalSemantics semantics  = TerminalArrivalSemantics::Infer;
+};
+
+/**
+ * @brief Top-N route query, with the defaults of find_top_paths
+ */
+struct TopPathsQuery
+{
+    QString                start;
+    QString                end;
+    int                    n     = 5;
+    TransportationModeMask modes = TransportationMode::Truck;
+    bool skipSameModeTerminalDelaysAndCosts = true;
+    bool transferAwareSearch                = false;
+};
+
+/**
+ * @brief Outcome of reserving, committing or releasing a reservation
+ */
+struct ContainerReservationResult
+{
+    QString reservationId;
+    QString state;  ///< active, committed, released or blocked
+    QString reason; ///< Set when blocked
+    QList<ContainerCore::Container> containers;
+    int                             containerCount = 0;
+};
+
+/**
+ * @brief In-process API over a TerminalGraph for embedding simulators
+ *
+ * Each call has the semantics of the command of the same name, without
+ * the broker, the JSON envelope or QVariantMap parameter parsing. Network
+ * set-up keeps the map-based definitions of add_terminal and add_route;
+ * the per-step calls take and return typed values. All calls are thread
+ * safe in the same way as TerminalGraph and Terminal, and errors are
+ * thrown as std::invalid_argument or std::runtime_error like the commands
+ * report them.
+ */
+class TerminalSimEngine
+{
+public:
+    /**
+     * @param terminalsDirectory Directory for SQL-backed terminal storage;
+     * empty keeps containers in memory
+     */
+    explicit TerminalSimEngine(const QString &terminalsDirectory = QString());
+    ~TerminalSimEngine();
+
+    TerminalSimEngine(const TerminalSimEngine &)            = delete;
+    TerminalSimEngine &operator=(const TerminalSimEngine &) = delete;
+
+    /**
+     * @brief Underlying graph, for operations without a typed wrapper
+     */
+    TerminalGraph &graph();
+
+    /**
+     * @brief Copy-on-write branch of the network and runtime state
+     * @see TerminalGraph::fork()
+     */
+    std::unique_ptr<TerminalSimEngine> fork();
+
+    // Network set-up (add_terminals, add_routes)
+    QMap<QString, Terminal *>
+    addTerminals(const QList<QVariantMap> &terminals);
+    QList<QPair<QString, QString>> addRoutes(const QList<QVariantMap> &routes);
+
+    // Routing (find_shortest_path, find_top_paths)
+    QList<PathSegment>
+    findShortestPath(const QString &start, const QString &end,
+                     TransportationModeMask modes = TransportationMode::Any);
+    QList<Path> findTopPaths(const TopPathsQuery &query);
+
+    // Containers (add_containers, get_containers, dequeue_containers,
+    // get_container_count)
+    void addContainers(const QString                         &terminalId,
+                       const QList<ContainerCore::Container> &containers,
+                       const ContainerArrivalOptions &options = {});
+    QList<ContainerCore::Container>
+    getContainers(const QString                                   &terminalId,
+                  const ContainerCore::ContainerSelectionCriteria &criteria);
+    QList<ContainerCore::Container>
+    dequeueContainers(const QString                                   &terminalId,
+                      const ContainerCore::ContainerSelectionCriteria &criteria,
+                      double operationTime = -1.0);
+    int containerCount(const QString &terminalId);
+
+    // Reservations (reserve_containers, commit_container_reservation,
+    // release_container_reservation)
+    ContainerReservationResult
+    reserveContainers(const QString &terminalId, const QString &reservationId,
+                      const ContainerCore::ContainerSelectionCriteria &criteria);
+    ContainerReservationResult
+    commitContainerReservation(const QString &terminalId,
+                               const QString &reservationId,
+                               double         operationTime = -1.0);
+    ContainerReservationResult
+    releaseContainerReservation(const QString &terminalId,
+                                const QString &reservationId);
+
+    // System dynamics (update_system_dynamics, update_all_terminals_sd,
+    // get_system_dynamics_state, reset_runtime_state)
+    SystemDynamicsState updateSystemDynamics(const QString &terminalId,
+                                             double         currentTime,
+                                             double         deltaT = 3600.0);
+    QMap<QString, SystemDynamicsState>
+    updateAllSystemDynamics(double currentTime, double deltaT = 3600.0);
+    SystemDynamicsState systemDynamicsState(const QString &terminalId);
+    int resetRuntimeState(const QStringList &terminalIds = {});
+
+private:
+    explicit TerminalSimEngine(std::unique_ptr<TerminalGraph> graph);
+
+    Terminal *terminal(const QString &terminalId) const;
+
+    std::unique_ptr<TerminalGraph> m_graph;
+};
+
+} // namespace TerminalSim
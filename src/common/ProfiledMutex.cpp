@@ -0,0 +1,356 @@
+#include "ProfiledMutex.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QList>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <unordered_map>
+
+namespace TerminalSim {
+
+namespace
+{
+
+// Bucket 0 counts waits under 1 us; bucket b below 2^b us, so the last
+// regular bucket ends near 1 s and the final one takes everything longer
+constexpr int WAIT_BUCKETS = 22;
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int waitBucket(qint64 waitNs)
+{
+    const qint64 waitUs = waitNs / 1000;
+    int          bucket = 0;
+    while (bucket < WAIT_BUCKETS - 1 && (qint64(1) << bucket) <= waitUs)
+        ++bucket;
+    return bucket;
+}
+
+struct SiteStats
+{
+    quint64 acquisitions = 0;
+    quint64 contended    = 0;
+    qint64  waitNs       = 0;
+    qint64  holdNs       = 0;
+    qint64  blockingNs   = 0; // Others' waits while this site held it
+};
+
+double toUs(qint64 ns)
+{
+    return static_cast<double>(ns) / 1000.0;
+}
+
+} // namespace
+
+class LockStats
+{
+public:
+    std::atomic<quint64>                            acquisitions{0};
+    std::atomic<quint64>                            contended{0};
+    std::atomic<qint64>                             waitNs{0};
+    std::atomic<qint64>                             maxWaitNs{0};
+    std::array<std::atomic<quint64>, WAIT_BUCKETS> histogram{};
+
+    // Keyed by the site string's address; merged by text when reported
+    std::mutex                                   sitesMutex;
+    std::unordered_map<const char *, SiteStats> sites;
+};
+
+std::atomic<bool> LockProfiler::s_enabled{false};
+
+LockProfiler::LockProfiler()
+    : m_resetAtMs(QDateTime::currentMSecsSinceEpoch())
+{
+}
+
+LockProfiler::~LockProfiler() = default;
+
+LockProfiler *LockProfiler::getInstance()
+{
+    // Never destroyed, so locks used during static destruction still
+    // have their counters
+    static LockProfiler *instance = new LockProfiler();
+    return instance;
+}
+
+void LockProfiler::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void LockProfiler::reset()
+{
+    std::lock_guard<std::mutex> registryLock(m_registryMutex);
+    for (auto &entry : m_stats)
+    {
+        LockStats &stats = *entry.second;
+        stats.acquisitions.store(0, std::memory_order_relaxed);
+        stats.contended.store(0, std::memory_order_relaxed);
+        stats.waitNs.store(0, std::memory_order_relaxed);
+        stats.maxWaitNs.store(0, std::memory_order_relaxed);
+        for (auto &count : stats.histogram)
+            count.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> sitesLock(stats.sitesMutex);
+        stats.sites.clear();
+    }
+    m_resetAtMs = QDateTime::currentMSecsSinceEpoch();
+}
+
+QJsonObject LockProfiler::report() const
+{
+    QList<QJsonObject> locks;
+    qint64             resetAtMs = 0;
+    {
+        std::lock_guard<std::mutex> registryLock(m_registryMutex);
+        resetAtMs = m_resetAtMs;
+        for (const auto &entry : m_stats)
+        {
+            LockStats &stats = *entry.second;
+
+            QJsonObject lock;
+            lock["name"] = QString::fromStdString(entry.first);
+            lock["acquisitions"] = static_cast<double>(
+                stats.acquisitions.load(std::memory_order_relaxed));
+            lock["contended"] = static_cast<double>(
+                stats.contended.load(std::memory_order_relaxed));
+            lock["total_wait_us"] =
+                toUs(stats.waitNs.load(std::memory_order_relaxed));
+            lock["max_wait_us"] =
+                toUs(stats.maxWaitNs.load(std::memory_order_relaxed));
+
+            // Up to the last non-empty bucket
+            int lastBucket = -1;
+            for (int b = 0; b < WAIT_BUCKETS; ++b)
+            {
+                if (stats.histogram[b].load(std::memory_order_relaxed) > 0)
+                    lastBucket = b;
+            }
+            QJsonArray histogram;
+            for (int b = 0; b <= lastBucket; ++b)
+            {
+                QJsonObject bucket;
+                if (b < WAIT_BUCKETS - 1)
+                    bucket["below_us"] = static_cast<double>(qint64(1) << b);
+                bucket["count"] = static_cast<double>(
+                    stats.histogram[b].load(std::memory_order_relaxed));
+                histogram.append(bucket);
+            }
+            lock["wait_histogram"] = histogram;
+
+            std::map<QString, SiteStats> merged;
+            {
+                std::lock_guard<std::mutex> sitesLock(stats.sitesMutex);
+                for (const auto &[site, counts] : stats.sites)
+                {
+                    SiteStats &total = merged[QString::fromUtf8(site)];
+                    total.acquisitions += counts.acquisitions;
+                    total.contended += counts.contended;
+                    total.waitNs += counts.waitNs;
+                    total.holdNs += counts.holdNs;
+                    total.blockingNs += counts.blockingNs;
+                }
+            }
+            QList<QPair<QString, SiteStats>> sites(merged.begin(),
+                                                   merged.end());
+            std::sort(sites.begin(), sites.end(),
+                      [](const auto &a, const auto &b) {
+                          return a.second.blockingNs + a.second.waitNs
+                                 > b.second.blockingNs + b.second.waitNs;
+                      });
+            QJsonArray siteArray;
+            for (const auto &[site, counts] : sites)
+            {
+                QJsonObject siteObject;
+                siteObject["site"]         = site;
+                siteObject["acquisitions"] =
+                    static_cast<double>(counts.acquisitions);
+                siteObject["contended"] = static_cast<double>(counts.contended);
+                siteObject["wait_us"]   = toUs(counts.waitNs);
+                siteObject["hold_us"]   = toUs(counts.holdNs);
+                siteObject["blocked_others_us"] = toUs(counts.blockingNs);
+                siteArray.append(siteObject);
+            }
+            lock["sites"] = siteArray;
+            locks.append(lock);
+        }
+    }
+
+    std::sort(locks.begin(), locks.end(),
+              [](const QJsonObject &a, const QJsonObject &b) {
+                  return a.value("total_wait_us").toDouble()
+                         > b.value("total_wait_us").toDouble();
+              });
+
+    QJsonObject result;
+    result["enabled"] = isEnabled();
+    result["window_ms"] =
+        static_cast<double>(QDateTime::currentMSecsSinceEpoch() - resetAtMs);
+    QJsonArray lockArray;
+    for (const QJsonObject &lock : locks)
+        lockArray.append(lock);
+    result["locks"] = lockArray;
+    return result;
+}
+
+LockStats *LockProfiler::statsFor(const char *name)
+{
+    std::lock_guard<std::mutex> registryLock(m_registryMutex);
+    std::unique_ptr<LockStats> &stats = m_stats[name];
+    if (!stats)
+        stats = std::make_unique<LockStats>();
+    return stats.get();
+}
+
+void LockProfiler::recordAcquire(LockStats *stats, const char *site,
+                                 const char *holder, bool contended,
+                                 qint64 waitNs)
+{
+    stats->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    stats->histogram[waitBucket(waitNs)].fetch_add(1,
+                                                   std::memory_order_relaxed);
+    if (contended)
+    {
+        stats->contended.fetch_add(1, std::memory_order_relaxed);
+        stats->waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+        qint64 previous = stats->maxWaitNs.load(std::memory_order_relaxed);
+        while (previous < waitNs
+               && !stats->maxWaitNs.compare_exchange_weak(
+                   previous, waitNs, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::lock_guard<std::mutex> sitesLock(stats->sitesMutex);
+    SiteStats &counts = stats->sites[site];
+    ++counts.acquisitions;
+    if (contended)
+    {
+        ++counts.contended;
+        counts.waitNs += waitNs;
+        if (holder)
+            stats->sites[holder].blockingNs += waitNs;
+    }
+}
+
+void LockProfiler::recordRelease(LockStats *stats, const char *site,
+                                 qint64 holdNs)
+{
+    std::lock_guard<std::mutex> sitesLock(stats->sitesMutex);
+    stats->sites[site].holdNs += holdNs;
+}
+
+ProfiledMutex::ProfiledMutex(const char *name)
+    : m_stats(LockProfiler::getInstance()->statsFor(name))
+{
+}
+
+void ProfiledMutex::lock(const char *site)
+{
+    if (!LockProfiler::isEnabled())
+    {
+        m_mutex.lock();
+        return;
+    }
+
+    bool        contended = false;
+    qint64      waitNs    = 0;
+    const char *holder    = nullptr;
+    if (!m_mutex.tryLock())
+    {
+        // The holder may change before we get in; blame the one we saw
+        contended          = true;
+        holder             = m_holder.load(std::memory_order_relaxed);
+        const qint64 start = nowNs();
+        m_mutex.lock();
+        waitNs = nowNs() - start;
+    }
+    m_holder.store(site, std::memory_order_relaxed);
+    m_acquiredNs = nowNs();
+    LockProfiler::recordAcquire(m_stats, site, holder, contended, waitNs);
+}
+
+void ProfiledMutex::unlock()
+{
+    // Null when profiling was off at lock time
+    const char *site = m_holder.load(std::memory_order_relaxed);
+    if (site)
+    {
+        m_holder.store(nullptr, std::memory_order_relaxed);
+        LockProfiler::recordRelease(m_stats, site, nowNs() - m_acquiredNs);
+    }
+    m_mutex.unlock();
+}
+
+ProfiledReadWriteLock::ProfiledReadWriteLock(const char *name)
+    : m_stats(LockProfiler::getInstance()->statsFor(name))
+{
+}
+
+void ProfiledReadWriteLock::lockForRead(const char *site)
+{
+    if (!LockProfiler::isEnabled())
+    {
+        m_lock.lockForRead();
+        return;
+    }
+
+    bool        contended = false;
+    qint64      waitNs    = 0;
+    const char *holder    = nullptr;
+    if (!m_lock.tryLockForRead())
+    {
+        contended          = true;
+        holder             = m_writer.load(std::memory_order_relaxed);
+        const qint64 start = nowNs();
+        m_lock.lockForRead();
+        waitNs = nowNs() - start;
+    }
+    LockProfiler::recordAcquire(m_stats, site, holder, contended, waitNs);
+}
+
+void ProfiledReadWriteLock::lockForWrite(const char *site)
+{
+    if (!LockProfiler::isEnabled())
+    {
+        m_lock.lockForWrite();
+        return;
+    }
+
+    bool        contended = false;
+    qint64      waitNs    = 0;
+    const char *holder    = nullptr;
+    if (!m_lock.tryLockForWrite())
+    {
+        contended          = true;
+        holder             = m_writer.load(std::memory_order_relaxed);
+        const qint64 start = nowNs();
+        m_lock.lockForWrite();
+        waitNs = nowNs() - start;
+    }
+    m_writer.store(site, std::memory_order_relaxed);
+    m_acquiredNs = nowNs();
+    LockProfiler::recordAcquire(m_stats, site, holder, contended, waitNs);
+}
+
+void ProfiledReadWriteLock::unlock()
+{
+    // Readers never share the lock with a writer, so a set writer site
+    // means the caller is that writer
+    const char *site = m_writer.load(std::memory_order_relaxed);
+    if (site)
+    {
+        m_writer.store(nullptr, std::memory_order_relaxed);
+        LockProfiler::recordRelease(m_stats, site, nowNs() - m_acquiredNs);
+    }
+    m_lock.unlock();
+}
+
+} // namespace TerminalSim
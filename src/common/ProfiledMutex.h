@@ -0,0 +1,160 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QtGlobal>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Name of the function a lock is taken from. Used as a default argument,
+// so it names the caller rather than the lock.
+#if defined(__GNUC__) || defined(__clang__)                                    \
+    || (defined(_MSC_VER) && _MSC_VER >= 1926)
+#define TERMINALSIM_LOCK_SITE __builtin_FUNCTION()
+#else
+#define TERMINALSIM_LOCK_SITE "unknown"
+#endif
+
+namespace TerminalSim {
+
+class LockStats;
+
+/**
+ * @brief Process-wide switch and report for lock contention profiling
+ *
+ * Locks that share a name, such as the lock of every Terminal, are
+ * reported together. For each name the profiler counts acquisitions and
+ * how many had to wait, keeps a histogram of wait times, and breaks both
+ * down by the function that took the lock. It also records, per function,
+ * how long it held the lock and how long others waited while it did.
+ *
+ * Disabled by default. A disabled lock costs one relaxed atomic load on
+ * top of the plain mutex; an enabled one also reads the clock and takes a
+ * short per-name lock to update the call-site table.
+ */
+class LockProfiler
+{
+public:
+    static LockProfiler *getInstance();
+
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Clear all counters; locks stay registered
+     */
+    void reset();
+
+    /**
+     * @brief Counters of every lock name, most waited-on first
+     */
+    QJsonObject report() const;
+
+private:
+    friend class ProfiledMutex;
+    friend class ProfiledReadWriteLock;
+
+    LockProfiler();
+    ~LockProfiler();
+    LockProfiler(const LockProfiler &)            = delete;
+    LockProfiler &operator=(const LockProfiler &) = delete;
+
+    // Counters shared by every lock with this name; never freed
+    LockStats *statsFor(const char *name);
+
+    static void recordAcquire(LockStats *stats, const char *site,
+                              const char *holder, bool contended,
+                              qint64 waitNs);
+    static void recordRelease(LockStats *stats, const char *site,
+                              qint64 holdNs);
+
+    static std::atomic<bool> s_enabled;
+
+    mutable std::mutex                                 m_registryMutex;
+    std::map<std::string, std::unique_ptr<LockStats>> m_stats;
+    qint64                                             m_resetAtMs;
+};
+
+/**
+ * @brief QMutex that reports to LockProfiler when profiling is on
+ *
+ * Lock it through ProfiledMutexLocker so the caller is recorded as the
+ * call site.
+ */
+class ProfiledMutex
+{
+public:
+    /**
+     * @param name Name the lock is reported under, usually Class::member
+     */
+    explicit ProfiledMutex(const char *name);
+
+    ProfiledMutex(const ProfiledMutex &)            = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock(const char *site = TERMINALSIM_LOCK_SITE);
+    void unlock();
+
+private:
+    QMutex                   m_mutex;
+    LockStats               *m_stats;
+    std::atomic<const char *> m_holder{nullptr}; // Set while profiled
+    qint64                   m_acquiredNs = 0;   // Written by the holder
+};
+
+/**
+ * @brief Scoped lock of a ProfiledMutex, like QMutexLocker
+ */
+class ProfiledMutexLocker
+{
+public:
+    explicit ProfiledMutexLocker(ProfiledMutex *mutex,
+                                 const char    *site = TERMINALSIM_LOCK_SITE)
+        : m_mutex(mutex)
+    {
+        m_mutex->lock(site);
+    }
+    ~ProfiledMutexLocker() { m_mutex->unlock(); }
+
+    ProfiledMutexLocker(const ProfiledMutexLocker &)            = delete;
+    ProfiledMutexLocker &operator=(const ProfiledMutexLocker &) = delete;
+
+private:
+    ProfiledMutex *m_mutex;
+};
+
+/**
+ * @brief QReadWriteLock that reports to LockProfiler when profiling is on
+ *
+ * Waits are recorded for readers and writers alike. Hold times and the
+ * holder blamed for a wait are tracked for writers only, since any
+ * number of readers may hold the lock at once.
+ */
+class ProfiledReadWriteLock
+{
+public:
+    explicit ProfiledReadWriteLock(const char *name);
+
+    ProfiledReadWriteLock(const ProfiledReadWriteLock &)            = delete;
+    ProfiledReadWriteLock &operator=(const ProfiledReadWriteLock &) = delete;
+
+    void lockForRead(const char *site = TERMINALSIM_LOCK_SITE);
+    void lockForWrite(const char *site = TERMINALSIM_LOCK_SITE);
+    void unlock();
+
+private:
+    QReadWriteLock           m_lock;
+    LockStats               *m_stats;
+    std::atomic<const char *> m_writer{nullptr}; // Set while profiled
+    qint64                   m_acquiredNs = 0;   // Written by the writer
+};
+
+} // namespace TerminalSim
@@ -0,0 +1,229 @@
+#include "WorkStealingPool.h"
+
+#include <QThread>
+#include <algorithm>
+
+namespace TerminalSim {
+
+namespace
+{
+
+// Pool and deque of the worker running on this thread, if any
+thread_local const WorkStealingPool *t_pool  = nullptr;
+thread_local int                     t_queue = -1;
+
+// Chunks per worker in parallelFor, so that stealing can even out
+// unequal tasks
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = qMax(1, QThread::idealThreadCount());
+
+    for (int i = 0; i <= threadCount; ++i)
+        m_queues.push_back(std::make_unique<TaskQueue>());
+
+    m_threads.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+        m_threads.emplace_back([this, i]() { workerLoop(i); });
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &thread : m_threads)
+        thread.join();
+}
+
+void WorkStealingPool::parallelFor(size_t                             count,
+                                   const std::function<void(size_t)> &task)
+{
+    if (count == 0)
+        return;
+    if (count == 1)
+    {
+        task(0);
+        return;
+    }
+
+    const size_t chunks =
+        std::min(count, static_cast<size_t>(threadCount()) * CHUNKS_PER_THREAD);
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+
+    TaskGroup group(this);
+    for (size_t first = 0; first < count; first += chunkSize)
+    {
+        const size_t last = std::min(count, first + chunkSize);
+        group.run([&task, first, last]() {
+            for (size_t i = first; i < last; ++i)
+                task(i);
+        });
+    }
+    group.wait();
+}
+
+WorkStealingPool *WorkStealingPool::globalInstance()
+{
+    static WorkStealingPool instance;
+    return &instance;
+}
+
+void WorkStealingPool::submit(TaskGroup *group, std::function<void()> task)
+{
+    const int index = t_pool == this ? t_queue : threadCount();
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(Task{group, std::move(task)});
+    }
+    group->m_queued.fetch_add(1, std::memory_order_release);
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    // Idle workers and the group's waiter may all be asleep; taking the
+    // lock orders this with their check of the counts
+    wakeAll();
+}
+
+bool WorkStealingPool::runPendingTask(const TaskGroup *group)
+{
+    const int queueCount = static_cast<int>(m_queues.size());
+    const int own        = t_pool == this ? t_queue : threadCount();
+
+    std::optional<Task> task;
+    for (int offset = 0; offset < queueCount && !task; ++offset)
+    {
+        TaskQueue &queue = *m_queues[(own + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        // Newest own task first, for locality; oldest when stealing, as
+        // it tends to be the biggest
+        const auto matches = [group](const Task &candidate) {
+            return !group || candidate.group == group;
+        };
+        if (offset == 0)
+        {
+            const auto it = std::find_if(queue.tasks.rbegin(),
+                                         queue.tasks.rend(), matches);
+            if (it == queue.tasks.rend())
+                continue;
+            task = std::move(*it);
+            queue.tasks.erase(std::next(it).base());
+        }
+        else
+        {
+            const auto it = std::find_if(queue.tasks.begin(),
+                                         queue.tasks.end(), matches);
+            if (it == queue.tasks.end())
+                continue;
+            task = std::move(*it);
+            queue.tasks.erase(it);
+        }
+    }
+    if (!task)
+        return false;
+
+    task->group->m_queued.fetch_sub(1, std::memory_order_relaxed);
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    task->run();
+    return true;
+}
+
+void WorkStealingPool::waitForWork(const std::function<bool()> &ready)
+{
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wake.wait(lock, [this, &ready]() { return m_stopping || ready(); });
+}
+
+void WorkStealingPool::wakeAll()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wake.notify_all();
+}
+
+void WorkStealingPool::workerLoop(int index)
+{
+    t_pool  = this;
+    t_queue = index;
+
+    for (;;)
+    {
+        if (runPendingTask(nullptr))
+            continue;
+
+        waitForWork([this]() {
+            return m_queued.load(std::memory_order_acquire) > 0;
+        });
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        if (m_stopping)
+            return;
+    }
+}
+
+TaskGroup::TaskGroup(WorkStealingPool *pool)
+    : m_pool(pool)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    waitForTasks();
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_pool->submit(this, [this, task = std::move(task)]() {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            if (!m_error)
+                m_error = std::current_exception();
+        }
+
+        // The group may be gone once the count reaches zero
+        WorkStealingPool *pool = m_pool;
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            pool->wakeAll();
+    });
+}
+
+void TaskGroup::wait()
+{
+    waitForTasks();
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_errorMutex);
+        std::swap(error, m_error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void TaskGroup::waitForTasks()
+{
+    while (m_pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!m_pool->runPendingTask(this))
+        {
+            m_pool->waitForWork([this]() {
+                return m_queued.load(std::memory_order_acquire) > 0
+                       || m_pending.load(std::memory_order_acquire) == 0;
+            });
+        }
+    }
+}
+
+} // namespace TerminalSim
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <QList>
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace TerminalSim {
+
+class TaskGroup;
+
+/**
+ * @brief Work-stealing thread pool shared by the parallel parts of a
+ *        command
+ *
+ * Every worker owns a deque. It pushes and pops its own tasks at the back,
+ * and idle workers steal from the front of the others. Threads outside
+ * the pool submit through a shared injection deque.
+ *
+ * A thread waiting on a TaskGroup runs the group's queued tasks rather
+ * than blocking, so nested parallel loops run on the same workers and
+ * cannot deadlock however deeply they nest. It never picks up another
+ * group's tasks, so waiting while holding a lock is safe as long as the
+ * group's own tasks do not take it.
+ *
+ * TerminalGraphServer owns the pool its graphs use; graphs without one,
+ * such as embedded engines and tests, use globalInstance().
+ */
+class WorkStealingPool
+{
+public:
+    /**
+     * @param threadCount Worker threads; 0 or less uses one per core
+     */
+    explicit WorkStealingPool(int threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &)            = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    int threadCount() const { return static_cast<int>(m_threads.size()); }
+
+    /**
+     * @brief Run task(0) .. task(count - 1) and wait for all of them
+     *
+     * Indexes are handed out in contiguous chunks, a few per worker, and
+     * the caller works on them too.
+     * @throws The first exception a task threw, once all have finished
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+    /**
+     * @brief Apply a function to every item of a random-access container
+     * @return Results in item order
+     */
+    template <typename Result, typename Container, typename Function>
+    QList<Result> mapped(const Container &items, Function function)
+    {
+        std::vector<std::optional<Result>> outcomes(
+            static_cast<size_t>(items.size()));
+        parallelFor(outcomes.size(), [&](size_t i) {
+            outcomes[i].emplace(function(items[static_cast<qsizetype>(i)]));
+        });
+
+        QList<Result> results;
+        results.reserve(static_cast<qsizetype>(outcomes.size()));
+        for (std::optional<Result> &outcome : outcomes)
+            results.append(std::move(*outcome));
+        return results;
+    }
+
+    /**
+     * @brief Process-wide pool with one worker per core
+     */
+    static WorkStealingPool *globalInstance();
+
+private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        TaskGroup            *group;
+        std::function<void()> run;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    void submit(TaskGroup *group, std::function<void()> task);
+    bool runPendingTask(const TaskGroup *group);
+    void waitForWork(const std::function<bool()> &ready);
+    void wakeAll();
+    void workerLoop(int index);
+
+    // One deque per worker, then the injection deque
+    std::vector<std::unique_ptr<TaskQueue>> m_queues;
+    std::vector<std::thread>                m_threads;
+
+    std::atomic<int>        m_queued{0};
+    std::mutex              m_sleepMutex;
+    std::condition_variable m_wake;
+    bool                    m_stopping = false;
+};
+
+/**
+ * @brief Set of tasks run on a WorkStealingPool and waited for together
+ *
+ * Tasks may start groups of their own.
+ */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(WorkStealingPool *pool);
+
+    /**
+     * @brief Waits for unfinished tasks; their exceptions are dropped
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup &)            = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    void run(std::function<void()> task);
+
+    /**
+     * @brief Wait for every task run so far, running queued ones meanwhile
+     * @throws The first exception a task threw
+     */
+    void wait();
+
+private:
+    friend class WorkStealingPool;
+
+    void waitForTasks();
+
+    WorkStealingPool  *m_pool;
+    std::atomic<int>   m_pending{0}; // Run but not finished
+    std::atomic<int>   m_queued{0};  // Still waiting in a deque
+    std::mutex         m_errorMutex;
+    std::exception_ptr m_error;
+};
+
+} // namespace TerminalSim
@@ -1,7 +1,9 @@
 #include "common.h"
 
 #include <QMetaEnum>
+#include <QRegularExpression>
 #include <QString>
+#include <QStringList>
 #include <stdexcept>
 #include "LogCategories.h"
 
@@ -75,6 +77,39 @@ TransportationMode EnumUtils::stringToTransportationMode(const QString& str) {
     return parseTransportationMode(str);
 }
 
+TransportationModeMask
+EnumUtils::parseTransportationModeMask(const QString& str) {
+    // Accepts "Truck|Train", "truck,train" or any single mode
+    TransportationModeMask mask;
+    const QStringList parts =
+        str.split(QRegularExpression(QStringLiteral("[|,+]")));
+    for (const QString &part : parts) {
+        if (part.trimmed().isEmpty())
+            continue;
+        mask = mask | parseTransportationMode(part);
+    }
+
+    if (mask.isEmpty()) {
+        qCWarning(lcCommon) << "Empty TransportationMode set:" << str;
+        throw std::invalid_argument(
+            QString("Empty TransportationMode set: %1").arg(str).toStdString());
+    }
+    return mask;
+}
+
+QString EnumUtils::transportationModeMaskToString(TransportationModeMask mask) {
+    if (mask.isAll())
+        return transportationModeToString(TransportationMode::Any);
+
+    QStringList names;
+    for (int mode = 0; mode < TransportationModeMask::ModeCount; ++mode) {
+        if (mask.contains(static_cast<TransportationMode>(mode)))
+            names.append(transportationModeToString(
+                static_cast<TransportationMode>(mode)));
+    }
+    return names.join(QLatin1Char('|'));
+}
+
 QString EnumUtils::terminalInterfaceToString(TerminalInterface interface) {
     const QMetaEnum metaEnum = getTerminalInterfaceEnum();
     return QString(metaEnum.valueToKey(static_cast<int>(interface)));
@@ -27,6 +27,70 @@ enum class TransportationMode
 };
 Q_ENUM_NS(TransportationMode)
 
+/**
+ * @brief Set of concrete transportation modes, one bit per mode
+ *
+ * Converts implicitly from a single TransportationMode so existing
+ * single-mode call sites keep working; Any converts to the full set.
+ */
+class TransportationModeMask {
+public:
+    static constexpr int ModeCount = 3;
+
+    constexpr TransportationModeMask() = default;
+    constexpr TransportationModeMask(TransportationMode mode)
+        : m_bits(mode == TransportationMode::Any
+                     ? AllBits
+                     : 1u << static_cast<int>(mode)) {}
+
+    static constexpr TransportationModeMask all() {
+        return fromBits(AllBits);
+    }
+    static constexpr TransportationModeMask fromBits(unsigned int bits) {
+        TransportationModeMask mask;
+        mask.m_bits = bits & AllBits;
+        return mask;
+    }
+
+    constexpr unsigned int bits() const { return m_bits; }
+    constexpr bool isEmpty() const { return m_bits == 0; }
+    constexpr bool isAll() const { return m_bits == AllBits; }
+    constexpr bool contains(TransportationMode mode) const {
+        return mode == TransportationMode::Any
+                   ? isAll()
+                   : (m_bits & (1u << static_cast<int>(mode))) != 0;
+    }
+
+    /**
+     * @brief The single mode this mask selects, Any for the full set, or
+     * std::nullopt for an empty or mixed set
+     */
+    constexpr std::optional<TransportationMode> singleMode() const {
+        if (isAll())
+            return TransportationMode::Any;
+        for (int mode = 0; mode < ModeCount; ++mode) {
+            if (m_bits == (1u << mode))
+                return static_cast<TransportationMode>(mode);
+        }
+        return std::nullopt;
+    }
+
+    constexpr TransportationModeMask
+    operator|(TransportationModeMask other) const {
+        return fromBits(m_bits | other.m_bits);
+    }
+    constexpr bool operator==(TransportationModeMask other) const {
+        return m_bits == other.m_bits;
+    }
+    constexpr bool operator!=(TransportationModeMask other) const {
+        return m_bits != other.m_bits;
+    }
+
+private:
+    static constexpr unsigned int AllBits = (1u << ModeCount) - 1;
+    unsigned int m_bits = 0;
+};
+
 /**
  * @brief Defines interfaces available at terminals for operations
  */
@@ -52,6 +116,9 @@ public:
     tryParseTransportationMode(const QString& str);
     static TransportationMode parseTransportationMode(const QString& str);
     static TransportationMode stringToTransportationMode(const QString& str);
+    static TransportationModeMask
+    parseTransportationModeMask(const QString& str);
+    static QString transportationModeMaskToString(TransportationModeMask mask);
 
     static QString terminalInterfaceToString(TerminalInterface interface);
     static std::optional<TerminalInterface>
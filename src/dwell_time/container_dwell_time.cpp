@@ -19,8 +19,9 @@ std::mt19937& ContainerDwellTime::getGenerator() {
     return generator;
 }
 
-double
-ContainerDwellTime::gammaDistributionDwellTime(double shape, double scale) {
+namespace {
+
+double gammaDwellTime(double shape, double scale, std::mt19937& generator) {
     if (shape <= 0.0 || scale <= 0.0) {
         qCWarning(lcDwellTime) << "Invalid parameters for gamma distribution: shape ="
                                << shape << ", scale =" << scale;
@@ -29,10 +30,10 @@ ContainerDwellTime::gammaDistributionDwellTime(double shape, double scale) {
     }
     
     std::gamma_distribution<double> distribution(shape, scale);
-    return distribution(getGenerator());
+    return distribution(generator);
 }
 
-double ContainerDwellTime::exponentialDistributionDwellTime(double scale) {
+double exponentialDwellTime(double scale, std::mt19937& generator) {
     if (scale <= 0.0) {
         qCWarning(lcDwellTime) << "Invalid parameter for exponential "
                                   "distribution: scale ="
@@ -42,11 +43,10 @@ double ContainerDwellTime::exponentialDistributionDwellTime(double scale) {
     }
     
     std::exponential_distribution<double> distribution(1.0 / scale);
-    return distribution(getGenerator());
+    return distribution(generator);
 }
 
-double
-ContainerDwellTime::normalDistributionDwellTime(double mean, double stdDev) {
+double normalDwellTime(double mean, double stdDev, std::mt19937& generator) {
     if (stdDev <= 0.0) {
         qCWarning(lcDwellTime) << "Invalid parameter for normal distribution: stdDev ="
                                << stdDev;
@@ -59,15 +59,14 @@ ContainerDwellTime::normalDistributionDwellTime(double mean, double stdDev) {
     // Ensure dwell time is non-negative (truncate distribution at zero)
     double result;
     do {
-        result = distribution(getGenerator());
+        result = distribution(generator);
     } while (result < 0.0);
     
     return result;
 }
 
-double
-ContainerDwellTime::lognormalDistributionDwellTime(double mean,
-                                                   double sigma) {
+double lognormalDwellTime(double mean, double sigma,
+                          std::mt19937& generator) {
     if (sigma <= 0.0) {
         qCWarning(lcDwellTime) << "Invalid parameter for lognormal distribution: sigma ="
                                << sigma;
@@ -76,13 +75,56 @@ ContainerDwellTime::lognormalDistributionDwellTime(double mean,
     }
     
     std::lognormal_distribution<double> distribution(mean, sigma);
-    return distribution(getGenerator());
+    return distribution(generator);
+}
+
+} // namespace
+
+double
+ContainerDwellTime::gammaDistributionDwellTime(double shape, double scale) {
+    return gammaDwellTime(shape, scale, getGenerator());
+}
+
+double ContainerDwellTime::exponentialDistributionDwellTime(double scale) {
+    return exponentialDwellTime(scale, getGenerator());
+}
+
+double
+ContainerDwellTime::normalDistributionDwellTime(double mean, double stdDev) {
+    return normalDwellTime(mean, stdDev, getGenerator());
+}
+
+double
+ContainerDwellTime::lognormalDistributionDwellTime(double mean,
+                                                   double sigma) {
+    return lognormalDwellTime(mean, sigma, getGenerator());
 }
 
 double
 ContainerDwellTime::getDepartureTime(double arrivalTime,
                                      const QString& method,
                                      const QVariantMap& params) {
+    const double dwellTime = sampleDwellTime(method, params, getGenerator());
+
+    // Calculate departure time
+    double departureTime = arrivalTime + dwellTime;
+    
+    qCDebug(lcDwellTime) << "Container dwell time calculated:"
+                        << dwellTime/3600.0
+                        << "hours using method:"
+                        << method
+                        << "- Arrival time:"
+                        << arrivalTime
+                        << "- Departure time:"
+                        << departureTime;
+    
+    return departureTime;
+}
+
+double
+ContainerDwellTime::sampleDwellTime(const QString& method,
+                                    const QVariantMap& params,
+                                    std::mt19937& generator) {
     // Default values (about 2 days)
     const double defaultGammaShape =
         2.0;
@@ -109,47 +151,35 @@ ContainerDwellTime::getDepartureTime(double arrivalTime,
         double shape = params.value("shape", defaultGammaShape).toDouble();
         double scale = params.value("scale", defaultGammaScale).toDouble();
         
-        dwellTime = gammaDistributionDwellTime(shape, scale);
+        dwellTime = gammaDwellTime(shape, scale, generator);
         
     } else if (method.compare("exponential", Qt::CaseInsensitive) == 0) {
         double scale = params.value("scale", defaultExpScale).toDouble();
         
-        dwellTime = exponentialDistributionDwellTime(scale);
+        dwellTime = exponentialDwellTime(scale, generator);
         
     } else if (method.compare("normal", Qt::CaseInsensitive) == 0) {
         double mean = params.value("mean", defaultNormalMean).toDouble();
         double stdDev = params.value("std_dev", defaultNormalStdDev).toDouble();
         
-        dwellTime = normalDistributionDwellTime(mean, stdDev);
+        dwellTime = normalDwellTime(mean, stdDev, generator);
         
     } else if (method.compare("lognormal", Qt::CaseInsensitive) == 0) {
         double mean = params.value("mean", defaultLognormalMean).toDouble();
         double sigma = params.value("sigma", defaultLognormalSigma).toDouble();
         
-        dwellTime = lognormalDistributionDwellTime(mean, sigma);
+        dwellTime = lognormalDwellTime(mean, sigma, generator);
         
     } else {
         qCWarning(lcDwellTime) << "Invalid distribution method:"
                                << method
                                << "- defaulting to gamma distribution";
         
-        dwellTime =
-            gammaDistributionDwellTime(defaultGammaShape, defaultGammaScale);
+        dwellTime = gammaDwellTime(defaultGammaShape, defaultGammaScale,
+                                   generator);
     }
     
-    // Calculate departure time
-    double departureTime = arrivalTime + dwellTime;
-    
-    qCDebug(lcDwellTime) << "Container dwell time calculated:"
-                        << dwellTime/3600.0
-                        << "hours using method:"
-                        << method
-                        << "- Arrival time:"
-                        << arrivalTime
-                        << "- Departure time:"
-                        << departureTime;
-    
-    return departureTime;
+    return dwellTime;
 }
 
 } // namespace TerminalSim
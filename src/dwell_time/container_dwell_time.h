@@ -54,6 +54,21 @@ public:
     static double getDepartureTime(double arrivalTime, const QString& method, 
                                   const QVariantMap& params);
 
+    /**
+     * @brief Draws a dwell time from a caller-owned generator
+     *
+     * Uses the same methods and defaults as getDepartureTime() but leaves
+     * the shared generator alone, so threads with their own generators
+     * get independent, reproducible streams.
+     * @param method Distribution method
+     * @param params Additional parameters for the distribution
+     * @param generator Random engine to draw from
+     * @return Dwell time in seconds
+     */
+    static double sampleDwellTime(const QString& method,
+                                  const QVariantMap& params,
+                                  std::mt19937& generator);
+
 private:
     // Random number generators
     static std::mt19937& getGenerator();
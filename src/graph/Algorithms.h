@@ -1,10 +1,18 @@
 #pragma once
 
+#include "ClosureOverlay.h"
 #include "Graph.h"
+#include "SearchArena.h"
 #include "common/LogCategories.h"
 #include <algorithm>
+#include <functional>
 #include <limits>
+#include <map>
+#include <memory_resource>
+#include <optional>
 #include <queue>
+#include <set>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -21,31 +29,80 @@ public:
     using EdgePath  = std::vector<EdgeType>;
     using EdgePathInfo =
         std::pair<EdgePath, WeightType>; // Path of edges and total weight
+    using ClosureOverlayType = ClosureOverlay<VertexIdType>;
+
+    /**
+     * @brief Cost of passing through a vertex between two edges
+     *
+     * Called with arrivalMode Any at the origin and departureMode Any at the
+     * destination, so callers can price origin and destination handling
+     * separately from mode changes.
+     */
+    using TransferCostFunction = std::function<WeightType(
+        const VertexIdType &vertex, TerminalSim::TransportationMode arrivalMode,
+        TerminalSim::TransportationMode departureMode)>;
+
+    /**
+     * @brief Amount of a resource (e.g. travel time) an edge consumes
+     */
+    using EdgeResourceFunction = std::function<WeightType(const EdgeType &)>;
+
+    /**
+     * @brief Run task(0) .. task(count - 1), possibly concurrently
+     */
+    using ParallelFor =
+        std::function<void(size_t count,
+                           const std::function<void(size_t)> &task)>;
+
+    /**
+     * @brief Limits for constrainedShortestPath(); unset limits are ignored
+     */
+    struct PathConstraints
+    {
+        std::optional<size_t>     maxHops;      ///< Edges on the path
+        std::optional<size_t>     maxTransfers; ///< Mode changes on the path
+        std::optional<WeightType> maxResource;  ///< Sum of edgeResource
+    };
 
     /**
      * @brief Find the shortest path using Dijkstra's algorithm
      * @param graph Input graph
      * @param source Source vertex id
      * @param target Target vertex id
-     * @param mode Filter edges by transportation mode (Any by default)
+     * @param modes Transportation modes whose edges may be used (Any by
+     * default)
+     * @param closures Closed vertices and edges to avoid (none by default)
      * @return Path information or std::nullopt if no path exists
      */
     static std::optional<EdgePathInfo>
     dijkstraShortestPath(const GraphType &graph, const VertexIdType &source,
                          const VertexIdType             &target,
-                         TerminalSim::TransportationMode mode =
-                             TerminalSim::TransportationMode::Any)
+                         TerminalSim::TransportationModeMask modes =
+                             TerminalSim::TransportationMode::Any,
+                         const ClosureOverlayType *closures = nullptr)
     {
+        // Bookkeeping lives in the arena and is released on return
+        SearchArena arena;
+
         // Priority queue for vertices to visit (weight, vertex)
         using QueueItem = std::pair<WeightType, VertexIdType>;
-        std::priority_queue<QueueItem, std::vector<QueueItem>,
+        std::priority_queue<QueueItem, std::pmr::vector<QueueItem>,
                             std::greater<QueueItem>>
-            pq;
+            pq(std::greater<QueueItem>(),
+               std::pmr::vector<QueueItem>(arena.resource()));
 
         // Maps for distances and previous edges (not just vertices)
-        std::unordered_map<VertexIdType, WeightType> distance;
-        std::unordered_map<VertexIdType, EdgeType>   previousEdge;
-        std::unordered_set<VertexIdType>             visited;
+        std::pmr::unordered_map<VertexIdType, WeightType> distance(
+            arena.resource());
+        std::pmr::unordered_map<VertexIdType, EdgeType> previousEdge(
+            arena.resource());
+        std::pmr::unordered_set<VertexIdType> visited(arena.resource());
+
+        // Sized up front: buckets dropped by a rehash are not reclaimed
+        // until the arena goes
+        distance.reserve(graph.vertices().size());
+        previousEdge.reserve(graph.vertices().size());
+        visited.reserve(graph.vertices().size());
 
         // Initialize distances with infinity
         const WeightType infinity = std::numeric_limits<WeightType>::max();
@@ -86,17 +143,11 @@ public:
                 break;
             }
 
-            // Process outgoing edges
-            auto edges = graph.outgoingEdges(current);
-            for (const auto &edge : edges)
-            {
-                // Skip edges that don't match the transportation mode (if
-                // specified)
-                if (mode != TerminalSim::TransportationMode::Any
-                    && edge.mode() != mode
-                    && edge.mode() != TerminalSim::TransportationMode::Any)
+            // Process outgoing edges in the requested mode layers
+            graph.forEachOutgoingEdge(current, modes, [&](const EdgeType &edge) {
+                if (closures != nullptr && closures->blocks(edge))
                 {
-                    continue;
+                    return;
                 }
 
                 // Relax the edge
@@ -110,7 +161,7 @@ public:
                         edge; // Store the edge, not just the vertex
                     pq.push(std::make_pair(newDist, next));
                 }
-            }
+            });
         }
 
         // If we didn't reach the target, no path exists
@@ -136,25 +187,116 @@ public:
         return std::make_pair(edgePath, distance[target]);
     }
 
+    /**
+     * @brief All vertices whose distance from a source is within a budget
+     *
+     * Dijkstra that only tracks vertices it touches and stops as soon as the
+     * nearest unsettled vertex exceeds the budget, so the work is bounded by
+     * the reachable region rather than the whole graph.
+     * @param graph Input graph
+     * @param source Source vertex id
+     * @param budget Largest distance to report (inclusive)
+     * @param edgeLength Length of an edge; edge weight when not given
+     * @param modes Transportation modes whose edges may be used (Any by
+     * default)
+     * @param closures Closed vertices and edges to avoid (none by default)
+     * @return Reachable vertices other than the source with their distance,
+     * in non-decreasing distance order
+     */
+    static std::vector<std::pair<VertexIdType, WeightType>>
+    reachableWithin(const GraphType &graph, const VertexIdType &source,
+                    WeightType                          budget,
+                    const EdgeResourceFunction         &edgeLength = {},
+                    TerminalSim::TransportationModeMask modes =
+                        TerminalSim::TransportationMode::Any,
+                    const ClosureOverlayType *closures = nullptr)
+    {
+        std::vector<std::pair<VertexIdType, WeightType>> reachable;
+        if (graph.vertices().count(source) == 0 || budget < WeightType(0)
+            || (closures != nullptr && closures->isVertexClosed(source)))
+        {
+            return reachable;
+        }
+
+        SearchArena arena;
+        using QueueItem = std::pair<WeightType, VertexIdType>;
+        std::priority_queue<QueueItem, std::pmr::vector<QueueItem>,
+                            std::greater<QueueItem>>
+            pq(std::greater<QueueItem>(),
+               std::pmr::vector<QueueItem>(arena.resource()));
+        std::pmr::unordered_map<VertexIdType, WeightType> distance(
+            arena.resource());
+        std::pmr::unordered_set<VertexIdType> settled(arena.resource());
+
+        distance[source] = WeightType(0);
+        pq.push(std::make_pair(WeightType(0), source));
+
+        while (!pq.empty())
+        {
+            auto [dist, current] = pq.top();
+            pq.pop();
+
+            if (dist > budget)
+            {
+                break;
+            }
+            if (!settled.insert(current).second)
+            {
+                continue;
+            }
+            if (current != source)
+            {
+                reachable.emplace_back(current, dist);
+            }
+
+            graph.forEachOutgoingEdge(current, modes, [&](const EdgeType &edge) {
+                if (closures != nullptr && closures->blocks(edge))
+                {
+                    return;
+                }
+
+                const WeightType newDist =
+                    dist + (edgeLength ? edgeLength(edge) : edge.weight());
+                if (newDist > budget)
+                {
+                    return;
+                }
+
+                auto it = distance.find(edge.target());
+                if (it == distance.end() || newDist < it->second)
+                {
+                    distance[edge.target()] = newDist;
+                    pq.push(std::make_pair(newDist, edge.target()));
+                }
+            });
+        }
+
+        return reachable;
+    }
+
     /**
      * @brief Find the k shortest paths using Yen's algorithm
      * @param graph Input graph
      * @param source Source vertex id
      * @param target Target vertex id
      * @param k Number of shortest paths to find
-     * @param mode Filter edges by transportation mode (Any by default)
+     * @param modes Transportation modes whose edges may be used (Any by
+     * default)
+     * @param closures Closed vertices and edges to avoid (none by default)
      * @return Vector of path information (up to k paths)
      */
     static std::vector<EdgePathInfo>
     kShortestPaths(const GraphType &graph, const VertexIdType &source,
                    const VertexIdType &target, size_t k,
-                   TerminalSim::TransportationMode mode =
-                       TerminalSim::TransportationMode::Any)
+                   TerminalSim::TransportationModeMask modes =
+                       TerminalSim::TransportationMode::Any,
+                   const ClosureOverlayType *closures = nullptr)
     {
         std::vector<EdgePathInfo> kPaths;
 
         // Find the first shortest path using Dijkstra
-        auto firstPath = dijkstraShortestPath(graph, source, target, mode);
+        auto firstPath =
+            dijkstraShortestPath(graph, source, target, modes, closures);
         if (!firstPath.has_value())
         {
             qCDebug(lcGraph) << "No path exists from" << source << "to" << target;
@@ -191,7 +333,8 @@ public:
 
                 // Find the shortest path from spur node to target
                 auto spurPath =
-                    dijkstraShortestPath(modifiedGraph, spurNode, target, mode);
+                    dijkstraShortestPath(modifiedGraph, spurNode, target, modes,
+                                         closures);
                 if (!spurPath.has_value())
                 {
                     continue;
@@ -240,16 +383,28 @@ public:
         return kPaths;
     }
 
+    /**
+     * @brief Find k diverse short paths with Yen-style deviations
+     *
+     * Deviates from up to three of the most recent paths per round. The
+     * spur searches of a round are independent and run through
+     * parallelFor when given; candidates are merged in spur order either
+     * way, so the result does not depend on scheduling.
+     * @param parallelFor Runs the spur searches; sequential when not given
+     */
     static std::vector<EdgePathInfo>
     kShortestPathsModified(const GraphType &graph, const VertexIdType &source,
                            const VertexIdType &target, size_t k,
-                           TerminalSim::TransportationMode mode =
-                               TerminalSim::TransportationMode::Any)
+                           TerminalSim::TransportationModeMask modes =
+                               TerminalSim::TransportationMode::Any,
+                           const ClosureOverlayType *closures = nullptr,
+                           const ParallelFor &parallelFor = {})
     {
         std::vector<EdgePathInfo> kPaths;
 
         // Find the first shortest path using Dijkstra
-        auto firstPath = dijkstraShortestPath(graph, source, target, mode);
+        auto firstPath =
+            dijkstraShortestPath(graph, source, target, modes, closures);
         if (!firstPath.has_value())
         {
             qCDebug(lcGraph) << "No path exists from" << source << "to" << target;
@@ -282,62 +437,231 @@ public:
             size_t pathsToProcess = std::min(
                 kPaths.size(), size_t(3)); // Process up to 3 recent paths
 
+            // Every potential deviation point of the recent paths
+            std::vector<std::pair<const EdgePath *, size_t>> spurs;
             for (size_t pathIdx = 0; pathIdx < pathsToProcess; ++pathIdx)
             {
                 const EdgePath &prevPath =
                     kPaths[kPaths.size() - 1 - pathIdx].first;
-
-                // For each potential deviation point in the path
                 for (size_t j = 0; j < prevPath.size(); ++j)
                 {
-                    VertexIdType spurNode = prevPath[j].source();
-                    EdgePath rootPath(prevPath.begin(), prevPath.begin() + j);
+                    spurs.emplace_back(&prevPath, j);
+                }
+            }
 
-                    // Create a modified graph that encourages diversity
-                    GraphType modifiedGraph = createDiverseModifiedGraph(
-                        graph, spurNode, rootPath, kPaths, source);
+            std::vector<std::optional<EdgePathInfo>> spurPaths(spurs.size());
+            runParallel(spurs.size(), parallelFor, [&](size_t s) {
+                const EdgePath &prevPath = *spurs[s].first;
+                const size_t    j        = spurs[s].second;
+                EdgePath rootPath(prevPath.begin(), prevPath.begin() + j);
 
-                    // Find the shortest path from spur node to target
-                    auto spurPath = dijkstraShortestPath(
-                        modifiedGraph, spurNode, target, mode);
-                    if (!spurPath.has_value())
+                // Create a modified graph that encourages diversity
+                GraphType modifiedGraph = createDiverseModifiedGraph(
+                    graph, prevPath[j].source(), rootPath, kPaths, source);
+
+                // Find the shortest path from spur node to target
+                spurPaths[s] = dijkstraShortestPath(
+                    modifiedGraph, prevPath[j].source(), target, modes,
+                    closures);
+            });
+
+            for (size_t s = 0; s < spurs.size(); ++s)
+            {
+                if (!spurPaths[s].has_value())
+                {
+                    continue;
+                }
+
+                // Create total path
+                const EdgePath &prevPath = *spurs[s].first;
+                EdgePath totalPath(prevPath.begin(),
+                                   prevPath.begin() + spurs[s].second);
+                totalPath.insert(totalPath.end(),
+                                 spurPaths[s].value().first.begin(),
+                                 spurPaths[s].value().first.end());
+
+                // Calculate total weight
+                WeightType totalWeight = calculateEdgePathWeight(totalPath);
+
+                // Create candidate
+                EdgePathInfo candidate =
+                    std::make_pair(totalPath, totalWeight);
+
+                // Get path signature for duplicate checking
+                auto pathSignature = getPathSignature(totalPath);
+
+                // Only add if we haven't seen this path signature before
+                if (seenPathSignatures.find(pathSignature)
+                    == seenPathSignatures.end())
+                {
+                    candidates.push(candidate);
+                    seenPathSignatures.insert(pathSignature);
+                }
+            }
+
+            // If no more candidates are available, break
+            if (candidates.empty())
+            {
+                break;
+            }
+
+            // Add the best candidate to kPaths
+            kPaths.push_back(candidates.top());
+            candidates.pop();
+        }
+
+        return kPaths;
+    }
+
+    /**
+     * @brief Find the k shortest paths with transfer costs priced in the
+     * search
+     *
+     * Runs Yen's algorithm over the implicit (vertex, arrival mode) state
+     * graph, so a vertex costs transferCost(vertex, arrival, departure)
+     * depending on the modes used around it. Paths come back ranked by
+     * their true total cost and no over-fetching is needed.
+     * @param graph Input graph whose edge weights exclude vertex costs
+     * @param source Source vertex id
+     * @param target Target vertex id
+     * @param k Number of shortest paths to find
+     * @param transferCost Cost of passing through a vertex
+     * @param modes Transportation modes whose edges may be used (Any by
+     * default)
+     * @param closures Closed vertices and edges to avoid (none by default)
+     * @param parallelFor Runs the spur searches of a round, which must be
+     * safe to call transferCost from concurrently; sequential when not
+     * given
+     * @return Vector of path information (up to k paths), weights include
+     * transfer costs
+     */
+    static std::vector<EdgePathInfo>
+    kShortestPathsWithTransfers(const GraphType            &graph,
+                                const VertexIdType         &source,
+                                const VertexIdType         &target, size_t k,
+                                const TransferCostFunction &transferCost,
+                                TerminalSim::TransportationModeMask modes =
+                                    TerminalSim::TransportationMode::Any,
+                                const ClosureOverlayType *closures = nullptr,
+                                const ParallelFor &parallelFor = {})
+    {
+        std::vector<EdgePathInfo> kPaths;
+        if (k == 0)
+        {
+            return kPaths;
+        }
+
+        // A terminal revisited only to avoid a mode change is not a valid
+        // route, so every search here returns the cheapest simple path
+        auto firstPath = simpleTransferAwarePath(
+            graph, source, TerminalSim::TransportationMode::Any, target, modes,
+            transferCost, closures, {}, {});
+        if (!firstPath.has_value())
+        {
+            qCDebug(lcGraph) << "No path exists from" << source << "to" << target;
+            return kPaths;
+        }
+        kPaths.push_back(firstPath.value());
+
+        std::priority_queue<
+            EdgePathInfo, std::vector<EdgePathInfo>,
+            std::function<bool(const EdgePathInfo &, const EdgePathInfo &)>>
+            candidates([](const EdgePathInfo &a, const EdgePathInfo &b) {
+                return a.second > b.second; // Min heap by path weight
+            });
+
+        std::set<std::vector<std::tuple<VertexIdType, VertexIdType,
+                                        TerminalSim::TransportationMode>>>
+            seenPathSignatures;
+        seenPathSignatures.insert(getPathSignature(firstPath.value().first));
+
+        for (size_t i = 1; i < k; ++i)
+        {
+            const EdgePath prevPath = kPaths.back().first;
+
+            std::vector<std::optional<EdgePathInfo>> spurPaths(prevPath.size());
+            runParallel(prevPath.size(), parallelFor, [&](size_t j) {
+                const VertexIdType spurNode = prevPath[j].source();
+                const EdgePath rootPath(prevPath.begin(), prevPath.begin() + j);
+                const TerminalSim::TransportationMode arrivalMode =
+                    j == 0 ? TerminalSim::TransportationMode::Any
+                           : prevPath[j - 1].mode();
+
+                // Root vertices other than the spur node may not be entered
+                // in any arrival mode, and the spur search itself returns a
+                // simple path, so the joined path is simple
+                SearchArena                 arena;
+                std::pmr::set<VertexIdType> blockedVertices(arena.resource());
+                for (const auto &edge : rootPath)
+                {
+                    blockedVertices.insert(edge.source());
+                }
+
+                // Edges already taken from this root must not be repeated
+                BlockedEdgeSet blockedEdges(arena.resource());
+                for (const auto &path : kPaths)
+                {
+                    if (path.first.size() <= j)
                     {
                         continue;
                     }
 
-                    // Create total path
-                    EdgePath totalPath = rootPath;
-                    totalPath.insert(totalPath.end(),
-                                     spurPath.value().first.begin(),
-                                     spurPath.value().first.end());
+                    bool sameRoot = true;
+                    for (size_t r = 0; r < j; ++r)
+                    {
+                        if (path.first[r].source() != rootPath[r].source()
+                            || path.first[r].target() != rootPath[r].target()
+                            || path.first[r].mode() != rootPath[r].mode())
+                        {
+                            sameRoot = false;
+                            break;
+                        }
+                    }
 
-                    // Calculate total weight
-                    WeightType totalWeight = calculateEdgePathWeight(totalPath);
+                    if (sameRoot)
+                    {
+                        blockedEdges.insert(
+                            std::make_tuple(path.first[j].source(),
+                                            path.first[j].target(),
+                                            path.first[j].mode()));
+                    }
+                }
+
+                spurPaths[j] = simpleTransferAwarePath(
+                    graph, spurNode, arrivalMode, target, modes, transferCost,
+                    closures, blockedVertices, blockedEdges);
+            });
 
-                    // Create candidate
-                    EdgePathInfo candidate =
-                        std::make_pair(totalPath, totalWeight);
+            // Merged in spur order, as a sequential search would
+            for (size_t j = 0; j < prevPath.size(); ++j)
+            {
+                const auto &spurPath = spurPaths[j];
+                if (!spurPath.has_value())
+                {
+                    continue;
+                }
 
-                    // Get path signature for duplicate checking
-                    auto pathSignature = getPathSignature(totalPath);
+                EdgePath totalPath(prevPath.begin(), prevPath.begin() + j);
+                totalPath.insert(totalPath.end(),
+                                 spurPath.value().first.begin(),
+                                 spurPath.value().first.end());
 
-                    // Only add if we haven't seen this path signature before
-                    if (seenPathSignatures.find(pathSignature)
-                        == seenPathSignatures.end())
-                    {
-                        candidates.push(candidate);
-                        seenPathSignatures.insert(pathSignature);
-                    }
+                auto pathSignature = getPathSignature(totalPath);
+                if (seenPathSignatures.find(pathSignature)
+                    == seenPathSignatures.end())
+                {
+                    seenPathSignatures.insert(pathSignature);
+                    candidates.push(std::make_pair(
+                        totalPath,
+                        calculateTransferAwareWeight(totalPath, transferCost)));
                 }
             }
 
-            // If no more candidates are available, break
             if (candidates.empty())
             {
                 break;
             }
 
-            // Add the best candidate to kPaths
             kPaths.push_back(candidates.top());
             candidates.pop();
         }
@@ -345,7 +669,506 @@ public:
         return kPaths;
     }
 
+    /**
+     * @brief Cheapest path that satisfies hop, transfer and resource limits
+     *
+     * Label-correcting search where each label carries its cost, hop count,
+     * mode changes, consumed resource and last mode. Labels are expanded in
+     * cost order. A label is discarded when it breaks a limit or when
+     * another label at the same vertex is no worse in cost and in every
+     * limited resource, so the first label to reach the target is the
+     * cheapest feasible path. With no limits set this is plain Dijkstra.
+     * @param graph Input graph
+     * @param source Source vertex id
+     * @param target Target vertex id
+     * @param constraints Limits the path must respect
+     * @param edgeResource Resource consumed per edge, required when
+     * constraints.maxResource is set
+     * @param modes Transportation modes whose edges may be used (Any by
+     * default)
+     * @param closures Closed vertices and edges to avoid (none by default)
+     * @return Path information or std::nullopt if no feasible path exists
+     */
+    static std::optional<EdgePathInfo> constrainedShortestPath(
+        const GraphType &graph, const VertexIdType &source,
+        const VertexIdType &target, const PathConstraints &constraints,
+        const EdgeResourceFunction         &edgeResource = {},
+        TerminalSim::TransportationModeMask modes =
+            TerminalSim::TransportationMode::Any,
+        const ClosureOverlayType *closures = nullptr)
+    {
+        if (constraints.maxResource.has_value() && !edgeResource)
+        {
+            qCDebug(lcGraph) << "A resource limit needs an edge resource function";
+            return std::nullopt;
+        }
+
+        struct Label
+        {
+            VertexIdType                    vertex;
+            WeightType                      cost;
+            size_t                          hops;
+            size_t                          transfers;
+            WeightType                      resource;
+            TerminalSim::TransportationMode lastMode;
+            int                             parent; ///< Index into labels
+            EdgeType                        edge;   ///< Edge into vertex
+        };
+
+        SearchArena             arena;
+        std::pmr::vector<Label> labels(arena.resource());
+        labels.push_back(Label{source, WeightType(0), 0, 0, WeightType(0),
+                               TerminalSim::TransportationMode::Any, -1,
+                               EdgeType()});
+
+        // Non-dominated labels settled at each vertex
+        std::pmr::unordered_map<VertexIdType, std::pmr::vector<int>> settled(
+            arena.resource());
+
+        // Unlimited resources cannot make a path infeasible, so only the
+        // limited ones are compared
+        auto dominates = [&constraints](const Label &a, const Label &b) {
+            if (a.cost > b.cost
+                || (constraints.maxHops.has_value() && a.hops > b.hops)
+                || (constraints.maxResource.has_value()
+                    && a.resource > b.resource))
+            {
+                return false;
+            }
+            if (!constraints.maxTransfers.has_value())
+            {
+                return true;
+            }
+
+            // A different last mode may save b a transfer on its next edge
+            const size_t transferSlack =
+                a.lastMode == b.lastMode
+                        || a.lastMode == TerminalSim::TransportationMode::Any
+                    ? 0
+                    : 1;
+            return a.transfers + transferSlack <= b.transfers;
+        };
+
+        auto isDominated = [&](const Label &label) {
+            const auto it = settled.find(label.vertex);
+            if (it == settled.end())
+            {
+                return false;
+            }
+            for (int other : it->second)
+            {
+                if (dominates(labels[other], label))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        auto onPath = [&labels](int labelIndex, const VertexIdType &vertex) {
+            for (int i = labelIndex; i >= 0; i = labels[i].parent)
+            {
+                if (labels[i].vertex == vertex)
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        using QueueItem = std::pair<WeightType, int>;
+        std::priority_queue<QueueItem, std::pmr::vector<QueueItem>,
+                            std::greater<QueueItem>>
+            pq(std::greater<QueueItem>(),
+               std::pmr::vector<QueueItem>(arena.resource()));
+        pq.push(std::make_pair(WeightType(0), 0));
+
+        while (!pq.empty())
+        {
+            const int current = pq.top().second;
+            pq.pop();
+
+            // Copy: expanding below may grow (and reallocate) labels
+            const Label label = labels[current];
+
+            // Labels settled since this one was queued may dominate it
+            if (isDominated(label))
+            {
+                continue;
+            }
+            settled[label.vertex].push_back(current);
+
+            if (label.vertex == target)
+            {
+                EdgePath edgePath;
+                for (int i = current; labels[i].parent >= 0;
+                     i = labels[i].parent)
+                {
+                    edgePath.push_back(labels[i].edge);
+                }
+                std::reverse(edgePath.begin(), edgePath.end());
+                return std::make_pair(edgePath, label.cost);
+            }
+
+            // Labels that break a limit are never queued
+            const size_t hops = label.hops + 1;
+            if (constraints.maxHops.has_value() && hops > *constraints.maxHops)
+            {
+                continue;
+            }
+
+            for (const auto &edge : graph.outgoingEdges(label.vertex, modes))
+            {
+                if (closures != nullptr && closures->blocks(edge))
+                {
+                    continue;
+                }
+
+                const size_t transfers =
+                    label.transfers
+                    + (label.lastMode != TerminalSim::TransportationMode::Any
+                               && label.lastMode != edge.mode()
+                           ? 1
+                           : 0);
+                if (constraints.maxTransfers.has_value()
+                    && transfers > *constraints.maxTransfers)
+                {
+                    continue;
+                }
+
+                WeightType resource = label.resource;
+                if (edgeResource)
+                {
+                    resource += edgeResource(edge);
+                }
+                if (constraints.maxResource.has_value()
+                    && resource > *constraints.maxResource)
+                {
+                    continue;
+                }
+
+                const Label next{edge.target(), label.cost + edge.weight(),
+                                 hops, transfers, resource, edge.mode(),
+                                 current, edge};
+                if (isDominated(next))
+                {
+                    continue;
+                }
+
+                // Keep paths simple; a cycle never helps any resource
+                if (onPath(current, edge.target()))
+                {
+                    continue;
+                }
+
+                labels.push_back(next);
+                pq.push(std::make_pair(next.cost,
+                                       static_cast<int>(labels.size()) - 1));
+            }
+        }
+
+        qCDebug(lcGraph) << "No feasible path exists from" << source << "to"
+                         << target;
+        return std::nullopt;
+    }
+
 private:
+    // Edges a spur search may not take from its start vertex
+    using BlockedEdgeSet = std::pmr::set<
+        std::tuple<VertexIdType, VertexIdType, TerminalSim::TransportationMode>>;
+
+    // Vertices that may only be entered by the given mode
+    using PinnedArrivalMap =
+        std::pmr::map<VertexIdType, TerminalSim::TransportationMode>;
+
+    /**
+     * @brief Run task(0) .. task(count - 1) through parallelFor, or in
+     * order when it is not given
+     */
+    static void runParallel(size_t count, const ParallelFor &parallelFor,
+                            const std::function<void(size_t)> &task)
+    {
+        if (parallelFor)
+        {
+            parallelFor(count, task);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            task(i);
+        }
+    }
+
+    /**
+     * @brief Dijkstra over (vertex, arrival mode) states
+     * @param graph Input graph
+     * @param source Start vertex
+     * @param sourceArrivalMode Mode the start vertex was reached by, Any at
+     * the origin
+     * @param target Target vertex
+     * @param modes Transportation modes whose edges may be used
+     * @param transferCost Cost of passing through a vertex
+     * @param closures Closed vertices and edges to avoid, may be null
+     * @param blockedVertices Vertices that may not be entered
+     * @param blockedEdges Edges that may not leave the start vertex
+     * @param pinnedArrivals Vertices that may only be entered by one mode
+     * @return Path from source to target and its cost including the target's
+     * transfer cost, or std::nullopt if no path exists
+     */
+    static std::optional<EdgePathInfo> transferAwareDijkstra(
+        const GraphType &graph, const VertexIdType &source,
+        TerminalSim::TransportationMode sourceArrivalMode,
+        const VertexIdType &target, TerminalSim::TransportationModeMask modes,
+        const TransferCostFunction        &transferCost,
+        const ClosureOverlayType          *closures,
+        const std::pmr::set<VertexIdType> &blockedVertices,
+        const BlockedEdgeSet              &blockedEdges,
+        const PinnedArrivalMap            &pinnedArrivals)
+    {
+        SearchArena arena;
+
+        // The sink state marks "arrived and paid destination handling"
+        constexpr int sinkMode = std::numeric_limits<int>::max();
+        using State     = std::pair<VertexIdType, int>;
+        using QueueItem = std::pair<WeightType, State>;
+        std::priority_queue<QueueItem, std::pmr::vector<QueueItem>,
+                            std::greater<QueueItem>>
+            pq(std::greater<QueueItem>(),
+               std::pmr::vector<QueueItem>(arena.resource()));
+
+        std::pmr::map<State, WeightType> distance(arena.resource());
+        std::pmr::map<State, std::pair<State, EdgeType>> previous(
+            arena.resource());
+        std::pmr::set<State> visited(arena.resource());
+
+        const State start(source, static_cast<int>(sourceArrivalMode));
+        distance[start] = 0;
+        pq.push(std::make_pair(WeightType(0), start));
+
+        std::optional<State> reachedSink;
+        while (!pq.empty())
+        {
+            auto [dist, current] = pq.top();
+            pq.pop();
+
+            if (!visited.insert(current).second)
+            {
+                continue;
+            }
+
+            if (current.second == sinkMode)
+            {
+                reachedSink = current;
+                break;
+            }
+
+            const auto arrivalMode =
+                static_cast<TerminalSim::TransportationMode>(current.second);
+
+            if (current.first == target)
+            {
+                const State      sink(target, sinkMode);
+                const WeightType sinkDist =
+                    dist
+                    + transferCost(target, arrivalMode,
+                                   TerminalSim::TransportationMode::Any);
+                auto it = distance.find(sink);
+                if (it == distance.end() || sinkDist < it->second)
+                {
+                    distance[sink] = sinkDist;
+                    previous.erase(sink);
+                    previous.emplace(sink, std::make_pair(current, EdgeType()));
+                    pq.push(std::make_pair(sinkDist, sink));
+                }
+                continue;
+            }
+
+            for (const auto &edge : graph.outgoingEdges(current.first, modes))
+            {
+                const auto pinned = pinnedArrivals.find(edge.target());
+                if (edge.target() == source
+                    || (closures != nullptr && closures->blocks(edge))
+                    || blockedVertices.count(edge.target()) > 0
+                    || (pinned != pinnedArrivals.end()
+                        && pinned->second != edge.mode())
+                    || (current == start
+                        && blockedEdges.count(std::make_tuple(
+                               edge.source(), edge.target(), edge.mode()))
+                               > 0))
+                {
+                    continue;
+                }
+
+                const State      next(edge.target(),
+                                      static_cast<int>(edge.mode()));
+                const WeightType newDist =
+                    dist + transferCost(current.first, arrivalMode, edge.mode())
+                    + edge.weight();
+
+                auto it = distance.find(next);
+                if (it == distance.end() || newDist < it->second)
+                {
+                    distance[next] = newDist;
+                    previous.erase(next);
+                    previous.emplace(next, std::make_pair(current, edge));
+                    pq.push(std::make_pair(newDist, next));
+                }
+            }
+        }
+
+        if (!reachedSink.has_value())
+        {
+            return std::nullopt;
+        }
+
+        // Reconstruct, skipping the zero-length hop into the sink
+        EdgePath edgePath;
+        State    current = previous.at(reachedSink.value()).first;
+        while (current != start)
+        {
+            const auto &[prevState, edge] = previous.at(current);
+            edgePath.push_back(edge);
+            current = prevState;
+        }
+        std::reverse(edgePath.begin(), edgePath.end());
+
+        if (edgePath.empty())
+        {
+            return std::nullopt;
+        }
+        return std::make_pair(edgePath, distance[reachedSink.value()]);
+    }
+
+    /**
+     * @brief Cheapest path over (vertex, arrival mode) states that visits
+     * no vertex twice
+     *
+     * The state search may enter a vertex once per arrival mode, for
+     * instance to leave it again without paying for a mode change. Such a
+     * result is split into one subproblem per mode that pins the repeated
+     * vertex to that arrival mode. Every simple path fits at least one of
+     * them and none can repeat the vertex again. Subproblems are solved
+     * cheapest first, so the first simple result is the cheapest one.
+     * Parameters are those of transferAwareDijkstra().
+     * @return Simple path from source to target and its cost, or
+     * std::nullopt if no simple path exists
+     */
+    static std::optional<EdgePathInfo> simpleTransferAwarePath(
+        const GraphType &graph, const VertexIdType &source,
+        TerminalSim::TransportationMode sourceArrivalMode,
+        const VertexIdType &target, TerminalSim::TransportationModeMask modes,
+        const TransferCostFunction        &transferCost,
+        const ClosureOverlayType          *closures,
+        const std::pmr::set<VertexIdType> &blockedVertices,
+        const BlockedEdgeSet              &blockedEdges)
+    {
+        SearchArena arena;
+
+        struct Subproblem
+        {
+            EdgePathInfo     path;
+            PinnedArrivalMap pinnedArrivals;
+        };
+        auto costlier = [](const Subproblem &a, const Subproblem &b) {
+            return a.path.second > b.path.second;
+        };
+        std::pmr::vector<Subproblem> open(arena.resource());
+
+        auto solve = [&](PinnedArrivalMap &&pinnedArrivals) {
+            auto path = transferAwareDijkstra(
+                graph, source, sourceArrivalMode, target, modes, transferCost,
+                closures, blockedVertices, blockedEdges, pinnedArrivals);
+            if (path.has_value())
+            {
+                open.push_back(Subproblem{std::move(path.value()),
+                                          std::move(pinnedArrivals)});
+                std::push_heap(open.begin(), open.end(), costlier);
+            }
+        };
+        solve(PinnedArrivalMap(arena.resource()));
+
+        while (!open.empty())
+        {
+            std::pop_heap(open.begin(), open.end(), costlier);
+            Subproblem cheapest = std::move(open.back());
+            open.pop_back();
+
+            const auto repeated = firstRepeatedVertex(cheapest.path.first);
+            if (!repeated.has_value())
+            {
+                return cheapest.path;
+            }
+
+            constexpr int modeCount =
+                TerminalSim::TransportationModeMask::ModeCount;
+            for (int mode = 0; mode < modeCount; ++mode)
+            {
+                const auto arrivalMode =
+                    static_cast<TerminalSim::TransportationMode>(mode);
+                if (!modes.contains(arrivalMode))
+                {
+                    continue;
+                }
+                PinnedArrivalMap pinnedArrivals(cheapest.pinnedArrivals,
+                                                arena.resource());
+                pinnedArrivals[repeated.value()] = arrivalMode;
+                solve(std::move(pinnedArrivals));
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief First vertex an edge path visits twice
+     * @param edgePath Path of edges
+     * @return The repeated vertex, or std::nullopt if the path is simple
+     */
+    static std::optional<VertexIdType>
+    firstRepeatedVertex(const EdgePath &edgePath)
+    {
+        if (edgePath.empty())
+        {
+            return std::nullopt;
+        }
+
+        std::unordered_set<VertexIdType> visited{edgePath.front().source()};
+        for (const auto &edge : edgePath)
+        {
+            if (!visited.insert(edge.target()).second)
+            {
+                return edge.target();
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Total weight of an edge path including transfer costs
+     * @param edgePath Path of edges
+     * @param transferCost Cost of passing through a vertex
+     * @return Edge weights plus origin, transfer and destination costs
+     */
+    static WeightType
+    calculateTransferAwareWeight(const EdgePath             &edgePath,
+                                 const TransferCostFunction &transferCost)
+    {
+        WeightType totalWeight = calculateEdgePathWeight(edgePath);
+        if (edgePath.empty())
+        {
+            return totalWeight;
+        }
+
+        auto arrivalMode = TerminalSim::TransportationMode::Any;
+        for (const auto &edge : edgePath)
+        {
+            totalWeight += transferCost(edge.source(), arrivalMode, edge.mode());
+            arrivalMode = edge.mode();
+        }
+        totalWeight += transferCost(edgePath.back().target(), arrivalMode,
+                                    TerminalSim::TransportationMode::Any);
+        return totalWeight;
+    }
+
     /**
      * @brief Convert an edge path to a vertex path
      * @param edgePath Path of edges
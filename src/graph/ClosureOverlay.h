@@ -0,0 +1,105 @@
+#pragma once
+
+#include "common.h"
+#include <set>
+#include <tuple>
+#include <unordered_set>
+
+namespace GraphLib
+{
+
+/**
+ * @brief Closed vertices and edges laid over a graph without modifying it
+ *
+ * Searches consult the overlay while relaxing edges, so opening or closing
+ * an element never requires the graph to be rebuilt. An edge is blocked
+ * when it is closed itself or when either of its endpoints is closed.
+ */
+template <typename VertexIdType> class ClosureOverlay
+{
+public:
+    ClosureOverlay() = default;
+
+    /**
+     * @brief Close a vertex for passing through, departing and arriving
+     * @param vertex Vertex id
+     */
+    void closeVertex(const VertexIdType &vertex)
+    {
+        m_vertices.insert(vertex);
+    }
+
+    /**
+     * @brief Close one directed edge
+     * @param source Source vertex id
+     * @param target Target vertex id
+     * @param mode Transportation mode of the edge
+     */
+    void closeEdge(const VertexIdType &source, const VertexIdType &target,
+                   TerminalSim::TransportationMode mode)
+    {
+        m_edges.insert(std::make_tuple(source, target, mode));
+    }
+
+    /**
+     * @brief Check whether a vertex is closed
+     * @param vertex Vertex id
+     * @return true if the vertex is closed
+     */
+    bool isVertexClosed(const VertexIdType &vertex) const
+    {
+        return m_vertices.count(vertex) > 0;
+    }
+
+    /**
+     * @brief Check whether a search may not use an edge
+     * @param edge Edge to test
+     * @return true if the edge or one of its endpoints is closed
+     */
+    template <typename EdgeType> bool blocks(const EdgeType &edge) const
+    {
+        if (empty())
+        {
+            return false;
+        }
+        return isVertexClosed(edge.source()) || isVertexClosed(edge.target())
+               || m_edges.count(std::make_tuple(edge.source(), edge.target(),
+                                                edge.mode()))
+                      > 0;
+    }
+
+    /**
+     * @brief Check whether nothing is closed
+     * @return true if the overlay blocks no edge
+     */
+    bool empty() const
+    {
+        return m_vertices.empty() && m_edges.empty();
+    }
+
+    /**
+     * @brief Closed vertices
+     */
+    const std::unordered_set<VertexIdType> &closedVertices() const
+    {
+        return m_vertices;
+    }
+
+    /**
+     * @brief Closed edges as (source, target, mode)
+     */
+    const std::set<
+        std::tuple<VertexIdType, VertexIdType, TerminalSim::TransportationMode>> &
+    closedEdges() const
+    {
+        return m_edges;
+    }
+
+private:
+    std::unordered_set<VertexIdType> m_vertices;
+    std::set<
+        std::tuple<VertexIdType, VertexIdType, TerminalSim::TransportationMode>>
+        m_edges;
+};
+
+} // namespace GraphLib
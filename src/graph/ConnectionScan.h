@@ -0,0 +1,370 @@
+#pragma once
+
+#include "common/LogCategories.h"
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GraphLib
+{
+
+/**
+ * @brief Timetable routing with the Connection Scan Algorithm
+ *
+ * All scheduled departures are kept in one array sorted by departure time
+ * and answered with a single linear scan, which touches memory sequentially
+ * instead of chasing adjacency lists. Every stop may declare a transfer
+ * time that is paid when a container is unloaded there before continuing on
+ * another trip; staying on the same trip costs nothing.
+ */
+template <typename VertexIdType, typename TimeType> class ConnectionScan
+{
+public:
+    /**
+     * @brief One scheduled vehicle movement between two stops
+     */
+    struct Connection
+    {
+        VertexIdType from;
+        VertexIdType to;
+        TimeType     departure;
+        TimeType     arrival;
+        int          trip;    ///< Connections sharing a trip keep the load
+        int          payload; ///< Caller data, returned untouched
+    };
+
+    /**
+     * @brief A ride on one trip from boarding to alighting, as indexes into
+     * connections()
+     */
+    struct Leg
+    {
+        size_t enter;
+        size_t exit;
+    };
+
+    struct Journey
+    {
+        TimeType         arrival;
+        std::vector<Leg> legs;
+    };
+
+    struct ProfileEntry
+    {
+        TimeType departure;
+        TimeType arrival;
+    };
+
+    ConnectionScan() = default;
+
+    /**
+     * @brief Build the sorted connection array
+     * @param connections Scheduled connections in any order
+     * @param transferTimes Time spent at a stop between two trips
+     */
+    ConnectionScan(std::vector<Connection>                     connections,
+                   const std::unordered_map<VertexIdType, TimeType> &transferTimes)
+        : m_connections(std::move(connections))
+    {
+        std::stable_sort(m_connections.begin(), m_connections.end(),
+                         [](const Connection &a, const Connection &b) {
+                             if (a.departure != b.departure)
+                             {
+                                 return a.departure < b.departure;
+                             }
+                             return a.arrival < b.arrival;
+                         });
+
+        // Dense stop and trip indexes keep the scan state in flat arrays
+        std::unordered_map<int, int> tripIndex;
+        m_scan.reserve(m_connections.size());
+        for (const Connection &connection : m_connections)
+        {
+            const int from = stopIndex(connection.from);
+            const int to   = stopIndex(connection.to);
+
+            int trip = static_cast<int>(tripIndex.size());
+            if (connection.trip >= 0)
+            {
+                trip = tripIndex.emplace(connection.trip, trip).first->second;
+            }
+            else
+            {
+                // Unnamed trips are single connections; use a key callers
+                // cannot collide with
+                tripIndex.emplace(-1 - static_cast<int>(m_scan.size()), trip);
+            }
+
+            m_scan.push_back(
+                ScanConnection{from, to, connection.departure,
+                               connection.arrival, trip});
+        }
+        m_tripCount = tripIndex.size();
+
+        m_transferTimes.assign(m_stops.size(), TimeType(0));
+        for (const auto &[stop, transferTime] : transferTimes)
+        {
+            auto it = m_stops.find(stop);
+            if (it != m_stops.end())
+            {
+                m_transferTimes[it->second] = transferTime;
+            }
+        }
+
+        qCDebug(lcGraph) << "Connection scan built with"
+                         << m_connections.size() << "connections over"
+                         << m_stops.size() << "stops";
+    }
+
+    /**
+     * @brief Earliest arrival at target when ready at source at a time
+     * @param source Origin stop
+     * @param target Destination stop
+     * @param departureTime Time the load is ready at the origin
+     * @param cancelled Optional flags by connections() index; a cancelled
+     * connection cannot be ridden and breaks its trip
+     * @return Journey with the earliest vehicle arrival at target, or
+     * std::nullopt if no scheduled journey exists
+     */
+    std::optional<Journey>
+    earliestArrival(const VertexIdType &source, const VertexIdType &target,
+                    TimeType                 departureTime,
+                    const std::vector<bool> *cancelled = nullptr) const
+    {
+        auto sourceIt = m_stops.find(source);
+        auto targetIt = m_stops.find(target);
+        if (sourceIt == m_stops.end() || targetIt == m_stops.end()
+            || sourceIt->second == targetIt->second)
+        {
+            return std::nullopt;
+        }
+
+        const int    sourceStop = sourceIt->second;
+        const int    targetStop = targetIt->second;
+        const size_t none       = std::numeric_limits<size_t>::max();
+
+        std::vector<TimeType> ready(m_stops.size(), infinity());
+        std::vector<std::pair<size_t, size_t>> journeyPointer(
+            m_stops.size(), std::make_pair(none, none));
+        std::vector<size_t> tripEnter(m_tripCount, none);
+        ready[sourceStop] = departureTime;
+
+        TimeType bestArrival = infinity();
+        for (size_t i = firstDepartureAtOrAfter(departureTime);
+             i < m_scan.size(); ++i)
+        {
+            const ScanConnection &connection = m_scan[i];
+            if (connection.departure >= bestArrival)
+            {
+                break;
+            }
+
+            if (cancelled != nullptr && (*cancelled)[i])
+            {
+                // The load must board again after a cancelled hop
+                tripEnter[connection.trip] = none;
+                continue;
+            }
+
+            if (tripEnter[connection.trip] == none)
+            {
+                if (ready[connection.from] > connection.departure)
+                {
+                    continue;
+                }
+                tripEnter[connection.trip] = i;
+            }
+
+            if (connection.to == targetStop)
+            {
+                if (connection.arrival < bestArrival)
+                {
+                    bestArrival = connection.arrival;
+                    journeyPointer[targetStop] =
+                        std::make_pair(tripEnter[connection.trip], i);
+                }
+                continue;
+            }
+
+            const TimeType readyAt =
+                connection.arrival + m_transferTimes[connection.to];
+            if (readyAt < ready[connection.to])
+            {
+                ready[connection.to] = readyAt;
+                journeyPointer[connection.to] =
+                    std::make_pair(tripEnter[connection.trip], i);
+            }
+        }
+
+        if (bestArrival == infinity())
+        {
+            return std::nullopt;
+        }
+
+        Journey journey;
+        journey.arrival = bestArrival;
+        int stop        = targetStop;
+        while (stop != sourceStop && journey.legs.size() <= m_stops.size())
+        {
+            const auto &[enter, exit] = journeyPointer[stop];
+            journey.legs.push_back(Leg{enter, exit});
+            stop = m_scan[enter].from;
+        }
+        std::reverse(journey.legs.begin(), journey.legs.end());
+        return journey;
+    }
+
+    /**
+     * @brief Pareto set of (ready time at source, arrival at target)
+     * @param source Origin stop
+     * @param target Destination stop
+     * @param windowStart Earliest ready time at the origin
+     * @param windowEnd Latest ready time at the origin
+     * @param cancelled Optional flags by connections() index; a cancelled
+     * connection cannot be ridden and breaks its trip
+     * @return Non-dominated entries sorted by departure
+     */
+    std::vector<ProfileEntry>
+    profile(const VertexIdType &source, const VertexIdType &target,
+            TimeType windowStart, TimeType windowEnd,
+            const std::vector<bool> *cancelled = nullptr) const
+    {
+        std::vector<ProfileEntry> result;
+        auto sourceIt = m_stops.find(source);
+        auto targetIt = m_stops.find(target);
+        if (sourceIt == m_stops.end() || targetIt == m_stops.end()
+            || sourceIt->second == targetIt->second)
+        {
+            return result;
+        }
+
+        const int targetStop = targetIt->second;
+
+        // Profiles are appended in decreasing departure order, so the last
+        // entry always holds the earliest arrival for any later ready time
+        std::vector<std::vector<ProfileEntry>> profiles(m_stops.size());
+        std::vector<TimeType> tripArrival(m_tripCount, infinity());
+
+        const size_t first = firstDepartureAtOrAfter(windowStart);
+        for (size_t i = m_scan.size(); i-- > first;)
+        {
+            const ScanConnection &connection = m_scan[i];
+
+            if (cancelled != nullptr && (*cancelled)[i])
+            {
+                // Earlier hops of this trip cannot ride through it
+                tripArrival[connection.trip] = infinity();
+                continue;
+            }
+
+            TimeType arrival = tripArrival[connection.trip];
+            if (connection.to == targetStop)
+            {
+                arrival = std::min(arrival, connection.arrival);
+            }
+            else
+            {
+                arrival = std::min(
+                    arrival,
+                    evaluateProfile(profiles[connection.to],
+                                    connection.arrival
+                                        + m_transferTimes[connection.to]));
+            }
+
+            if (arrival == infinity())
+            {
+                continue;
+            }
+
+            tripArrival[connection.trip] =
+                std::min(tripArrival[connection.trip], arrival);
+
+            auto &fromProfile = profiles[connection.from];
+            if (arrival < evaluateProfile(fromProfile, connection.departure))
+            {
+                if (!fromProfile.empty()
+                    && fromProfile.back().departure == connection.departure)
+                {
+                    fromProfile.back().arrival = arrival;
+                }
+                else
+                {
+                    fromProfile.push_back(
+                        ProfileEntry{connection.departure, arrival});
+                }
+            }
+        }
+
+        for (auto it = profiles[sourceIt->second].rbegin();
+             it != profiles[sourceIt->second].rend(); ++it)
+        {
+            if (it->departure >= windowStart && it->departure <= windowEnd)
+            {
+                result.push_back(*it);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Connections sorted by departure time
+     */
+    const std::vector<Connection> &connections() const
+    {
+        return m_connections;
+    }
+
+private:
+    struct ScanConnection
+    {
+        int      from;
+        int      to;
+        TimeType departure;
+        TimeType arrival;
+        int      trip;
+    };
+
+    static TimeType infinity()
+    {
+        return std::numeric_limits<TimeType>::max();
+    }
+
+    static TimeType evaluateProfile(const std::vector<ProfileEntry> &profile,
+                                    TimeType                         readyTime)
+    {
+        // Entries are in decreasing departure order, so the catchable ones
+        // form a prefix and the last of them arrives earliest
+        auto it = std::partition_point(profile.begin(), profile.end(),
+                                       [readyTime](const ProfileEntry &entry) {
+                                           return entry.departure >= readyTime;
+                                       });
+        return it == profile.begin() ? infinity() : std::prev(it)->arrival;
+    }
+
+    size_t firstDepartureAtOrAfter(TimeType time) const
+    {
+        auto it = std::lower_bound(m_scan.begin(), m_scan.end(), time,
+                                   [](const ScanConnection &connection,
+                                      TimeType              value) {
+                                       return connection.departure < value;
+                                   });
+        return static_cast<size_t>(it - m_scan.begin());
+    }
+
+    int stopIndex(const VertexIdType &stop)
+    {
+        return m_stops.emplace(stop, static_cast<int>(m_stops.size()))
+            .first->second;
+    }
+
+    std::vector<Connection>               m_connections;
+    std::vector<ScanConnection>           m_scan;
+    std::unordered_map<VertexIdType, int> m_stops;
+    std::vector<TimeType>                 m_transferTimes;
+    size_t                                m_tripCount = 0;
+};
+
+} // namespace GraphLib
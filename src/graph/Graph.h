@@ -4,6 +4,7 @@
 #include "Edge.h"
 #include "common/LogCategories.h"
 #include <algorithm>
+#include <array>
 #include <QString>
 #include <set>
 #include <unordered_map>
@@ -34,12 +35,15 @@ public:
         }
 
         // Copy all edges
-        for (const auto &[source, edgeList] : m_adjacencyList)
+        for (const auto &[source, layers] : m_adjacencyList)
         {
-            for (const auto &edge : edgeList)
+            for (const auto &edgeList : layers)
             {
-                newGraph.addEdge(edge.source(), edge.target(), edge.weight(),
-                                 edge.mode());
+                for (const auto &edge : edgeList)
+                {
+                    newGraph.addEdge(edge.source(), edge.target(),
+                                     edge.weight(), edge.mode());
+                }
             }
         }
 
@@ -60,7 +64,7 @@ public:
             return false;
         }
 
-        m_adjacencyList[id] = std::vector<EdgeType>();
+        m_adjacencyList[id] = AdjacencyLayers();
         m_vertices.insert(id);
         return true;
     }
@@ -80,13 +84,15 @@ public:
 
         for (auto &entry : m_adjacencyList)
         {
-            auto &edges = entry.second;
-            edges.erase(std::remove_if(edges.begin(), edges.end(),
-                                       [&id](const EdgeType &edge) {
-                                           return edge.source() == id
-                                               || edge.target() == id;
-                                       }),
-                        edges.end());
+            for (auto &edges : entry.second)
+            {
+                edges.erase(std::remove_if(edges.begin(), edges.end(),
+                                           [&id](const EdgeType &edge) {
+                                               return edge.source() == id
+                                                   || edge.target() == id;
+                                           }),
+                            edges.end());
+            }
         }
 
         for (auto it = m_edges.begin(); it != m_edges.end();)
@@ -144,7 +150,7 @@ public:
         if (!edgeExists)
         {
             // Only add if this specific edge (with this mode) doesn't exist
-            m_adjacencyList[source].push_back(edge);
+            m_adjacencyList[source][layerIndex(mode)].push_back(edge);
 
             // Update the edges set
             m_edges.insert(std::make_tuple(source, target, mode));
@@ -172,11 +178,14 @@ public:
         if (mode == TerminalSim::TransportationMode::Any)
         {
             // Check if any edge exists between source and target
-            for (const auto &edge : m_adjacencyList.at(source))
+            for (const auto &edges : m_adjacencyList.at(source))
             {
-                if (edge.target() == target && edge.source() == source)
+                for (const auto &edge : edges)
                 {
-                    return true;
+                    if (edge.target() == target && edge.source() == source)
+                    {
+                        return true;
+                    }
                 }
             }
             return false;
@@ -209,34 +218,39 @@ public:
             return false;
         }
 
-        auto &edges   = m_adjacencyList[source];
+        auto &layers  = m_adjacencyList[source];
         bool  removed = false;
 
         if (mode == TerminalSim::TransportationMode::Any)
         {
             // Remove all edges from source to target regardless of mode
-            auto it = edges.begin();
-            while (it != edges.end())
+            for (auto &edges : layers)
             {
-                if (it->target() == target)
-                {
-                    // Remove from edges set
-                    m_edges.erase(std::make_tuple(source, target, it->mode()));
-
-                    // Remove from adjacency list and update iterator
-                    it      = edges.erase(it);
-                    removed = true;
-                }
-                else
+                auto it = edges.begin();
+                while (it != edges.end())
                 {
-                    ++it;
+                    if (it->target() == target)
+                    {
+                        // Remove from edges set
+                        m_edges.erase(
+                            std::make_tuple(source, target, it->mode()));
+
+                        // Remove from adjacency list and update iterator
+                        it      = edges.erase(it);
+                        removed = true;
+                    }
+                    else
+                    {
+                        ++it;
+                    }
                 }
             }
         }
         else
         {
             // Remove specific edge with given mode
-            auto it = std::find_if(edges.begin(), edges.end(),
+            auto &edges = layers[layerIndex(mode)];
+            auto  it    = std::find_if(edges.begin(), edges.end(),
                                    [&target, &mode](const EdgeType &edge) {
                                        return edge.target() == target
                                               && edge.mode() == mode;
@@ -287,13 +301,60 @@ public:
      */
     // Modified to return by value instead of optional reference
     std::vector<EdgeType> outgoingEdges(const VertexIdType &source) const
+    {
+        return outgoingEdges(source, TerminalSim::TransportationModeMask::all());
+    }
+
+    /**
+     * @brief Get the edges from a vertex whose mode is in a set
+     *
+     * Edges are stored in one layer per mode, so the filter selects whole
+     * layers instead of testing each edge.
+     * @param source Source vertex id
+     * @param modes Modes to include
+     * @return Vector of edges grouped by mode (empty if vertex doesn't exist)
+     */
+    std::vector<EdgeType>
+    outgoingEdges(const VertexIdType                &source,
+                  TerminalSim::TransportationModeMask modes) const
+    {
+        std::vector<EdgeType> edges;
+        forEachOutgoingEdge(source, modes, [&edges](const EdgeType &edge) {
+            edges.push_back(edge);
+        });
+        return edges;
+    }
+
+    /**
+     * @brief Visit the edges from a vertex whose mode is in a set without
+     * copying them
+     * @param source Source vertex id
+     * @param modes Modes to include
+     * @param visit Called with each matching edge
+     */
+    template <typename Visitor>
+    void forEachOutgoingEdge(const VertexIdType                &source,
+                             TerminalSim::TransportationModeMask modes,
+                             Visitor                          &&visit) const
     {
         auto it = m_adjacencyList.find(source);
         if (it == m_adjacencyList.end())
         {
-            return {}; // Return empty vector if vertex doesn't exist
+            return;
+        }
+
+        for (int layer = 0; layer < ModeLayerCount; ++layer)
+        {
+            if (!modes.contains(
+                    static_cast<TerminalSim::TransportationMode>(layer)))
+            {
+                continue;
+            }
+            for (const auto &edge : it->second[layer])
+            {
+                visit(edge);
+            }
         }
-        return it->second;
     }
 
     /**
@@ -323,10 +384,10 @@ public:
         qCDebug(lcGraph) << "Graph with" << vertexCount() << "vertices and"
                          << edgeCount() << "edges";
 
-        for (const auto &[source, edges] : m_adjacencyList)
+        for (const auto &source : m_vertices)
         {
             qCDebug(lcGraph) << "Vertex" << source << "connections:";
-            for (const auto &edge : edges)
+            for (const auto &edge : outgoingEdges(source))
             {
                 if (detailed)
                 {
@@ -341,7 +402,16 @@ public:
     }
 
 private:
-    std::unordered_map<VertexIdType, std::vector<EdgeType>> m_adjacencyList;
+    static constexpr int ModeLayerCount =
+        TerminalSim::TransportationModeMask::ModeCount;
+    using AdjacencyLayers = std::array<std::vector<EdgeType>, ModeLayerCount>;
+
+    static size_t layerIndex(TerminalSim::TransportationMode mode)
+    {
+        return static_cast<size_t>(mode);
+    }
+
+    std::unordered_map<VertexIdType, AdjacencyLayers> m_adjacencyList;
     std::set<VertexIdType>                                  m_vertices;
     std::set<
         std::tuple<VertexIdType, VertexIdType, TerminalSim::TransportationMode>>
@@ -0,0 +1,273 @@
+#pragma once
+
+#include "Graph.h"
+#include "common/LogCategories.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GraphLib
+{
+
+/**
+ * @brief Exact distance oracle built with pruned landmark labeling
+ *
+ * Every vertex stores an outgoing label of (hub, dist(vertex, hub)) entries
+ * and an incoming label of (hub, dist(hub, vertex)) entries, both sorted by
+ * hub rank. A distance query is a single linear merge of the source's
+ * outgoing label with the target's incoming label, so it costs O(label size)
+ * instead of a full Dijkstra run. Hubs are ranked by degree so that the
+ * best-connected terminals cover most shortest paths and labels stay short.
+ */
+template <typename VertexIdType, typename WeightType> class HubLabels
+{
+public:
+    using GraphType = Graph<VertexIdType, WeightType>;
+
+    HubLabels() = default;
+
+    /**
+     * @brief Build the labels for a graph
+     * @param graph Input graph
+     * @param modes Transportation modes whose edges are labelled (Any by
+     * default)
+     * @return Fully built label index
+     */
+    static HubLabels build(const GraphType                    &graph,
+                           TerminalSim::TransportationModeMask modes =
+                               TerminalSim::TransportationMode::Any)
+    {
+        HubLabels labels;
+
+        const size_t vertexCount = graph.vertexCount();
+        std::vector<VertexIdType> vertexIds;
+        vertexIds.reserve(vertexCount);
+        for (const auto &vertex : graph.vertices())
+        {
+            labels.m_index.emplace(vertex, static_cast<int>(vertexIds.size()));
+            vertexIds.push_back(vertex);
+        }
+
+        // Dense forward and reverse adjacency keyed by vertex index
+        Adjacency forward(vertexCount);
+        Adjacency backward(vertexCount);
+        for (size_t i = 0; i < vertexIds.size(); ++i)
+        {
+            graph.forEachOutgoingEdge(vertexIds[i], modes, [&](const auto &edge) {
+                const int target = labels.m_index.at(edge.target());
+                forward[i].emplace_back(target, edge.weight());
+                backward[target].emplace_back(static_cast<int>(i),
+                                              edge.weight());
+            });
+        }
+
+        // Rank hubs by total degree, ties broken by vertex order so that the
+        // same topology always produces the same labels
+        std::vector<int> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return forward[a].size() + backward[a].size()
+                   > forward[b].size() + backward[b].size();
+        });
+
+        labels.m_outLabels.assign(vertexCount, Label());
+        labels.m_inLabels.assign(vertexCount, Label());
+
+        std::vector<WeightType> distance(vertexCount, infinity());
+        for (size_t rank = 0; rank < order.size(); ++rank)
+        {
+            labels.prunedSearch(static_cast<int>(rank), order[rank], forward,
+                                true, distance);
+            labels.prunedSearch(static_cast<int>(rank), order[rank], backward,
+                                false, distance);
+        }
+
+        qCDebug(lcGraph) << "Built hub labels for" << vertexCount
+                         << "vertices with" << labels.labelEntryCount()
+                         << "label entries";
+        return labels;
+    }
+
+    /**
+     * @brief Query the shortest-path distance between two vertices
+     * @param source Source vertex id
+     * @param target Target vertex id
+     * @return Distance or std::nullopt if either vertex is unknown or the
+     * target is unreachable
+     */
+    std::optional<WeightType> distance(const VertexIdType &source,
+                                       const VertexIdType &target) const
+    {
+        auto sourceIt = m_index.find(source);
+        auto targetIt = m_index.find(target);
+        if (sourceIt == m_index.end() || targetIt == m_index.end())
+        {
+            return std::nullopt;
+        }
+
+        if (sourceIt->second == targetIt->second)
+        {
+            return WeightType(0);
+        }
+
+        const WeightType result = mergeLabels(m_outLabels[sourceIt->second],
+                                              m_inLabels[targetIt->second]);
+        if (result == infinity())
+        {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Get number of labelled vertices
+     * @return Vertex count
+     */
+    size_t vertexCount() const
+    {
+        return m_index.size();
+    }
+
+    /**
+     * @brief Get total number of entries over all labels
+     * @return Sum of outgoing and incoming label sizes
+     */
+    size_t labelEntryCount() const
+    {
+        size_t count = 0;
+        for (const auto &label : m_outLabels)
+        {
+            count += label.size();
+        }
+        for (const auto &label : m_inLabels)
+        {
+            count += label.size();
+        }
+        return count;
+    }
+
+private:
+    struct LabelEntry
+    {
+        int        hub;
+        WeightType distance;
+    };
+    using Label     = std::vector<LabelEntry>;
+    using Adjacency = std::vector<std::vector<std::pair<int, WeightType>>>;
+
+    static WeightType infinity()
+    {
+        return std::numeric_limits<WeightType>::max();
+    }
+
+    /**
+     * @brief Merge two rank-sorted labels and return the best meeting hub
+     * @param outLabel Outgoing label of the source
+     * @param inLabel Incoming label of the target
+     * @return Shortest distance through a common hub, or infinity
+     */
+    static WeightType mergeLabels(const Label &outLabel, const Label &inLabel)
+    {
+        WeightType best = infinity();
+        size_t     i    = 0;
+        size_t     j    = 0;
+        while (i < outLabel.size() && j < inLabel.size())
+        {
+            if (outLabel[i].hub == inLabel[j].hub)
+            {
+                best = std::min(best,
+                                outLabel[i].distance + inLabel[j].distance);
+                ++i;
+                ++j;
+            }
+            else if (outLabel[i].hub < inLabel[j].hub)
+            {
+                ++i;
+            }
+            else
+            {
+                ++j;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief Run one pruned Dijkstra from a hub
+     * @param rank Rank of the hub, recorded in the label entries
+     * @param hub Vertex index of the hub
+     * @param adjacency Forward adjacency fills incoming labels, reverse
+     * adjacency fills outgoing labels
+     * @param forwardSearch true when searching along edge direction
+     * @param distance Scratch distances, all infinity on entry and on exit
+     */
+    void prunedSearch(int rank, int hub, const Adjacency &adjacency,
+                      bool forwardSearch, std::vector<WeightType> &distance)
+    {
+        using QueueItem = std::pair<WeightType, int>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>,
+                            std::greater<QueueItem>>
+                         pq;
+        std::vector<int> touched;
+
+        distance[hub] = 0;
+        touched.push_back(hub);
+        pq.push(std::make_pair(WeightType(0), hub));
+
+        while (!pq.empty())
+        {
+            auto [dist, current] = pq.top();
+            pq.pop();
+
+            if (dist > distance[current])
+            {
+                continue;
+            }
+
+            // Prune when higher-ranked hubs already cover this pair
+            const WeightType covered =
+                forwardSearch
+                    ? mergeLabels(m_outLabels[hub], m_inLabels[current])
+                    : mergeLabels(m_outLabels[current], m_inLabels[hub]);
+            if (covered <= dist)
+            {
+                continue;
+            }
+
+            Label &label =
+                forwardSearch ? m_inLabels[current] : m_outLabels[current];
+            label.push_back(LabelEntry{rank, dist});
+
+            for (const auto &[next, weight] : adjacency[current])
+            {
+                const WeightType newDist = dist + weight;
+                if (newDist < distance[next])
+                {
+                    if (distance[next] == infinity())
+                    {
+                        touched.push_back(next);
+                    }
+                    distance[next] = newDist;
+                    pq.push(std::make_pair(newDist, next));
+                }
+            }
+        }
+
+        for (int vertex : touched)
+        {
+            distance[vertex] = infinity();
+        }
+    }
+
+    std::unordered_map<VertexIdType, int> m_index;
+    std::vector<Label>                    m_outLabels;
+    std::vector<Label>                    m_inLabels;
+};
+
+} // namespace GraphLib
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace GraphLib
+{
+
+/**
+ * @brief Scratch memory for the bookkeeping of one search
+ *
+ * Distance and predecessor maps, visited sets and queues of a search are
+ * allocated from a monotonic buffer. It starts in an inline block and
+ * grows from the heap in doubling chunks. Nothing is freed one node at a
+ * time; everything is released at once when the arena goes out of scope.
+ *
+ * An arena is not thread safe. Each search owns one, so concurrent spur
+ * searches never share it. Results handed back to the caller must not
+ * point into the arena.
+ */
+class SearchArena
+{
+public:
+    SearchArena() = default;
+
+    SearchArena(const SearchArena &)            = delete;
+    SearchArena &operator=(const SearchArena &) = delete;
+
+    std::pmr::memory_resource *resource() { return &m_resource; }
+
+private:
+    // Enough for a search over a few hundred terminals without touching
+    // the heap
+    static constexpr std::size_t InlineBytes = 16 * 1024;
+
+    alignas(std::max_align_t) std::byte m_inline[InlineBytes];
+    std::pmr::monotonic_buffer_resource m_resource{m_inline, InlineBytes};
+};
+
+} // namespace GraphLib
@@ -0,0 +1,401 @@
+#pragma once
+
+#include "ClosureOverlay.h"
+#include "Graph.h"
+#include "common/LogCategories.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GraphLib
+{
+
+/**
+ * @brief Static user-equilibrium assignment with the Frank-Wolfe algorithm
+ *
+ * Edge costs depend on the flows of the whole network through a caller
+ * supplied function. Each iteration prices the edges at the current flows,
+ * loads every demand onto its cheapest path (all-or-nothing), and moves the
+ * flows towards that loading by the step that minimises the Beckmann
+ * objective. The all-or-nothing step runs one shortest-path tree per origin
+ * and origins are independent, so they may be spread over threads. Path
+ * flows are carried along as the same convex combination as edge flows.
+ */
+template <typename VertexIdType, typename WeightType> class TrafficAssignment
+{
+public:
+    using GraphType          = Graph<VertexIdType, WeightType>;
+    using EdgeType           = typename GraphType::EdgeType;
+    using ClosureOverlayType = ClosureOverlay<VertexIdType>;
+
+    /**
+     * @brief Volume to move from one vertex to another
+     */
+    struct Demand
+    {
+        VertexIdType origin;
+        VertexIdType destination;
+        WeightType   volume;
+    };
+
+    /**
+     * @brief Fill costs from flows, both indexed like edges()
+     */
+    using CostFunction = std::function<void(const std::vector<WeightType> &flows,
+                                            std::vector<WeightType> &costs)>;
+
+    /**
+     * @brief Run task(0) .. task(count - 1), possibly concurrently
+     */
+    using ParallelFor =
+        std::function<void(size_t count,
+                           const std::function<void(size_t)> &task)>;
+
+    struct PathFlow
+    {
+        std::vector<size_t> edges; ///< Indexes into edges()
+        WeightType          flow;
+    };
+
+    struct Result
+    {
+        std::vector<WeightType>            flows; ///< By edge index
+        std::vector<WeightType>            costs; ///< At the final flows
+        std::vector<std::vector<PathFlow>> paths; ///< By demand index
+        std::vector<size_t> unassigned; ///< Demands with no path
+        int                 iterations  = 0;
+        WeightType          relativeGap = WeightType(0);
+        bool                converged   = false;
+    };
+
+    /**
+     * @brief Index the usable edges of a graph
+     * @param graph Input graph; only read during construction
+     * @param modes Transportation modes whose edges may carry flow
+     * @param closures Closed vertices and edges to leave out
+     */
+    explicit TrafficAssignment(const GraphType                    &graph,
+                               TerminalSim::TransportationModeMask modes =
+                                   TerminalSim::TransportationMode::Any,
+                               const ClosureOverlayType *closures = nullptr)
+    {
+        for (const auto &vertex : graph.vertices())
+        {
+            m_index.emplace(vertex, static_cast<int>(m_index.size()));
+        }
+
+        m_outgoing.assign(m_index.size(), {});
+        for (const auto &vertex : graph.vertices())
+        {
+            graph.forEachOutgoingEdge(vertex, modes, [&](const EdgeType &edge) {
+                if (closures != nullptr && closures->blocks(edge))
+                {
+                    return;
+                }
+                m_outgoing[m_index.at(vertex)].push_back(m_edges.size());
+                m_sources.push_back(m_index.at(edge.source()));
+                m_targets.push_back(m_index.at(edge.target()));
+                m_edges.push_back(edge);
+            });
+        }
+    }
+
+    /**
+     * @brief Edges that may carry flow, in flow index order
+     */
+    const std::vector<EdgeType> &edges() const
+    {
+        return m_edges;
+    }
+
+    /**
+     * @brief Assign demands until the relative gap falls below a tolerance
+     * @param demands Volumes to assign
+     * @param costFunction Edge costs at given flows; must be non-negative
+     * and non-decreasing in flow for the equilibrium to be unique
+     * @param maxIterations Upper bound on Frank-Wolfe iterations
+     * @param gapTolerance Stop once (TSTT - SPTT) / TSTT is at most this
+     * @param parallelFor Runs the per-origin shortest-path trees; sequential
+     * when not given
+     * @return Equilibrium edge flows, costs and path flows
+     */
+    Result solve(const std::vector<Demand> &demands,
+                 const CostFunction &costFunction, int maxIterations,
+                 WeightType gapTolerance,
+                 const ParallelFor &parallelFor = {}) const
+    {
+        Result result;
+        result.flows.assign(m_edges.size(), WeightType(0));
+        result.costs.assign(m_edges.size(), WeightType(0));
+        result.paths.assign(demands.size(), {});
+
+        // Group demands by origin so each origin needs one tree
+        std::vector<int>                 origins;
+        std::vector<std::vector<size_t>> demandsByOrigin;
+        std::unordered_map<int, size_t>  originSlot;
+        for (size_t i = 0; i < demands.size(); ++i)
+        {
+            auto originIt      = m_index.find(demands[i].origin);
+            auto destinationIt = m_index.find(demands[i].destination);
+            if (originIt == m_index.end() || destinationIt == m_index.end()
+                || demands[i].volume <= WeightType(0))
+            {
+                continue;
+            }
+
+            auto [slot, inserted] =
+                originSlot.emplace(originIt->second, origins.size());
+            if (inserted)
+            {
+                origins.push_back(originIt->second);
+                demandsByOrigin.emplace_back();
+            }
+            demandsByOrigin[slot->second].push_back(i);
+        }
+
+        costFunction(result.flows, result.costs);
+        std::vector<std::optional<std::vector<size_t>>> loading =
+            allOrNothing(demands, origins, demandsByOrigin, result.costs,
+                         parallelFor);
+
+        // The first loading is the starting point
+        for (size_t i = 0; i < demands.size(); ++i)
+        {
+            if (!loading[i].has_value())
+            {
+                result.unassigned.push_back(i);
+                continue;
+            }
+            for (size_t edge : *loading[i])
+            {
+                result.flows[edge] += demands[i].volume;
+            }
+            result.paths[i].push_back(
+                PathFlow{std::move(*loading[i]), demands[i].volume});
+        }
+
+        std::vector<WeightType> target(m_edges.size());
+        std::vector<WeightType> direction(m_edges.size());
+        std::vector<WeightType> trial(m_edges.size());
+        std::vector<WeightType> trialCosts(m_edges.size());
+        for (int iteration = 1; iteration <= maxIterations; ++iteration)
+        {
+            result.iterations = iteration;
+            costFunction(result.flows, result.costs);
+            loading = allOrNothing(demands, origins, demandsByOrigin,
+                                   result.costs, parallelFor);
+
+            std::fill(target.begin(), target.end(), WeightType(0));
+            for (size_t i = 0; i < demands.size(); ++i)
+            {
+                if (!loading[i].has_value() || result.paths[i].empty())
+                {
+                    continue;
+                }
+                for (size_t edge : *loading[i])
+                {
+                    target[edge] += demands[i].volume;
+                }
+            }
+
+            WeightType totalCost    = WeightType(0);
+            WeightType shortestCost = WeightType(0);
+            for (size_t e = 0; e < m_edges.size(); ++e)
+            {
+                totalCost += result.costs[e] * result.flows[e];
+                shortestCost += result.costs[e] * target[e];
+                direction[e] = target[e] - result.flows[e];
+            }
+            result.relativeGap = totalCost > WeightType(0)
+                                     ? (totalCost - shortestCost) / totalCost
+                                     : WeightType(0);
+            if (result.relativeGap <= gapTolerance)
+            {
+                result.converged = true;
+                break;
+            }
+
+            // Bisection on the derivative of the Beckmann objective along
+            // the direction, which is sum(cost(x + step * d) * d)
+            WeightType low  = WeightType(0);
+            WeightType high = WeightType(1);
+            for (int step = 0; step < 30; ++step)
+            {
+                const WeightType middle = (low + high) / WeightType(2);
+                for (size_t e = 0; e < m_edges.size(); ++e)
+                {
+                    trial[e] = result.flows[e] + middle * direction[e];
+                }
+                costFunction(trial, trialCosts);
+
+                WeightType slope = WeightType(0);
+                for (size_t e = 0; e < m_edges.size(); ++e)
+                {
+                    slope += trialCosts[e] * direction[e];
+                }
+                (slope > WeightType(0) ? high : low) = middle;
+            }
+            const WeightType stepSize = (low + high) / WeightType(2);
+
+            for (size_t e = 0; e < m_edges.size(); ++e)
+            {
+                result.flows[e] += stepSize * direction[e];
+            }
+            for (size_t i = 0; i < demands.size(); ++i)
+            {
+                if (!loading[i].has_value() || result.paths[i].empty())
+                {
+                    continue;
+                }
+                addPathFlow(result.paths[i], std::move(*loading[i]),
+                            demands[i].volume, stepSize);
+            }
+        }
+
+        costFunction(result.flows, result.costs);
+
+        qCDebug(lcGraph) << "Traffic assignment finished after"
+                         << result.iterations << "iterations with gap"
+                         << result.relativeGap;
+        return result;
+    }
+
+private:
+    std::vector<std::optional<std::vector<size_t>>>
+    allOrNothing(const std::vector<Demand>              &demands,
+                 const std::vector<int>                 &origins,
+                 const std::vector<std::vector<size_t>> &demandsByOrigin,
+                 const std::vector<WeightType>          &costs,
+                 const ParallelFor                      &parallelFor) const
+    {
+        std::vector<std::optional<std::vector<size_t>>> paths(demands.size());
+
+        // Every task writes only the entries of its own demands
+        auto task = [&](size_t slot) {
+            const std::vector<size_t> previous =
+                shortestPathTree(origins[slot], costs);
+            for (size_t demand : demandsByOrigin[slot])
+            {
+                const int destination =
+                    m_index.at(demands[demand].destination);
+                std::vector<size_t> path;
+                int vertex = destination;
+                while (vertex != origins[slot])
+                {
+                    const size_t edge = previous[vertex];
+                    if (edge == noEdge())
+                    {
+                        break;
+                    }
+                    path.push_back(edge);
+                    vertex = m_sources[edge];
+                }
+                if (vertex == origins[slot])
+                {
+                    std::reverse(path.begin(), path.end());
+                    paths[demand] = std::move(path);
+                }
+            }
+        };
+
+        if (parallelFor)
+        {
+            parallelFor(origins.size(), task);
+        }
+        else
+        {
+            for (size_t slot = 0; slot < origins.size(); ++slot)
+            {
+                task(slot);
+            }
+        }
+        return paths;
+    }
+
+    std::vector<size_t> shortestPathTree(int                            origin,
+                                         const std::vector<WeightType> &costs) const
+    {
+        using QueueItem = std::pair<WeightType, int>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>,
+                            std::greater<QueueItem>>
+            pq;
+        std::vector<WeightType> distance(m_index.size(),
+                                         std::numeric_limits<WeightType>::max());
+        std::vector<size_t>     previous(m_index.size(), noEdge());
+
+        distance[origin] = WeightType(0);
+        pq.push(std::make_pair(WeightType(0), origin));
+        while (!pq.empty())
+        {
+            auto [dist, current] = pq.top();
+            pq.pop();
+            if (dist > distance[current])
+            {
+                continue;
+            }
+
+            for (size_t edge : m_outgoing[current])
+            {
+                const int        next    = m_targets[edge];
+                const WeightType newDist = dist + costs[edge];
+                if (newDist < distance[next])
+                {
+                    distance[next] = newDist;
+                    previous[next] = edge;
+                    pq.push(std::make_pair(newDist, next));
+                }
+            }
+        }
+        return previous;
+    }
+
+    static void addPathFlow(std::vector<PathFlow> &paths,
+                            std::vector<size_t> edges, WeightType volume,
+                            WeightType stepSize)
+    {
+        for (PathFlow &path : paths)
+        {
+            path.flow *= WeightType(1) - stepSize;
+        }
+
+        auto it = std::find_if(paths.begin(), paths.end(),
+                               [&edges](const PathFlow &path) {
+                                   return path.edges == edges;
+                               });
+        if (it != paths.end())
+        {
+            it->flow += stepSize * volume;
+        }
+        else if (stepSize > WeightType(0))
+        {
+            paths.push_back(PathFlow{std::move(edges), stepSize * volume});
+        }
+
+        // Drop paths whose share has decayed to nothing
+        const WeightType negligible = volume * WeightType(1e-9);
+        paths.erase(std::remove_if(paths.begin(), paths.end(),
+                                   [negligible](const PathFlow &path) {
+                                       return path.flow <= negligible;
+                                   }),
+                    paths.end());
+    }
+
+    static constexpr size_t noEdge()
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    std::unordered_map<VertexIdType, int> m_index;
+    std::vector<EdgeType>                 m_edges;
+    std::vector<int>                      m_sources; ///< By edge index
+    std::vector<int>                      m_targets; ///< By edge index
+    std::vector<std::vector<size_t>>      m_outgoing; ///< Edge indexes
+};
+
+} // namespace GraphLib
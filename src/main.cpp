@@ -11,6 +11,7 @@
 
 #include "common/LogCategories.h"
 #include "common/LogMessageHandler.h"
+#include "common/ProfiledMutex.h"
 #include "common/TerminalSimLogger.h"
 #include "server/terminal_graph_server.h"
 
@@ -58,17 +59,6 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationName("TerminalSim");
     QCoreApplication::setApplicationVersion("1.0.0");
 
-    const QString uniqueServerName = "TerminalSimServerInstance";
-
-    if (isAnotherInstanceRunning(uniqueServerName))
-    {
-        qCCritical(lcInit) << "Another instance of TerminalSim "
-                              "Server is already running.";
-        return EXIT_FAILURE;
-    }
-
-    createLocalServer(uniqueServerName);
-
     QCommandLineParser parser;
     parser.setApplicationDescription("TerminalSim Server");
     parser.addHelpOption();
@@ -92,6 +82,30 @@ int main(int argc, char *argv[])
     QCommandLineOption loadGraphOption(
         QStringList() << "l" << "load",
         "Load graph from file", "file");
+    QCommandLineOption shardIndexOption(
+        QStringList() << "shard-index",
+        "Shard served by this process", "index", "0");
+    QCommandLineOption shardCountOption(
+        QStringList() << "shard-count",
+        "Number of shards terminals are partitioned over", "count", "1");
+    QCommandLineOption roleOption(
+        QStringList() << "role",
+        "Replication role: standalone, primary or replica", "role",
+        "standalone");
+    QCommandLineOption replicateRuntimeOption(
+        QStringList() << "replicate-runtime",
+        "Primary also streams container and system dynamics commands");
+    QCommandLineOption maxStalenessOption(
+        QStringList() << "max-staleness-ms",
+        "Replica refuses reads when staler than this; 0 never refuses",
+        "ms", "0");
+    QCommandLineOption workerThreadsOption(
+        QStringList() << "worker-threads",
+        "Threads for parallel command work; 0 uses one per core",
+        "count", "0");
+    QCommandLineOption profileLocksOption(
+        QStringList() << "profile-locks",
+        "Record lock contention from startup; see get_lock_profile");
 
     parser.addOption(rabbitHostOption);
     parser.addOption(rabbitPortOption);
@@ -99,6 +113,13 @@ int main(int argc, char *argv[])
     parser.addOption(rabbitPasswordOption);
     parser.addOption(dataPathOption);
     parser.addOption(loadGraphOption);
+    parser.addOption(shardIndexOption);
+    parser.addOption(shardCountOption);
+    parser.addOption(roleOption);
+    parser.addOption(replicateRuntimeOption);
+    parser.addOption(maxStalenessOption);
+    parser.addOption(workerThreadsOption);
+    parser.addOption(profileLocksOption);
 
     parser.process(app);
 
@@ -108,6 +129,57 @@ int main(int argc, char *argv[])
     const QString rabbitPassword = parser.value(rabbitPasswordOption);
     const QString dataPath       = parser.value(dataPathOption);
     const QString loadGraphFile  = parser.value(loadGraphOption);
+    const int     shardIndex     = parser.value(shardIndexOption).toInt();
+    const int     shardCount     = parser.value(shardCountOption).toInt();
+    const int     workerThreads  = parser.value(workerThreadsOption).toInt();
+
+    if (shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount)
+    {
+        qCCritical(lcInit) << "Invalid shard" << shardIndex << "of"
+                           << shardCount;
+        return EXIT_FAILURE;
+    }
+
+    if (workerThreads < 0)
+    {
+        qCCritical(lcInit) << "Invalid worker thread count" << workerThreads;
+        return EXIT_FAILURE;
+    }
+
+    const QString roleName = parser.value(roleOption).toLower();
+    TerminalSim::ReplicationRole role = TerminalSim::ReplicationRole::Standalone;
+    if (roleName == "primary")
+        role = TerminalSim::ReplicationRole::Primary;
+    else if (roleName == "replica")
+        role = TerminalSim::ReplicationRole::Replica;
+    else if (roleName != "standalone")
+    {
+        qCCritical(lcInit) << "Unknown role:" << roleName;
+        return EXIT_FAILURE;
+    }
+    if (role != TerminalSim::ReplicationRole::Standalone && shardCount > 1)
+    {
+        qCCritical(lcInit) << "Replication and sharding cannot be combined";
+        return EXIT_FAILURE;
+    }
+
+    // One process per shard and host; shards of a deployment may share one.
+    // Replicas hold no state of their own, so any number may run.
+    const QString uniqueServerName = shardCount > 1
+        ? QString("TerminalSimServerInstance.Shard.%1").arg(shardIndex)
+        : QString("TerminalSimServerInstance");
+
+    if (role != TerminalSim::ReplicationRole::Replica)
+    {
+        if (isAnotherInstanceRunning(uniqueServerName))
+        {
+            qCCritical(lcInit) << "Another instance of TerminalSim "
+                                  "Server is already running.";
+            return EXIT_FAILURE;
+        }
+
+        createLocalServer(uniqueServerName);
+    }
 
     QDir dataDir(dataPath);
     if (!dataDir.exists())
@@ -126,8 +198,16 @@ int main(int argc, char *argv[])
     qCDebug(lcInit) << "RabbitMQ Port:" << rabbitPort;
     qCDebug(lcInit) << "Data Path:"     << dataPath;
 
+    if (parser.isSet(profileLocksOption))
+        TerminalSim::LockProfiler::getInstance()->setEnabled(true);
+
     TerminalSim::TerminalGraphServer *server =
         TerminalSim::TerminalGraphServer::getInstance(dataPath);
+    server->setWorkerThreads(workerThreads);
+    server->setShard(shardIndex, shardCount);
+    server->setReplication(TerminalSim::ReplicationStream(
+        role, parser.isSet(replicateRuntimeOption),
+        parser.value(maxStalenessOption).toLongLong()));
 
     if (!server->initialize(rabbitHost, rabbitPort,
                             rabbitUser, rabbitPassword))
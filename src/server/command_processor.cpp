@@ -5,9 +5,13 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QScopeGuard>
 #include <QUuid>
 #include <containerLib/containermap.h>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 
@@ -191,6 +195,25 @@ std::optional<double> optionalDoubleParam(const QVariantMap &params,
     return std::nullopt;
 }
 
+std::optional<int> optionalIntParam(const QVariantMap &params,
+                                    const QString     &key,
+                                    const QString     &context)
+{
+    if (!params.contains(key))
+        return std::nullopt;
+
+    bool ok = false;
+    const int parsed = params.value(key).toInt(&ok);
+    if (!ok)
+    {
+        throw std::invalid_argument(
+            QString("Invalid integer value for %1")
+                .arg(context)
+                .toStdString());
+    }
+    return parsed;
+}
+
 TerminalSim::TerminalArrivalSemantics parseArrivalSemanticsText(
     const QString &value)
 {
@@ -278,6 +301,39 @@ TerminalSim::TransportationMode parseModeParam(const QVariant &value,
     return mode;
 }
 
+TerminalSim::TransportationModeMask parseModeSetParam(const QVariant &value,
+                                                      const QString  &context)
+{
+    // A list of modes, a "Truck|Train" string or a single mode
+    TerminalSim::TransportationModeMask modes;
+    if (value.typeId() == QMetaType::QVariantList
+        || value.typeId() == QMetaType::QStringList)
+    {
+        for (const QVariant &entry : value.toList())
+        {
+            modes = modes | parseModeParam(entry, true, context);
+        }
+    }
+    else if (value.typeId() == QMetaType::QString)
+    {
+        modes = TerminalSim::EnumUtils::parseTransportationModeMask(
+            value.toString());
+    }
+    else
+    {
+        modes = parseModeParam(value, true, context);
+    }
+
+    if (modes.isEmpty())
+    {
+        throw std::invalid_argument(
+            QString("Empty transportation mode set for %1")
+                .arg(context)
+                .toStdString());
+    }
+    return modes;
+}
+
 QVariantMap criteriaMapFromParams(const QVariantMap &params)
 {
     if (!params.contains(QStringLiteral("criteria")))
@@ -391,6 +447,27 @@ ContainerSelectionCriteria containerSelectionCriteriaFromParams(
     return criteria;
 }
 
+// Parameters a replica needs to repeat a command exactly, including the
+// IDs the primary minted when the client left them out
+QJsonObject replicatedParams(const QString     &command,
+                             const QVariantMap &params,
+                             const QVariant    &result)
+{
+    QJsonObject replicated = QJsonObject::fromVariantMap(params);
+    const QVariantMap resultMap = result.toMap();
+    if (command == QStringLiteral("fork_scenario"))
+    {
+        replicated[QStringLiteral("new_scenario_id")] =
+            resultMap.value(QStringLiteral("scenario_id")).toString();
+    }
+    else if (resultMap.contains(QStringLiteral("closure_id")))
+    {
+        replicated[QStringLiteral("closure_id")] =
+            resultMap.value(QStringLiteral("closure_id")).toString();
+    }
+    return replicated;
+}
+
 } // namespace
 
 namespace TerminalSim
@@ -398,6 +475,7 @@ namespace TerminalSim
 
 CommandProcessor::CommandProcessor(TerminalGraph *graph, QObject *parent)
     : QObject(parent)
+    , m_baseGraph(graph)
     , m_graph(graph)
 {
     registerCommands();
@@ -421,11 +499,32 @@ void CommandProcessor::registerCommands()
         return handleResetServer(params);
     });
 
+    // Lock contention of this process; the report covers the time before
+    // any reset or enabled change in the same call
+    registerCommand("get_lock_profile", [](const QVariantMap &params) {
+        LockProfiler *profiler = LockProfiler::getInstance();
+        QJsonObject   response = profiler->report();
+        if (params.value("reset", false).toBool())
+            profiler->reset();
+        if (params.contains("enabled"))
+            profiler->setEnabled(params.value("enabled").toBool());
+        response["enabled"] = LockProfiler::isEnabled();
+        return response;
+    });
+
     registerCommand("set_cost_function_parameters",
                     [this](const QVariantMap &params) {
                         return handleSetCostFunctionParameters(params);
                     });
 
+    // Scenario commands
+    registerCommand("fork_scenario", [this](const QVariantMap &params) {
+        return handleForkScenario(params);
+    });
+    registerCommand("drop_scenario", [this](const QVariantMap &params) {
+        return handleDropScenario(params);
+    });
+
     // Terminal commands
     registerCommand("add_terminal", [this](const QVariantMap &params) {
         return handleAddTerminal(params);
@@ -490,6 +589,9 @@ void CommandProcessor::registerCommands()
     registerCommand("add_routes", [this](const QVariantMap &params) {
         return handleAddRoutes(params);
     });
+    registerCommand("set_route_timetable", [this](const QVariantMap &params) {
+        return handleSetRouteTimetable(params);
+    });
 
     // Path finding commands
     registerCommand("find_shortest_path", [this](const QVariantMap &params) {
@@ -498,6 +600,58 @@ void CommandProcessor::registerCommands()
     registerCommand("find_top_paths", [this](const QVariantMap &params) {
         return handleFindTopPaths(params);
     });
+    registerCommand("evaluate_path_distribution",
+                    [this](const QVariantMap &params) {
+        return handleEvaluatePathDistribution(params);
+    });
+    registerCommand("sweep_top_paths", [this](const QVariantMap &params) {
+        return handleSweepTopPaths(params);
+    });
+    registerCommand("route_containers", [this](const QVariantMap &params) {
+        return handleRouteContainers(params);
+    });
+    registerCommand("find_constrained_path", [this](const QVariantMap &params) {
+        return handleFindConstrainedPath(params);
+    });
+    registerCommand("get_distance", [this](const QVariantMap &params) {
+        return handleGetDistance(params);
+    });
+    registerCommand("find_reachable_terminals",
+                    [this](const QVariantMap &params) {
+                        return handleFindReachableTerminals(params);
+                    });
+    registerCommand("find_earliest_arrival", [this](const QVariantMap &params) {
+        return handleFindEarliestArrival(params);
+    });
+    registerCommand("find_arrival_profile", [this](const QVariantMap &params) {
+        return handleFindArrivalProfile(params);
+    });
+    registerCommand("assign_traffic", [this](const QVariantMap &params) {
+        return handleAssignTraffic(params);
+    });
+
+    // Disruption overlay commands
+    registerCommand("close_route", [this](const QVariantMap &params) {
+        return handleCloseRoute(params);
+    });
+    registerCommand("close_terminal", [this](const QVariantMap &params) {
+        return handleCloseTerminal(params);
+    });
+    registerCommand("reopen", [this](const QVariantMap &params) {
+        const QString closureId = params.value("closure_id").toString();
+        if (closureId.isEmpty())
+        {
+            throw std::invalid_argument("Missing closure_id parameter");
+        }
+
+        QJsonObject reopenJson;
+        reopenJson["closure_id"] = closureId;
+        reopenJson["reopened"]   = m_graph->reopen(closureId);
+        return QVariant(reopenJson);
+    });
+    registerCommand("get_closures", [this](const QVariantMap &) {
+        return QVariant(m_graph->getClosures());
+    });
 
     // Terminal container operations
     registerCommand("add_container", [this](const QVariantMap &params) {
@@ -848,11 +1002,29 @@ void CommandProcessor::registerCommands()
                 resolvedTerminalIds.append(terminalId);
         }
 
-        const QStringList responseTerminalIds = resolvedTerminalIds.isEmpty()
-            ? m_graph->getAllTerminalNames(false).keys()
-            : resolvedTerminalIds;
-        const int resetCount =
-            m_graph->resetRuntimeState(resolvedTerminalIds);
+        // A shard resets only the terminals it owns. Resetting all is an
+        // epoch bump, which costs nothing on the terminals it does not own.
+        const bool allTerminals = resolvedTerminalIds.isEmpty();
+        resolvedTerminalIds.erase(
+            std::remove_if(resolvedTerminalIds.begin(),
+                           resolvedTerminalIds.end(),
+                           [this](const QString &terminalId) {
+                               return !ownsTerminal(terminalId);
+                           }),
+            resolvedTerminalIds.end());
+
+        const QStringList responseTerminalIds =
+            allTerminals ? ownedTerminalNames() : resolvedTerminalIds;
+        int resetCount = 0;
+        if (allTerminals)
+        {
+            m_graph->resetRuntimeState({});
+            resetCount = static_cast<int>(responseTerminalIds.size());
+        }
+        else if (!resolvedTerminalIds.isEmpty())
+        {
+            resetCount = m_graph->resetRuntimeState(resolvedTerminalIds);
+        }
 
         QJsonObject response;
         response[QStringLiteral("terminals_reset")] = resetCount;
@@ -861,8 +1033,7 @@ void CommandProcessor::registerCommands()
             terminalIds.append(terminalId);
         response[QStringLiteral("terminal_ids")] = terminalIds;
         response[QStringLiteral("scope")] =
-            resolvedTerminalIds.isEmpty() ? QStringLiteral("all")
-                                          : QStringLiteral("selected");
+            allTerminals ? QStringLiteral("all") : QStringLiteral("selected");
         return response;
     });
 
@@ -899,22 +1070,38 @@ void CommandProcessor::registerCommands()
         double currentTime = params.value("current_time", 0.0).toDouble();
         double deltaT = params.value("delta_t", 3600.0).toDouble();  // seconds; 3600 = 1 hour
 
-        QJsonArray results;
-        QStringList terminalNames = m_graph->getAllTerminalNames(false).keys();
+        const QStringList terminalNames = ownedTerminalNames();
 
+        // Terminals update independently, so in-memory ones are stepped on
+        // the graph's pool; results are still reported in name order
+        QList<QPair<QString, Terminal*>> updated;
+        QList<Terminal*> pooled;
         for (const QString& terminalName : terminalNames)
         {
             Terminal* terminal = m_graph->getTerminal(terminalName);
             if (terminal && terminal->isSystemDynamicsEnabled())
             {
-                terminal->updateSystemDynamics(currentTime, deltaT);
-
-                QJsonObject terminalResult;
-                terminalResult["terminal_id"] = terminalName;
-                terminalResult["state"] = terminal->getSystemDynamicsState();
-                results.append(terminalResult);
+                updated.append({terminalName, terminal});
+                if (terminal->hasSqlStorage())
+                    terminal->updateSystemDynamics(currentTime, deltaT);
+                else
+                    pooled.append(terminal);
             }
         }
+        m_graph->taskPool()->parallelFor(
+            static_cast<size_t>(pooled.size()), [&](size_t i) {
+                pooled.at(static_cast<qsizetype>(i))
+                    ->updateSystemDynamics(currentTime, deltaT);
+            });
+
+        QJsonArray results;
+        for (const auto& [terminalName, terminal] : updated)
+        {
+            QJsonObject terminalResult;
+            terminalResult["terminal_id"] = terminalName;
+            terminalResult["state"] = terminal->getSystemDynamicsState();
+            results.append(terminalResult);
+        }
 
         QJsonObject response;
         response["terminals_updated"] = results.size();
@@ -922,6 +1109,10 @@ void CommandProcessor::registerCommands()
         return response;
     });
 
+    registerCommand("replicate_handling", [this](const QVariantMap &params) {
+        return handleReplicateHandling(params);
+    });
+
     registerCommand("get_terminals_runtime_state",
                     [this](const QVariantMap &params) {
         QVariantList terminalIds = params.value("terminal_ids").toList();
@@ -946,6 +1137,8 @@ void CommandProcessor::registerCommands()
                         .arg(terminalId)
                         .toStdString());
             }
+            if (!ownsTerminal(terminalId))
+                continue;
 
             results.append(terminal->getRuntimeTerminalSnapshot());
         }
@@ -980,6 +1173,8 @@ void CommandProcessor::registerCommands()
                         .arg(terminalId)
                         .toStdString());
             }
+            if (!ownsTerminal(terminalId))
+                continue;
 
             results.append(terminal->getRuntimeTerminalProjectionsByMode());
         }
@@ -1011,14 +1206,14 @@ void CommandProcessor::registerCommands()
         {
             for (const auto &terminalIdVar : terminalIds)
             {
-                if (!terminalIdVar.toString().isEmpty())
+                if (!terminalIdVar.toString().isEmpty()
+                    && ownsTerminal(terminalIdVar.toString()))
                     resolvedTerminalIds.append(terminalIdVar.toString());
             }
         }
         else
         {
-            resolvedTerminalIds =
-                m_graph->getAllTerminalNames(false).keys();
+            resolvedTerminalIds = ownedTerminalNames();
         }
 
         QJsonArray results;
@@ -1058,14 +1253,14 @@ void CommandProcessor::registerCommands()
         {
             for (const auto &terminalIdVar : terminalIds)
             {
-                if (!terminalIdVar.toString().isEmpty())
+                if (!terminalIdVar.toString().isEmpty()
+                    && ownsTerminal(terminalIdVar.toString()))
                     resolvedTerminalIds.append(terminalIdVar.toString());
             }
         }
         else
         {
-            resolvedTerminalIds =
-                m_graph->getAllTerminalNames(false).keys();
+            resolvedTerminalIds = ownedTerminalNames();
         }
 
         int cleared = 0;
@@ -1094,14 +1289,14 @@ void CommandProcessor::registerCommands()
 void CommandProcessor::registerCommand(const QString &command,
                                        CommandHandler handler)
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     m_commandHandlers[command] = handler;
 }
 
 QVariant CommandProcessor::processCommand(const QString     &command,
                                           const QVariantMap &params)
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
 
     qCDebug(lcCommandProcessor) << "Processing command:" << command;
 
@@ -1113,6 +1308,31 @@ QVariant CommandProcessor::processCommand(const QString     &command,
             QString("Unknown command: %1").arg(command).toStdString());
     }
 
+    // A replica serves reads only; its network follows the primary
+    m_replication.checkReadable(command,
+                                QDateTime::currentMSecsSinceEpoch());
+
+    QVariant result = executeCommandLocked(command, params);
+
+    if (m_replication.records(command))
+    {
+        emit mutationRecorded(m_replication.recordMutation(
+            command, replicatedParams(command, params, result),
+            QDateTime::currentMSecsSinceEpoch()));
+    }
+    return result;
+}
+
+QVariant CommandProcessor::executeCommandLocked(const QString     &command,
+                                                const QVariantMap &params)
+{
+    // Run against the scenario named in the params, else the base graph.
+    // The reference keeps a dropped scenario alive until the command ends.
+    const std::shared_ptr<TerminalGraph> scenario =
+        getScenarioFromParams(params);
+    m_graph = scenario ? scenario.get() : m_baseGraph;
+    const auto restoreGraph = qScopeGuard([this] { m_graph = m_baseGraph; });
+
     // Execute command handler
     try
     {
@@ -1134,6 +1354,47 @@ QVariant CommandProcessor::processCommand(const QString     &command,
     }
 }
 
+void CommandProcessor::setReplication(const ReplicationStream &replication)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    m_replication = replication;
+}
+
+QJsonObject CommandProcessor::replicationHeartbeat() const
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    return m_replication.heartbeat(QDateTime::currentMSecsSinceEpoch());
+}
+
+bool CommandProcessor::applyReplicatedMutation(const QJsonObject &record)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+
+    if (!m_replication.admit(record, QDateTime::currentMSecsSinceEpoch()))
+        return false;
+
+    const QString command = record.value("command").toString();
+    try
+    {
+        if (!m_commandHandlers.contains(command))
+        {
+            throw std::invalid_argument(
+                QString("Unknown command: %1").arg(command).toStdString());
+        }
+        executeCommandLocked(command,
+                             record.value("params").toObject().toVariantMap());
+    }
+    catch (const std::exception &)
+    {
+        // The primary applied it, so the networks no longer match
+        m_replication.markOutOfSync();
+        throw;
+    }
+
+    m_replication.markApplied(record, QDateTime::currentMSecsSinceEpoch());
+    return true;
+}
+
 QJsonObject
 CommandProcessor::processJsonCommand(const QJsonObject &commandObject)
 {
@@ -1201,6 +1462,16 @@ CommandProcessor::processJsonCommand(const QJsonObject &commandObject)
         // The event name remains in the response even for errors
     }
 
+    // Lets clients see how far a replica's answer may lag the primary
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        if (m_replication.role() != ReplicationRole::Standalone)
+        {
+            response["replication"] = m_replication.status(
+                QDateTime::currentMSecsSinceEpoch());
+        }
+    }
+
     return response;
 }
 
@@ -1241,10 +1512,59 @@ QString CommandProcessor::determineEventName(const QString &command)
     {
         return "routesAdded";
     }
-    else if (command == "find_shortest_path" || command == "find_top_paths")
+    else if (command == "find_shortest_path" || command == "find_top_paths"
+             || command == "find_constrained_path")
     {
         return "pathFound";
     }
+    else if (command == "get_distance")
+    {
+        return "distanceFound";
+    }
+    else if (command == "evaluate_path_distribution")
+    {
+        return "pathDistributionEvaluated";
+    }
+    else if (command == "sweep_top_paths")
+    {
+        return "topPathsSwept";
+    }
+    else if (command == "route_containers")
+    {
+        return "containersRouted";
+    }
+    else if (command == "find_reachable_terminals")
+    {
+        return "reachableTerminalsFound";
+    }
+    else if (command == "set_route_timetable")
+    {
+        return "routeTimetableUpdated";
+    }
+    else if (command == "find_earliest_arrival")
+    {
+        return "earliestArrivalFound";
+    }
+    else if (command == "find_arrival_profile")
+    {
+        return "arrivalProfileFound";
+    }
+    else if (command == "assign_traffic")
+    {
+        return "trafficAssigned";
+    }
+    else if (command == "close_route" || command == "close_terminal")
+    {
+        return "closureAdded";
+    }
+    else if (command == "reopen")
+    {
+        return "closureRemoved";
+    }
+    else if (command == "get_closures")
+    {
+        return "closuresListed";
+    }
     else if (command == "add_container" || command == "add_containers"
              || command == "add_containers_from_json"
              || command == "clear_terminal")
@@ -1290,10 +1610,22 @@ QString CommandProcessor::determineEventName(const QString &command)
     {
         return "pingResponse";
     }
+    else if (command == "get_lock_profile")
+    {
+        return "lockProfile";
+    }
     else if (command == "resetServer")
     {
         return "serverReset";
     }
+    else if (command == "fork_scenario")
+    {
+        return "scenarioForked";
+    }
+    else if (command == "drop_scenario")
+    {
+        return "scenarioDropped";
+    }
     else if (command == "reset_runtime_state")
     {
         return "runtimeStateReset";
@@ -1311,6 +1643,10 @@ QString CommandProcessor::determineEventName(const QString &command)
     {
         return "systemDynamicsUpdated";
     }
+    else if (command == "replicate_handling")
+    {
+        return "handlingReplicated";
+    }
     else if (command == "get_terminals_runtime_state")
     {
         return "terminalRuntimeState";
@@ -1342,15 +1678,98 @@ Terminal *CommandProcessor::getTerminalFromParams(const QVariantMap &params)
         throw std::invalid_argument("Terminal ID must be provided");
     }
 
+    Terminal *terminal = nullptr;
     try
     {
-        return m_graph->getTerminal(terminalId);
+        terminal = m_graph->getTerminal(terminalId);
     }
     catch (const std::exception &e)
     {
         throw std::invalid_argument(
             QString("Terminal not found: %1").arg(terminalId).toStdString());
     }
+
+    if (!ownsTerminal(terminal->getTerminalName()))
+    {
+        const int owner = m_shardRing.shardFor(terminal->getTerminalName());
+        throw std::invalid_argument(
+            QString("Terminal %1 is owned by shard %2; use routing key %3")
+                .arg(terminalId)
+                .arg(owner)
+                .arg(ShardRing::shardRoutingKey(owner))
+                .toStdString());
+    }
+    return terminal;
+}
+
+bool CommandProcessor::ownsTerminal(const QString &terminalId) const
+{
+    if (m_shardRing.shardCount() == 1)
+        return true;
+
+    // Ownership follows the canonical name, so aliases agree with it
+    try
+    {
+        return m_shardRing.shardFor(
+                   m_graph->getTerminal(terminalId)->getTerminalName())
+               == m_shardIndex;
+    }
+    catch (const std::exception &)
+    {
+        return true;
+    }
+}
+
+QStringList CommandProcessor::ownedTerminalNames() const
+{
+    QStringList names = m_graph->getAllTerminalNames(false).keys();
+    if (m_shardRing.shardCount() > 1)
+    {
+        names.erase(std::remove_if(names.begin(), names.end(),
+                                   [this](const QString &name) {
+                                       return m_shardRing.shardFor(name)
+                                              != m_shardIndex;
+                                   }),
+                    names.end());
+    }
+    return names;
+}
+
+void CommandProcessor::setShard(int shardIndex, int shardCount)
+{
+    if (shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount)
+    {
+        throw std::invalid_argument(
+            QString("Invalid shard %1 of %2")
+                .arg(shardIndex)
+                .arg(shardCount)
+                .toStdString());
+    }
+
+    ProfiledMutexLocker locker(&m_mutex);
+    m_shardRing  = ShardRing(shardCount);
+    m_shardIndex = shardIndex;
+
+    qCInfo(lcCommandProcessor) << "Serving shard" << shardIndex << "of"
+                               << shardCount;
+}
+
+std::shared_ptr<TerminalGraph>
+CommandProcessor::getScenarioFromParams(const QVariantMap &params) const
+{
+    const QString scenarioId = params.value("scenario_id").toString().trimmed();
+    if (scenarioId.isEmpty())
+    {
+        return nullptr;
+    }
+
+    const auto it = m_scenarios.constFind(scenarioId);
+    if (it == m_scenarios.constEnd())
+    {
+        throw std::invalid_argument(
+            QString("Scenario not found: %1").arg(scenarioId).toStdString());
+    }
+    return it.value();
 }
 
 QVariant CommandProcessor::handlePing(const QVariantMap &params)
@@ -1373,8 +1792,11 @@ QVariant CommandProcessor::handleResetServer(const QVariantMap &params)
 {
     Q_UNUSED(params); // Mark params as unused
 
-    // Clear the existing graph
+    // Clear the existing graph; resetting the base graph also drops every
+    // scenario forked from it
     m_graph->clear();
+    if (m_graph == m_baseGraph)
+        m_scenarios.clear();
 
     // Reinitialize graph-level prediction configuration as part of a full
     // server reset. Runtime-only resets should use the future
@@ -1391,6 +1813,52 @@ QVariant CommandProcessor::handleResetServer(const QVariantMap &params)
     return response;
 }
 
+QVariant CommandProcessor::handleForkScenario(const QVariantMap &params)
+{
+    QString scenarioId = params.value("new_scenario_id").toString().trimmed();
+    if (scenarioId.isEmpty())
+        scenarioId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    if (m_scenarios.contains(scenarioId))
+    {
+        throw std::invalid_argument(
+            QString("Scenario already exists: %1")
+                .arg(scenarioId)
+                .toStdString());
+    }
+
+    // m_graph is the scenario named by scenario_id, so forks can be nested
+    std::shared_ptr<TerminalGraph> branch(m_graph->fork());
+    m_scenarios.insert(scenarioId, branch);
+
+    qCInfo(lcCommandProcessor) << "Forked scenario" << scenarioId;
+
+    QVariantMap response;
+    response["scenario_id"]        = scenarioId;
+    response["source_scenario_id"] = params.value("scenario_id").toString();
+    response["terminal_count"]     = branch->getTerminalCount();
+    response["scenario_count"]     = static_cast<int>(m_scenarios.size());
+    return response;
+}
+
+QVariant CommandProcessor::handleDropScenario(const QVariantMap &params)
+{
+    const QString scenarioId = params.value("scenario_id").toString().trimmed();
+    if (scenarioId.isEmpty())
+    {
+        throw std::invalid_argument("Missing scenario_id; the base network "
+                                    "cannot be dropped");
+    }
+    m_scenarios.remove(scenarioId);
+
+    qCInfo(lcCommandProcessor) << "Dropped scenario" << scenarioId;
+
+    QVariantMap response;
+    response["scenario_id"]    = scenarioId;
+    response["dropped"]        = true;
+    response["scenario_count"] = static_cast<int>(m_scenarios.size());
+    return response;
+}
+
 QVariant
 CommandProcessor::handleSetCostFunctionParameters(const QVariantMap &params)
 {
@@ -1582,17 +2050,22 @@ QVariant CommandProcessor::handleFindShortestPath(const QVariantMap &params)
     QString startTerminal = params["start_terminal"].toString();
     QString endTerminal   = params["end_terminal"].toString();
 
-    // Extract mode (optional)
-    TransportationMode mode = TransportationMode::Any; // Default
-    if (params.contains("mode"))
+    // Extract mode or mode set (optional)
+    TransportationModeMask modes = TransportationMode::Any; // Default
+    if (params.contains("modes"))
     {
-        mode = parseModeParam(params.value(QStringLiteral("mode")), true,
-                              QStringLiteral("find_shortest_path.mode"));
+        modes = parseModeSetParam(params.value(QStringLiteral("modes")),
+                                  QStringLiteral("find_shortest_path.modes"));
+    }
+    else if (params.contains("mode"))
+    {
+        modes = parseModeParam(params.value(QStringLiteral("mode")), true,
+                               QStringLiteral("find_shortest_path.mode"));
     }
 
     // Find the shortest path
     QList<PathSegment> pathSegments =
-        m_graph->findShortestPath(startTerminal, endTerminal, mode);
+        m_graph->findShortestPath(startTerminal, endTerminal, modes);
 
     // Convert path segments to JSON array using the toJson() method
     QJsonArray pathArray;
@@ -1618,22 +2091,36 @@ QVariant CommandProcessor::handleFindTopPaths(const QVariantMap &params)
     // Extract number of paths (optional)
     int n = params.value("n", 5).toInt();
 
-    // Extract mode (optional)
-    TransportationMode mode = TransportationMode::Truck; // Default
-    if (params.contains("mode"))
+    // Extract mode or mode set (optional)
+    TransportationModeMask modes = TransportationMode::Truck; // Default
+    if (params.contains("modes"))
     {
-        mode = parseModeParam(params.value(QStringLiteral("mode")), true,
-                              QStringLiteral("find_top_paths.mode"));
+        modes = parseModeSetParam(params.value(QStringLiteral("modes")),
+                                  QStringLiteral("find_top_paths.modes"));
+    }
+    else if (params.contains("mode"))
+    {
+        modes = parseModeParam(params.value(QStringLiteral("mode")), true,
+                               QStringLiteral("find_top_paths.mode"));
     }
 
     // Extract skip option (optional)
     bool skipSameModeTerminalDelaysAndCosts =
         params.value("skip_same_mode_terminal_delays_and_costs", true).toBool();
 
+    // Extract search strategy (optional)
+    bool transferAwareSearch =
+        params.value("transfer_aware_search", false).toBool();
+
     // Get paths
     QList<Path> paths =
-        m_graph->findTopNShortestPaths(startTerminal, endTerminal, n, mode,
-                                       skipSameModeTerminalDelaysAndCosts);
+        transferAwareSearch
+            ? m_graph->findTopNTransferAwarePaths(
+                  startTerminal, endTerminal, n, modes,
+                  skipSameModeTerminalDelaysAndCosts)
+            : m_graph->findTopNShortestPaths(
+                  startTerminal, endTerminal, n, modes,
+                  skipSameModeTerminalDelaysAndCosts);
 
     QJsonObject pathsJson;
     pathsJson["start_terminal"] = startTerminal;
@@ -1650,6 +2137,761 @@ QVariant CommandProcessor::handleFindTopPaths(const QVariantMap &params)
     return pathsJson;
 }
 
+QVariant
+CommandProcessor::handleEvaluatePathDistribution(const QVariantMap &params)
+{
+    if (!params.contains("paths") || !params["paths"].canConvert<QVariantList>())
+    {
+        throw std::invalid_argument("Missing or invalid paths parameter");
+    }
+
+    // A path is a find_top_paths result with segments, or a bare leg list
+    QList<QList<PathLeg>> paths;
+    const QVariantList    pathList = params["paths"].toList();
+    for (int p = 0; p < pathList.size(); ++p)
+    {
+        const QVariant path = pathList[p];
+        const QVariantList legList =
+            path.typeId() == QMetaType::QVariantMap
+                ? path.toMap().value(QStringLiteral("segments")).toList()
+                : path.toList();
+
+        QList<PathLeg> legs;
+        for (int i = 0; i < legList.size(); ++i)
+        {
+            const QVariantMap leg     = legList[i].toMap();
+            const QString     context =
+                QStringLiteral("paths[%1].segments[%2]").arg(p).arg(i);
+            if (!leg.contains(QStringLiteral("from"))
+                || !leg.contains(QStringLiteral("to"))
+                || !leg.contains(QStringLiteral("mode")))
+            {
+                throw std::invalid_argument(
+                    QString("%1 needs from, to and mode")
+                        .arg(context)
+                        .toStdString());
+            }
+            legs.append(PathLeg{
+                leg.value(QStringLiteral("from")).toString(),
+                leg.value(QStringLiteral("to")).toString(),
+                parseModeParam(leg.value(QStringLiteral("mode")), false,
+                               context + QStringLiteral(".mode"))});
+        }
+        paths.append(legs);
+    }
+
+    const int samples =
+        optionalIntParam(params, QStringLiteral("samples"),
+                         QStringLiteral("samples"))
+            .value_or(10000);
+
+    QList<double> percentiles{5.0, 50.0, 95.0};
+    if (params.contains("percentiles"))
+    {
+        percentiles.clear();
+        for (const QVariant &value : params.value("percentiles").toList())
+        {
+            bool         ok         = false;
+            const double percentile = value.toDouble(&ok);
+            if (!ok)
+            {
+                throw std::invalid_argument(
+                    "Invalid numeric value for percentiles");
+            }
+            percentiles.append(percentile);
+        }
+    }
+
+    quint64 seed = QRandomGenerator::global()->generate64();
+    if (params.contains("seed"))
+    {
+        bool ok = false;
+        seed    = params.value("seed").toULongLong(&ok);
+        if (!ok)
+        {
+            throw std::invalid_argument("Invalid integer value for seed");
+        }
+    }
+
+    const bool skipSameModeTerminalDelaysAndCosts =
+        params.value("skip_same_mode_terminal_delays_and_costs", true).toBool();
+
+    QVariantMap result;
+    result["seed"]  = seed;
+    result["paths"] = m_graph->evaluatePathDistribution(
+        paths, samples, seed, skipSameModeTerminalDelaysAndCosts,
+        percentiles);
+    return result;
+}
+
+QVariant CommandProcessor::handleSweepTopPaths(const QVariantMap &params)
+{
+    if (!params.contains("weights")
+        || !params["weights"].canConvert<QVariantList>())
+    {
+        throw std::invalid_argument("Missing or invalid weights parameter");
+    }
+    if (!params.contains("queries")
+        || !params["queries"].canConvert<QVariantList>())
+    {
+        throw std::invalid_argument("Missing or invalid queries parameter");
+    }
+
+    QList<QVariantMap> weightSets;
+    for (const QVariant &weightSet : params["weights"].toList())
+    {
+        if (!weightSet.canConvert<QVariantMap>())
+        {
+            throw std::invalid_argument("Invalid weight set data format");
+        }
+        weightSets.append(weightSet.toMap());
+    }
+
+    QList<RouteQuery>  queries;
+    const QVariantList queryList = params["queries"].toList();
+    for (int i = 0; i < queryList.size(); ++i)
+    {
+        if (!queryList[i].canConvert<QVariantMap>())
+        {
+            throw std::invalid_argument("Invalid query data format");
+        }
+        const QVariantMap query = queryList[i].toMap();
+        const QString     context =
+            QStringLiteral("sweep_top_paths.queries[%1]").arg(i);
+
+        RouteQuery routeQuery{
+            query.value(QStringLiteral("start_terminal")).toString(),
+            query.value(QStringLiteral("end_terminal")).toString()};
+        if (routeQuery.start.isEmpty() || routeQuery.end.isEmpty())
+        {
+            throw std::invalid_argument(
+                QString("Missing start_terminal or end_terminal in %1")
+                    .arg(context)
+                    .toStdString());
+        }
+        if (query.contains("modes"))
+        {
+            routeQuery.modes =
+                parseModeSetParam(query.value(QStringLiteral("modes")),
+                                  context + QStringLiteral(".modes"));
+        }
+        else if (query.contains("mode"))
+        {
+            routeQuery.modes =
+                parseModeParam(query.value(QStringLiteral("mode")), true,
+                               context + QStringLiteral(".mode"));
+        }
+        queries.append(routeQuery);
+    }
+
+    int  n = params.value("n", 1).toInt();
+    bool skipSameModeTerminalDelaysAndCosts =
+        params.value("skip_same_mode_terminal_delays_and_costs", true).toBool();
+
+    const QList<QList<QList<Path>>> sweep = m_graph->sweepTopNShortestPaths(
+        weightSets, queries, n, skipSameModeTerminalDelaysAndCosts);
+
+    QJsonArray sweepsArray;
+    for (int w = 0; w < weightSets.size(); ++w)
+    {
+        QJsonArray resultsArray;
+        for (int q = 0; q < queries.size(); ++q)
+        {
+            QJsonArray pathsArray;
+            for (const Path &path : sweep[w][q])
+            {
+                pathsArray.append(path.toJson());
+            }
+
+            QJsonObject resultJson;
+            resultJson["start_terminal"] = queries[q].start;
+            resultJson["end_terminal"]   = queries[q].end;
+            resultJson["modes"] =
+                EnumUtils::transportationModeMaskToString(queries[q].modes);
+            resultJson["paths"] = pathsArray;
+            resultsArray.append(resultJson);
+        }
+
+        QJsonObject sweepJson;
+        sweepJson["weights"] = QJsonObject::fromVariantMap(weightSets[w]);
+        sweepJson["results"] = resultsArray;
+        sweepsArray.append(sweepJson);
+    }
+
+    QJsonObject sweepsJson;
+    sweepsJson["sweeps"] = sweepsArray;
+    return sweepsJson;
+}
+
+QVariant CommandProcessor::handleRouteContainers(const QVariantMap &params)
+{
+    if (!params.contains("containers")
+        || !params["containers"].canConvert<QVariantList>())
+    {
+        throw std::invalid_argument("Missing or invalid containers parameter");
+    }
+
+    // Extract default mode or mode set (optional)
+    TransportationModeMask defaultModes = TransportationMode::Any; // Default
+    if (params.contains("modes"))
+    {
+        defaultModes =
+            parseModeSetParam(params.value(QStringLiteral("modes")),
+                              QStringLiteral("route_containers.modes"));
+    }
+    else if (params.contains("mode"))
+    {
+        defaultModes =
+            parseModeParam(params.value(QStringLiteral("mode")), true,
+                           QStringLiteral("route_containers.mode"));
+    }
+
+    int  n = params.value("n", 1).toInt();
+    bool skipSameModeTerminalDelaysAndCosts =
+        params.value("skip_same_mode_terminal_delays_and_costs", true).toBool();
+
+    // Group containers by (current terminal, destination, modes) so each
+    // group is searched once
+    QList<RouteQuery>   queries;
+    QHash<QString, int> groupIndex;
+    QJsonArray          containersArray;
+    const QVariantList  containerList = params["containers"].toList();
+    for (int i = 0; i < containerList.size(); ++i)
+    {
+        if (!containerList[i].canConvert<QVariantMap>())
+        {
+            throw std::invalid_argument("Invalid container data format");
+        }
+        const QVariantMap container = containerList[i].toMap();
+        const QString     context =
+            QStringLiteral("route_containers.containers[%1]").arg(i);
+
+        const QString containerId =
+            container.value(QStringLiteral("container_id")).toString();
+        const QString currentTerminal =
+            container.value(QStringLiteral("current_terminal")).toString();
+        const QString destination =
+            container.value(QStringLiteral("destination")).toString();
+        if (containerId.isEmpty() || currentTerminal.isEmpty()
+            || destination.isEmpty())
+        {
+            throw std::invalid_argument(
+                QString("Missing container_id, current_terminal or "
+                        "destination in %1")
+                    .arg(context)
+                    .toStdString());
+        }
+
+        TransportationModeMask modes = defaultModes;
+        if (container.contains("modes"))
+        {
+            modes = parseModeSetParam(container.value(QStringLiteral("modes")),
+                                      context + QStringLiteral(".modes"));
+        }
+        else if (container.contains("mode"))
+        {
+            modes = parseModeParam(container.value(QStringLiteral("mode")),
+                                   true, context + QStringLiteral(".mode"));
+        }
+
+        const QString key = currentTerminal + QLatin1Char('\n') + destination
+                            + QLatin1Char('\n')
+                            + QString::number(modes.bits());
+        auto it = groupIndex.constFind(key);
+        if (it == groupIndex.constEnd())
+        {
+            it = groupIndex.insert(key, queries.size());
+            queries.append(RouteQuery{currentTerminal, destination, modes});
+        }
+
+        QJsonObject containerJson;
+        containerJson["container_id"] = containerId;
+        containerJson["group"]        = it.value();
+        containersArray.append(containerJson);
+    }
+
+    const QList<QList<Path>> groupPaths = m_graph->findTopNShortestPathsBatch(
+        queries, n, skipSameModeTerminalDelaysAndCosts);
+
+    // Paths are listed once per group; containers refer to their group
+    QJsonArray groupsArray;
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        QJsonArray pathsArray;
+        for (const Path &path : groupPaths[i])
+        {
+            pathsArray.append(path.toJson());
+        }
+
+        QJsonObject groupJson;
+        groupJson["group"]          = i;
+        groupJson["start_terminal"] = queries[i].start;
+        groupJson["end_terminal"]   = queries[i].end;
+        groupJson["modes"] =
+            EnumUtils::transportationModeMaskToString(queries[i].modes);
+        groupJson["routed"] = !groupPaths[i].isEmpty();
+        groupJson["paths"]  = pathsArray;
+        groupsArray.append(groupJson);
+    }
+
+    QJsonObject routingJson;
+    routingJson["containers"] = containersArray;
+    routingJson["groups"]     = groupsArray;
+
+    return routingJson;
+}
+
+QVariant CommandProcessor::handleFindConstrainedPath(const QVariantMap &params)
+{
+    if (!params.contains("start_terminal") || !params.contains("end_terminal"))
+    {
+        throw std::invalid_argument("Missing start_terminal or "
+                                    "end_terminal parameter");
+    }
+
+    QString startTerminal = params["start_terminal"].toString();
+    QString endTerminal   = params["end_terminal"].toString();
+
+    // Extract mode or mode set (optional)
+    TransportationModeMask modes = TransportationMode::Any; // Default
+    if (params.contains("modes"))
+    {
+        modes = parseModeSetParam(params.value(QStringLiteral("modes")),
+                                  QStringLiteral("find_constrained_path.modes"));
+    }
+    else if (params.contains("mode"))
+    {
+        modes = parseModeParam(params.value(QStringLiteral("mode")), true,
+                               QStringLiteral("find_constrained_path.mode"));
+    }
+
+    // Extract limits (each optional)
+    const std::optional<int> maxHops =
+        optionalIntParam(params, QStringLiteral("max_hops"),
+                         QStringLiteral("find_constrained_path.max_hops"));
+    const std::optional<int> maxTransfers =
+        optionalIntParam(params, QStringLiteral("max_transfers"),
+                         QStringLiteral("find_constrained_path.max_transfers"));
+    const std::optional<double> maxTravelTime = optionalDoubleParam(
+        params, {QStringLiteral("max_travel_time")},
+        QStringLiteral("find_constrained_path.max_travel_time"));
+
+    const std::optional<Path> path = m_graph->findConstrainedShortestPath(
+        startTerminal, endTerminal, modes, maxHops, maxTransfers,
+        maxTravelTime);
+
+    QJsonObject pathJson;
+    pathJson["start_terminal"] = startTerminal;
+    pathJson["end_terminal"]   = endTerminal;
+    pathJson["feasible"]       = path.has_value();
+    pathJson["path"] =
+        path.has_value() ? QJsonValue(path->toJson()) : QJsonValue();
+
+    return pathJson;
+}
+
+QVariant CommandProcessor::handleGetDistance(const QVariantMap &params)
+{
+    if (!params.contains("start_terminal") || !params.contains("end_terminal"))
+    {
+        throw std::invalid_argument("Missing start_terminal or "
+                                    "end_terminal parameter");
+    }
+
+    QString startTerminal = params["start_terminal"].toString();
+    QString endTerminal   = params["end_terminal"].toString();
+
+    // Extract mode or mode set (optional)
+    TransportationModeMask modes = TransportationMode::Any; // Default
+    if (params.contains("modes"))
+    {
+        modes = parseModeSetParam(params.value(QStringLiteral("modes")),
+                                  QStringLiteral("get_distance.modes"));
+    }
+    else if (params.contains("mode"))
+    {
+        modes = parseModeParam(params.value(QStringLiteral("mode")), true,
+                               QStringLiteral("get_distance.mode"));
+    }
+
+    const std::optional<double> distance =
+        m_graph->getDistance(startTerminal, endTerminal, modes);
+
+    QJsonObject distanceJson;
+    distanceJson["start_terminal"] = startTerminal;
+    distanceJson["end_terminal"]   = endTerminal;
+    distanceJson["mode"]           = static_cast<int>(
+        modes.singleMode().value_or(TransportationMode::Any));
+    distanceJson["modes"] =
+        EnumUtils::transportationModeMaskToString(modes);
+    distanceJson["reachable"]      = distance.has_value();
+    distanceJson["distance"] =
+        distance.has_value() ? QJsonValue(*distance) : QJsonValue();
+
+    return distanceJson;
+}
+
+QVariant
+CommandProcessor::handleFindReachableTerminals(const QVariantMap &params)
+{
+    if (!params.contains("start_terminal"))
+    {
+        throw std::invalid_argument("Missing start_terminal parameter");
+    }
+
+    QString startTerminal = params["start_terminal"].toString();
+
+    // Exactly one budget: cost or travel time
+    const std::optional<double> maxCost = optionalDoubleParam(
+        params, {QStringLiteral("max_cost")},
+        QStringLiteral("find_reachable_terminals.max_cost"));
+    const std::optional<double> maxTravelTime = optionalDoubleParam(
+        params, {QStringLiteral("max_travel_time")},
+        QStringLiteral("find_reachable_terminals.max_travel_time"));
+    if (maxCost.has_value() == maxTravelTime.has_value())
+    {
+        throw std::invalid_argument("Provide exactly one of max_cost or "
+                                    "max_travel_time");
+    }
+
+    // Extract mode or mode set (optional)
+    TransportationModeMask modes = TransportationMode::Any; // Default
+    if (params.contains("modes"))
+    {
+        modes = parseModeSetParam(
+            params.value(QStringLiteral("modes")),
+            QStringLiteral("find_reachable_terminals.modes"));
+    }
+    else if (params.contains("mode"))
+    {
+        modes = parseModeParam(params.value(QStringLiteral("mode")), true,
+                               QStringLiteral("find_reachable_terminals.mode"));
+    }
+
+    const TerminalGraph::ReachabilityMetric metric =
+        maxCost.has_value() ? TerminalGraph::ReachabilityMetric::Cost
+                            : TerminalGraph::ReachabilityMetric::TravelTime;
+    const double budget = maxCost.value_or(maxTravelTime.value_or(0.0));
+
+    const QList<QPair<QString, double>> reachable =
+        m_graph->findReachableTerminals(startTerminal, budget, metric, modes);
+
+    QJsonArray terminalsArray;
+    for (const auto &[terminal, distance] : reachable)
+    {
+        QJsonObject terminalJson;
+        terminalJson["terminal"] = terminal;
+        terminalJson["value"]    = distance;
+        terminalsArray.append(terminalJson);
+    }
+
+    QJsonObject reachableJson;
+    reachableJson["start_terminal"] = startTerminal;
+    reachableJson["metric"] =
+        maxCost.has_value() ? QStringLiteral("cost")
+                            : QStringLiteral("travel_time");
+    reachableJson["budget"] = budget;
+    reachableJson["modes"] = EnumUtils::transportationModeMaskToString(modes);
+    reachableJson["terminals"] = terminalsArray;
+
+    return reachableJson;
+}
+
+QVariant CommandProcessor::handleSetRouteTimetable(const QVariantMap &params)
+{
+    if (!params.contains("start_terminal") || !params.contains("end_terminal")
+        || !params.contains("mode") || !params.contains("timetable"))
+    {
+        throw std::invalid_argument("Missing required parameters for "
+                                    "set_route_timetable");
+    }
+
+    QString startTerminal = params["start_terminal"].toString();
+    QString endTerminal   = params["end_terminal"].toString();
+
+    const TransportationMode mode = parseModeParam(
+        params.value(QStringLiteral("mode")), false,
+        QStringLiteral("set_route_timetable.mode"));
+
+    if (!params["timetable"].canConvert<QVariantList>())
+    {
+        throw std::invalid_argument("timetable must be a list");
+    }
+
+    const int departures = m_graph->setRouteTimetable(
+        startTerminal, endTerminal, mode, params["timetable"].toList());
+
+    QJsonObject timetableJson;
+    timetableJson["start_terminal"] = startTerminal;
+    timetableJson["end_terminal"]   = endTerminal;
+    timetableJson["mode"]           = static_cast<int>(mode);
+    timetableJson["departures"]     = departures;
+
+    return timetableJson;
+}
+
+QVariant CommandProcessor::handleFindEarliestArrival(const QVariantMap &params)
+{
+    if (!params.contains("start_terminal") || !params.contains("end_terminal"))
+    {
+        throw std::invalid_argument("Missing start_terminal or "
+                                    "end_terminal parameter");
+    }
+
+    QString startTerminal = params["start_terminal"].toString();
+    QString endTerminal   = params["end_terminal"].toString();
+
+    const double readyTime =
+        optionalDoubleParam(params,
+                            {QStringLiteral("ready_time"),
+                             QStringLiteral("departure_time")},
+                            QStringLiteral("ready_time"))
+            .value_or(0.0);
+
+    // Extract mode (optional)
+    TransportationMode mode = TransportationMode::Any; // Default
+    if (params.contains("mode"))
+    {
+        mode = parseModeParam(params.value(QStringLiteral("mode")), true,
+                              QStringLiteral("find_earliest_arrival.mode"));
+    }
+
+    return m_graph->findEarliestArrival(startTerminal, endTerminal, readyTime,
+                                        mode);
+}
+
+QVariant CommandProcessor::handleFindArrivalProfile(const QVariantMap &params)
+{
+    if (!params.contains("start_terminal") || !params.contains("end_terminal"))
+    {
+        throw std::invalid_argument("Missing start_terminal or "
+                                    "end_terminal parameter");
+    }
+
+    QString startTerminal = params["start_terminal"].toString();
+    QString endTerminal   = params["end_terminal"].toString();
+
+    const double windowStart = requiredDouble(
+        params, {QStringLiteral("window_start")},
+        QStringLiteral("window_start"));
+    const double windowEnd = requiredDouble(
+        params, {QStringLiteral("window_end")}, QStringLiteral("window_end"));
+
+    // Extract mode (optional)
+    TransportationMode mode = TransportationMode::Any; // Default
+    if (params.contains("mode"))
+    {
+        mode = parseModeParam(params.value(QStringLiteral("mode")), true,
+                              QStringLiteral("find_arrival_profile.mode"));
+    }
+
+    QJsonObject profileJson;
+    profileJson["start_terminal"] = startTerminal;
+    profileJson["end_terminal"]   = endTerminal;
+    profileJson["window_start"]   = windowStart;
+    profileJson["window_end"]     = windowEnd;
+    profileJson["profile"]        = QJsonArray::fromVariantList(
+        m_graph->findArrivalProfile(startTerminal, endTerminal, windowStart,
+                                    windowEnd, mode));
+
+    return profileJson;
+}
+
+QVariant CommandProcessor::handleAssignTraffic(const QVariantMap &params)
+{
+    if (!params.contains("demands")
+        || !params["demands"].canConvert<QVariantList>())
+    {
+        throw std::invalid_argument("Missing or invalid demands parameter");
+    }
+
+    QList<FlowDemand> demands;
+    const QVariantList demandList = params["demands"].toList();
+    for (int i = 0; i < demandList.size(); ++i)
+    {
+        if (!demandList[i].canConvert<QVariantMap>())
+        {
+            throw std::invalid_argument("Invalid demand data format");
+        }
+        const QVariantMap demand  = demandList[i].toMap();
+        const QString     context = QStringLiteral("demands[%1]").arg(i);
+        demands.append(FlowDemand{
+            demand.value(QStringLiteral("origin")).toString(),
+            demand.value(QStringLiteral("destination")).toString(),
+            requiredDouble(demand, {QStringLiteral("teu")},
+                           context + QStringLiteral(".teu"))});
+    }
+
+    // Extract mode or mode set (optional)
+    TransportationModeMask modes = TransportationMode::Any; // Default
+    if (params.contains("modes"))
+    {
+        modes = parseModeSetParam(params.value(QStringLiteral("modes")),
+                                  QStringLiteral("assign_traffic.modes"));
+    }
+    else if (params.contains("mode"))
+    {
+        modes = parseModeParam(params.value(QStringLiteral("mode")), true,
+                               QStringLiteral("assign_traffic.mode"));
+    }
+
+    const double periodHours =
+        optionalDoubleParam(params, {QStringLiteral("period_hours")},
+                            QStringLiteral("period_hours"))
+            .value_or(24.0);
+    const int maxIterations =
+        optionalIntParam(params, QStringLiteral("max_iterations"),
+                         QStringLiteral("max_iterations"))
+            .value_or(100);
+    const double gapTolerance =
+        optionalDoubleParam(params, {QStringLiteral("gap_tolerance")},
+                            QStringLiteral("gap_tolerance"))
+            .value_or(1e-4);
+
+    return m_graph->assignTraffic(demands, modes, periodHours, maxIterations,
+                                  gapTolerance);
+}
+
+QVariant CommandProcessor::handleReplicateHandling(const QVariantMap &params)
+{
+    if (!params.contains("schedule")
+        || !params["schedule"].canConvert<QVariantList>())
+    {
+        throw std::invalid_argument("Missing or invalid schedule parameter");
+    }
+
+    QList<HandlingEvent> schedule;
+    const QVariantList   eventList = params["schedule"].toList();
+    for (int i = 0; i < eventList.size(); ++i)
+    {
+        if (!eventList[i].canConvert<QVariantMap>())
+        {
+            throw std::invalid_argument("Invalid schedule event data format");
+        }
+        const QVariantMap event   = eventList[i].toMap();
+        const QString     context = QStringLiteral("schedule[%1]").arg(i);
+
+        const QString type =
+            event.value(QStringLiteral("event"), QStringLiteral("arrival"))
+                .toString();
+        if (type != QStringLiteral("arrival") && type != QStringLiteral("pickup"))
+        {
+            throw std::invalid_argument(
+                QString("%1.event must be arrival or pickup")
+                    .arg(context)
+                    .toStdString());
+        }
+
+        HandlingEvent handlingEvent;
+        handlingEvent.terminal =
+            event.value(QStringLiteral("terminal_id")).toString();
+        handlingEvent.time =
+            requiredDouble(event, {QStringLiteral("time")},
+                           context + QStringLiteral(".time"));
+        handlingEvent.pickup = type == QStringLiteral("pickup");
+        handlingEvent.containers =
+            optionalIntParam(event, QStringLiteral("containers"),
+                             context + QStringLiteral(".containers"))
+                .value_or(1);
+        if (event.contains(QStringLiteral("mode")))
+        {
+            handlingEvent.mode =
+                parseModeParam(event.value(QStringLiteral("mode")), true,
+                               context + QStringLiteral(".mode"));
+        }
+        schedule.append(handlingEvent);
+    }
+
+    const int replications =
+        optionalIntParam(params, QStringLiteral("replications"),
+                         QStringLiteral("replications"))
+            .value_or(100);
+
+    // Without a seed, draw one and report it so the run can be repeated
+    quint64 seed = QRandomGenerator::global()->generate64();
+    if (params.contains("seed"))
+    {
+        bool ok = false;
+        seed    = params.value("seed").toULongLong(&ok);
+        if (!ok)
+        {
+            throw std::invalid_argument("Invalid integer value for seed");
+        }
+    }
+
+    return m_graph->replicateHandling(schedule, replications, seed);
+}
+
+QVariant CommandProcessor::handleCloseRoute(const QVariantMap &params)
+{
+    if (!params.contains("start_terminal") || !params.contains("end_terminal")
+        || !params.contains("mode"))
+    {
+        throw std::invalid_argument("Missing required parameters for "
+                                    "close_route");
+    }
+
+    QString startTerminal = params["start_terminal"].toString();
+    QString endTerminal   = params["end_terminal"].toString();
+
+    const TransportationMode mode =
+        parseModeParam(params.value(QStringLiteral("mode")), false,
+                       QStringLiteral("close_route.mode"));
+
+    // Windows default to unbounded on either side. Path and distance
+    // queries have no time and only honour closures without a window.
+    const double fromTime =
+        optionalDoubleParam(params, {QStringLiteral("from_time")},
+                            QStringLiteral("from_time"))
+            .value_or(-std::numeric_limits<double>::infinity());
+    const double untilTime =
+        optionalDoubleParam(params, {QStringLiteral("until_time")},
+                            QStringLiteral("until_time"))
+            .value_or(std::numeric_limits<double>::infinity());
+
+    const QString closureId = m_graph->closeRoute(
+        startTerminal, endTerminal, mode, fromTime, untilTime,
+        params.value("closure_id").toString());
+
+    QJsonObject closureJson;
+    closureJson["closure_id"]     = closureId;
+    closureJson["start_terminal"] = startTerminal;
+    closureJson["end_terminal"]   = endTerminal;
+    closureJson["mode"]           = static_cast<int>(mode);
+
+    return closureJson;
+}
+
+QVariant CommandProcessor::handleCloseTerminal(const QVariantMap &params)
+{
+    const QString terminalId = params.value("terminal_id").toString();
+    if (terminalId.isEmpty())
+    {
+        throw std::invalid_argument("Terminal ID must be provided");
+    }
+
+    // Windows default to unbounded on either side. Path and distance
+    // queries have no time and only honour closures without a window.
+    const double fromTime =
+        optionalDoubleParam(params, {QStringLiteral("from_time")},
+                            QStringLiteral("from_time"))
+            .value_or(-std::numeric_limits<double>::infinity());
+    const double untilTime =
+        optionalDoubleParam(params, {QStringLiteral("until_time")},
+                            QStringLiteral("until_time"))
+            .value_or(std::numeric_limits<double>::infinity());
+
+    const QString closureId =
+        m_graph->closeTerminal(terminalId, fromTime, untilTime,
+                               params.value("closure_id").toString());
+
+    QJsonObject closureJson;
+    closureJson["closure_id"]  = closureId;
+    closureJson["terminal_id"] = terminalId;
+
+    return closureJson;
+}
+
 QVariant CommandProcessor::handleAddContainer(const QVariantMap &params)
 {
     QString terminalId = params.value("terminal_id").toString();
@@ -6,7 +6,11 @@
 #include <QMap>
 #include <QMutex>
 #include <functional>
+#include <memory>
 
+#include "common/ProfiledMutex.h"
+#include "server/replication_stream.h"
+#include "server/shard_ring.h"
 #include "terminal/terminal_graph.h"
 
 namespace TerminalSim {
@@ -45,6 +49,54 @@ public:
      * @return JSON response object
      */
     QJsonObject processJsonCommand(const QJsonObject& commandObject);
+
+    /**
+     * @brief Serve one shard of a sharded deployment
+     *
+     * The topology stays complete, but container and system dynamics
+     * commands are only served for terminals this shard owns; commands
+     * over several or all terminals cover the owned ones.
+     * @param shardIndex Index of this shard
+     * @param shardCount Number of shards; 1 serves every terminal
+     * @throws std::invalid_argument if the index is out of range
+     * @see ShardRing
+     */
+    void setShard(int shardIndex, int shardCount);
+
+    int shardIndex() const { return m_shardIndex; }
+    int shardCount() const { return m_shardRing.shardCount(); }
+
+    /**
+     * @brief Take part in primary/replica replication
+     *
+     * A primary emits mutationRecorded() for every replicated command it
+     * applies. A replica refuses commands other than read queries and
+     * changes its network only through applyReplicatedMutation().
+     * @see ReplicationStream
+     */
+    void setReplication(const ReplicationStream &replication);
+
+    /**
+     * @brief Heartbeat record carrying the primary's sequence
+     */
+    QJsonObject replicationHeartbeat() const;
+
+    /**
+     * @brief Apply a record of the primary's mutation stream (replica)
+     * @param record Mutation or heartbeat record
+     * @return True if a mutation was applied, false for a heartbeat or a
+     * redelivered mutation
+     * @throws std::runtime_error on a gap, or if the mutation fails here;
+     * the replica then stops serving reads
+     */
+    bool applyReplicatedMutation(const QJsonObject &record);
+
+signals:
+    /**
+     * @brief Emitted by a primary after applying a replicated command
+     * @param record Mutation record to publish, in sequence order
+     */
+    void mutationRecorded(const QJsonObject &record);
     
 private:
     /**
@@ -58,6 +110,12 @@ private:
      * @param handler Command handler function
      */
     void registerCommand(const QString& command, CommandHandler handler);
+
+    /**
+     * @brief Run a registered command on its scenario; m_mutex held
+     */
+    QVariant executeCommandLocked(const QString& command,
+                                  const QVariantMap& params);
     
     /**
      * @brief Get terminal from ID parameter
@@ -66,6 +124,28 @@ private:
      */
     Terminal* getTerminalFromParams(const QVariantMap& params);
 
+    /**
+     * @brief Whether this shard holds the runtime state of a terminal
+     * @param terminalId Terminal name or alias
+     * @return True when unsharded, or for unknown terminals so that the
+     * usual not-found error is reported
+     */
+    bool ownsTerminal(const QString& terminalId) const;
+
+    /**
+     * @brief Canonical names of the terminals this shard owns
+     */
+    QStringList ownedTerminalNames() const;
+
+    /**
+     * @brief Get the scenario named by the scenario_id parameter
+     * @param params Command parameters
+     * @return Forked graph, or nullptr when no scenario_id is given
+     * @throws std::invalid_argument if the scenario does not exist
+     */
+    std::shared_ptr<TerminalGraph>
+    getScenarioFromParams(const QVariantMap& params) const;
+
     /**
      * @brief Maps a command name to its corresponding event name for client
      * response.
@@ -84,6 +164,8 @@ private:
     // Command handlers
     QVariant handlePing(const QVariantMap& params);
     QVariant handleResetServer(const QVariantMap& params);
+    QVariant handleForkScenario(const QVariantMap& params);
+    QVariant handleDropScenario(const QVariantMap& params);
     QVariant handleSetCostFunctionParameters(const QVariantMap &params);
     QVariant handleAddTerminal(const QVariantMap& params);
     QVariant handleAddTerminals(const QVariantMap &params);
@@ -91,6 +173,19 @@ private:
     QVariant handleAddRoutes(const QVariantMap &params);
     QVariant handleFindShortestPath(const QVariantMap& params);
     QVariant handleFindTopPaths(const QVariantMap& params);
+    QVariant handleEvaluatePathDistribution(const QVariantMap& params);
+    QVariant handleRouteContainers(const QVariantMap& params);
+    QVariant handleSweepTopPaths(const QVariantMap& params);
+    QVariant handleFindConstrainedPath(const QVariantMap& params);
+    QVariant handleGetDistance(const QVariantMap& params);
+    QVariant handleFindReachableTerminals(const QVariantMap& params);
+    QVariant handleSetRouteTimetable(const QVariantMap& params);
+    QVariant handleFindEarliestArrival(const QVariantMap& params);
+    QVariant handleFindArrivalProfile(const QVariantMap& params);
+    QVariant handleAssignTraffic(const QVariantMap& params);
+    QVariant handleReplicateHandling(const QVariantMap& params);
+    QVariant handleCloseRoute(const QVariantMap& params);
+    QVariant handleCloseTerminal(const QVariantMap& params);
     QVariant handleGetTerminal(const QVariantMap& params);
     QVariant handleAddContainer(const QVariantMap& params);
     
@@ -99,14 +194,25 @@ private:
     QVariantMap deserializeParams(const QVariantMap& params);
     
 private:
-    // Terminal graph
+    // Base terminal graph, and the graph the current command runs on
+    TerminalGraph* m_baseGraph;
     TerminalGraph* m_graph;
+
+    // Copy-on-write branches of the base graph, keyed by scenario_id
+    QHash<QString, std::shared_ptr<TerminalGraph>> m_scenarios;
+
+    // Partition of terminal runtime state across server shards
+    ShardRing m_shardRing;
+    int       m_shardIndex = 0;
+
+    // Primary/replica mutation stream
+    ReplicationStream m_replication;
     
     // Command registry
     QMap<QString, CommandHandler> m_commandHandlers;
     
     // Thread safety
-    mutable QMutex m_mutex;
+    mutable ProfiledMutex m_mutex{"CommandProcessor::m_mutex"};
 };
 
 } // namespace TerminalSim
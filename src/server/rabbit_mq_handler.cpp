@@ -16,6 +16,7 @@
 #endif
 
 #include "common/LogCategories.h"
+#include "server/shard_ring.h"
 
 // RabbitMQ-C headers
 #include <rabbitmq-c/amqp.h>
@@ -72,6 +73,44 @@ RabbitMQHandler::~RabbitMQHandler()
     qCDebug(lcRabbitMQ) << "RabbitMQ handler destroyed";
 }
 
+void RabbitMQHandler::setShard(int shardIndex, int shardCount)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (shardCount <= 1) {
+        m_commandQueueName = QString::fromStdString(COMMAND_QUEUE_NAME);
+        m_shardRoutingKey.clear();
+        return;
+    }
+
+    m_commandQueueName = ShardRing::shardQueueName(shardIndex);
+    m_shardRoutingKey = ShardRing::shardRoutingKey(shardIndex);
+
+    qCDebug(lcRabbitMQ) << "Consuming as shard" << shardIndex << "of"
+                        << shardCount << "from queue:" << m_commandQueueName;
+}
+
+void RabbitMQHandler::setReplicationRole(ReplicationRole role,
+                                         const QString& serverId)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (role != ReplicationRole::Replica) {
+        m_commandQueueName = QString::fromStdString(COMMAND_QUEUE_NAME);
+        m_commandRoutingKey = QString::fromStdString(RECEIVING_ROUTING_KEY);
+        m_mutationQueueName.clear();
+        return;
+    }
+
+    m_commandQueueName = ReplicationStream::replicaQueueName();
+    m_commandRoutingKey = ReplicationStream::readRoutingKey();
+    m_mutationQueueName = ReplicationStream::mutationQueueName(serverId);
+
+    qCDebug(lcRabbitMQ) << "Consuming as a replica from queue:"
+                        << m_commandQueueName << "and mutation queue:"
+                        << m_mutationQueueName;
+}
+
 bool RabbitMQHandler::connect(const QString& host,
                               int port,
                               const QString& username,
@@ -414,6 +453,29 @@ bool RabbitMQHandler::setupQueues()
 
         qCDebug(lcRabbitMQ) << "Queue declared:"
                             << m_commandQueueName;
+
+        // A replica's mutation queue lives as long as the replica
+        if (!m_mutationQueueName.isEmpty()) {
+            amqp_queue_declare(
+                m_connection,
+                1, // channel
+                amqp_cstring_bytes(m_mutationQueueName.toUtf8().constData()),
+                0, // passive (false)
+                0, // durable (false)
+                0, // exclusive (false)
+                1, // auto delete (true)
+                amqp_empty_table
+                );
+
+            reply = amqp_get_rpc_reply(m_connection);
+            if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
+                qCWarning(lcRabbitMQ) << "Failed to declare mutation queue";
+                return false;
+            }
+
+            qCDebug(lcRabbitMQ) << "Queue declared:"
+                                << m_mutationQueueName;
+        }
         return true;
     } catch (const std::exception& e) {
         qCWarning(lcRabbitMQ) << "Exception during queue setup:" << e.what();
@@ -424,24 +486,48 @@ bool RabbitMQHandler::setupQueues()
 bool RabbitMQHandler::bindQueues()
 {
     try {
-        // Bind command queue
-        amqp_queue_bind(
-            m_connection,
-            1, // channel
-            amqp_cstring_bytes(m_commandQueueName.toUtf8().constData()),
-            amqp_cstring_bytes(m_exchangeName.toUtf8().constData()),
-            amqp_cstring_bytes(m_commandRoutingKey.toUtf8().constData()),
-            amqp_empty_table
-            );
+        // Bind command queue; a shard also takes its own routing key
+        QStringList routingKeys{m_commandRoutingKey};
+        if (!m_shardRoutingKey.isEmpty())
+            routingKeys.append(m_shardRoutingKey);
 
-        amqp_rpc_reply_t reply = amqp_get_rpc_reply(m_connection);
-        if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
-            qCWarning(lcRabbitMQ) << "Failed to bind command queue";
-            return false;
+        for (const QString& routingKey : routingKeys) {
+            amqp_queue_bind(
+                m_connection,
+                1, // channel
+                amqp_cstring_bytes(m_commandQueueName.toUtf8().constData()),
+                amqp_cstring_bytes(m_exchangeName.toUtf8().constData()),
+                amqp_cstring_bytes(routingKey.toUtf8().constData()),
+                amqp_empty_table
+                );
+
+            amqp_rpc_reply_t reply = amqp_get_rpc_reply(m_connection);
+            if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
+                qCWarning(lcRabbitMQ) << "Failed to bind command queue";
+                return false;
+            }
+
+            qCDebug(lcRabbitMQ) << "Command queue bound to exchange with routing key:"
+                                << routingKey;
         }
 
-        qCDebug(lcRabbitMQ) << "Command queue bound to exchange with routing key:"
-                            << m_commandRoutingKey;
+        if (!m_mutationQueueName.isEmpty()) {
+            amqp_queue_bind(
+                m_connection,
+                1, // channel
+                amqp_cstring_bytes(m_mutationQueueName.toUtf8().constData()),
+                amqp_cstring_bytes(m_exchangeName.toUtf8().constData()),
+                amqp_cstring_bytes(
+                    ReplicationStream::mutationRoutingKey().toUtf8().constData()),
+                amqp_empty_table
+                );
+
+            amqp_rpc_reply_t reply = amqp_get_rpc_reply(m_connection);
+            if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
+                qCWarning(lcRabbitMQ) << "Failed to bind mutation queue";
+                return false;
+            }
+        }
         return true;
     } catch (const std::exception& e) {
         qCWarning(lcRabbitMQ) << "Exception during queue binding:" << e.what();
@@ -472,6 +558,25 @@ void RabbitMQHandler::startConsuming()
 
         qCDebug(lcRabbitMQ) << "Started consuming from command queue:"
                             << m_commandQueueName;
+
+        if (!m_mutationQueueName.isEmpty()) {
+            amqp_basic_consume(
+                m_connection,
+                1, // channel
+                amqp_cstring_bytes(m_mutationQueueName.toUtf8().constData()),
+                amqp_empty_bytes, // consumer tag (server-generated)
+                0, // no local
+                1, // no ack - auto acknowledge
+                0, // exclusive
+                amqp_empty_table
+                );
+
+            reply = amqp_get_rpc_reply(m_connection);
+            if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
+                qCWarning(lcRabbitMQ) << "Failed to start consuming from mutation queue";
+                return;
+            }
+        }
     } catch (const std::exception& e) {
         qCWarning(lcRabbitMQ) << "Exception during start consuming:" << e.what();
     }
@@ -521,16 +626,22 @@ void RabbitMQHandler::processReceivedMessages()
                         message["message_id"] = QString::fromUtf8(messageId);
                     }
 
+                    const QString routingKey = QString::fromUtf8(
+                        static_cast<char*>(envelope.routing_key.bytes),
+                        static_cast<qsizetype>(envelope.routing_key.len));
+
                     // Queue the message for processing
                     QMutexLocker commandQueueLocker(&m_commandQueueMutex);
-                    m_commandQueue.enqueue(message);
+                    if (!m_mutationQueueName.isEmpty()
+                        && routingKey == ReplicationStream::mutationRoutingKey()) {
+                        m_mutationQueue.enqueue(message);
+                    } else {
+                        m_commandQueue.enqueue(message);
+                    }
                     m_commandQueueCondition.wakeOne();
 
                     qCDebug(lcRabbitMQ) << "Received message with routing key:"
-                                       << QByteArray(
-                                              static_cast<char*>(
-                                                  envelope.routing_key.bytes),
-                                              envelope.routing_key.len);
+                                       << routingKey;
                 }
             }
 
@@ -573,8 +684,17 @@ void RabbitMQHandler::workerThreadFunction()
         while (m_threadRunning) {
             processReceivedMessages();
 
-            // Process queued messages
+            // Process queued messages, mutations first so that reads see
+            // the newest network
             QMutexLocker commandQueueLocker(&m_commandQueueMutex);
+            while (!m_mutationQueue.isEmpty()) {
+                QJsonObject record = m_mutationQueue.dequeue();
+                commandQueueLocker.unlock();
+
+                emit mutationReceived(record);
+
+                commandQueueLocker.relock();
+            }
             while (!m_commandQueue.isEmpty()) {
                 QJsonObject message = m_commandQueue.dequeue();
                 commandQueueLocker.unlock();
@@ -8,6 +8,8 @@
 #include <QWaitCondition>
 #include <rabbitmq-c/amqp.h>
 
+#include "server/replication_stream.h"
+
 namespace TerminalSim {
 
 /**
@@ -38,6 +40,29 @@ public:
         const QString& password = "guest"
         );
 
+    /**
+     * @brief Consume as one shard of a sharded deployment
+     *
+     * The shard gets its own command queue, bound to both the broadcast
+     * command key and its shard key. Call before connect().
+     * @param shardIndex Index of this shard
+     * @param shardCount Number of shards; 1 keeps the shared queue
+     * @see ShardRing
+     */
+    void setShard(int shardIndex, int shardCount);
+
+    /**
+     * @brief Consume as a primary or replica
+     *
+     * A replica takes read queries from the queue it shares with the
+     * other replicas, and the primary's mutation stream from a queue of
+     * its own. Call before connect().
+     * @param role Replication role
+     * @param serverId Server ID, naming the replica's mutation queue
+     * @see ReplicationStream
+     */
+    void setReplicationRole(ReplicationRole role, const QString& serverId);
+
     /**
      * @brief Disconnect from RabbitMQ server
      */
@@ -64,6 +89,12 @@ signals:
      */
     void commandReceived(const QJsonObject& command);
 
+    /**
+     * @brief Signal emitted when a replica receives a mutation record
+     * @param record Record of the primary's mutation stream
+     */
+    void mutationReceived(const QJsonObject& record);
+
     /**
      * @brief Signal emitted when connection status changes
      * @param connected Connection status
@@ -96,14 +127,17 @@ private:
     QString m_commandQueueName;
     QString m_responseQueueName;
     QString m_commandRoutingKey;
+    QString m_shardRoutingKey; // Empty when unsharded
+    QString m_mutationQueueName; // Set on replicas only
     QString m_responseRoutingKey;
 
     // Thread for asynchronous communication
     QThread* m_workerThread;
     std::atomic<bool> m_threadRunning;
 
-    // Command queue
+    // Command queue, and mutation records for replicas
     QQueue<QJsonObject> m_commandQueue;
+    QQueue<QJsonObject> m_mutationQueue;
     QMutex m_commandQueueMutex;
     QWaitCondition m_commandQueueCondition;
 
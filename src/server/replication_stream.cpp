@@ -0,0 +1,253 @@
+#include "replication_stream.h"
+
+#include <QSet>
+#include <stdexcept>
+
+namespace TerminalSim {
+
+namespace
+{
+
+const QString MUTATION_ROUTING_KEY =
+    QStringLiteral("CargoNetSim.Mutation.TerminalSim");
+const QString READ_ROUTING_KEY =
+    QStringLiteral("CargoNetSim.Command.TerminalSim.Read");
+const QString REPLICA_QUEUE_NAME =
+    QStringLiteral("CargoNetSim.CommandQueue.TerminalSim.Replica");
+const QString MUTATION_QUEUE_PREFIX =
+    QStringLiteral("CargoNetSim.MutationQueue.TerminalSim.");
+
+const QString KIND_MUTATION  = QStringLiteral("mutation");
+const QString KIND_HEARTBEAT = QStringLiteral("heartbeat");
+
+quint64 recordSequence(const QJsonObject &record)
+{
+    return static_cast<quint64>(
+        record.value(QStringLiteral("sequence")).toDouble());
+}
+
+} // namespace
+
+ReplicationStream::ReplicationStream(ReplicationRole role,
+                                     bool            includeRuntimeState,
+                                     qint64          maxStalenessMs)
+    : m_role(role)
+    , m_includeRuntimeState(includeRuntimeState)
+    , m_maxStalenessMs(maxStalenessMs)
+{
+}
+
+bool ReplicationStream::records(const QString &command) const
+{
+    return m_role == ReplicationRole::Primary
+           && (isTopologyMutation(command)
+               || (m_includeRuntimeState && isRuntimeMutation(command)));
+}
+
+QJsonObject ReplicationStream::recordMutation(const QString     &command,
+                                              const QJsonObject &params,
+                                              qint64             nowMs)
+{
+    QJsonObject record;
+    record[QStringLiteral("kind")]          = KIND_MUTATION;
+    record[QStringLiteral("sequence")]      = static_cast<double>(++m_sequence);
+    record[QStringLiteral("command")]       = command;
+    record[QStringLiteral("params")]        = params;
+    record[QStringLiteral("applied_at_ms")] = static_cast<double>(nowMs);
+    return record;
+}
+
+QJsonObject ReplicationStream::heartbeat(qint64 nowMs) const
+{
+    QJsonObject record;
+    record[QStringLiteral("kind")]       = KIND_HEARTBEAT;
+    record[QStringLiteral("sequence")]   = static_cast<double>(m_sequence);
+    record[QStringLiteral("sent_at_ms")] = static_cast<double>(nowMs);
+    return record;
+}
+
+bool ReplicationStream::admit(const QJsonObject &record, qint64 nowMs)
+{
+    const quint64 sequence = recordSequence(record);
+    const QString kind     = record.value(QStringLiteral("kind")).toString();
+
+    if (kind == KIND_HEARTBEAT)
+    {
+        m_primarySequence = qMax(m_primarySequence, sequence);
+        if (!m_outOfSync && m_sequence == m_primarySequence)
+            m_currentAtMs = nowMs;
+        return false;
+    }
+    if (kind != KIND_MUTATION)
+    {
+        throw std::invalid_argument(
+            QString("Unknown replication record kind: %1")
+                .arg(kind)
+                .toStdString());
+    }
+
+    if (sequence <= m_sequence)
+        return false;
+    if (m_outOfSync || sequence != m_sequence + 1)
+    {
+        m_outOfSync = true;
+        throw std::runtime_error(
+            QString("Replication gap: expected mutation %1, received %2")
+                .arg(m_sequence + 1)
+                .arg(sequence)
+                .toStdString());
+    }
+    return true;
+}
+
+void ReplicationStream::markApplied(const QJsonObject &record, qint64 nowMs)
+{
+    m_sequence        = recordSequence(record);
+    m_primarySequence = qMax(m_primarySequence, m_sequence);
+    if (m_sequence == m_primarySequence)
+        m_currentAtMs = nowMs;
+}
+
+void ReplicationStream::checkReadable(const QString &command,
+                                      qint64         nowMs) const
+{
+    if (m_role != ReplicationRole::Replica)
+        return;
+
+    if (!isReplicaReadCommand(command))
+    {
+        throw std::invalid_argument(
+            QString("Command %1 is not served by replicas; send it to the "
+                    "primary")
+                .arg(command)
+                .toStdString());
+    }
+    if (command == QStringLiteral("ping")
+        || command == QStringLiteral("get_lock_profile"))
+        return;
+
+    if (m_outOfSync)
+    {
+        throw std::runtime_error(
+            "Replica is out of sync with the primary and must be restarted");
+    }
+
+    const qint64 staleness = stalenessMs(nowMs);
+    if (m_maxStalenessMs > 0
+        && (staleness < 0 || staleness > m_maxStalenessMs))
+    {
+        throw std::runtime_error(
+            QString("Replica is %1 ms stale, above the %2 ms bound")
+                .arg(staleness < 0 ? QStringLiteral("indefinitely")
+                                   : QString::number(staleness))
+                .arg(m_maxStalenessMs)
+                .toStdString());
+    }
+}
+
+qint64 ReplicationStream::stalenessMs(qint64 nowMs) const
+{
+    if (m_role != ReplicationRole::Replica)
+        return 0;
+    if (m_currentAtMs < 0)
+        return -1;
+    return qMax<qint64>(0, nowMs - m_currentAtMs);
+}
+
+QJsonObject ReplicationStream::status(qint64 nowMs) const
+{
+    QJsonObject status;
+    status[QStringLiteral("role")] = m_role == ReplicationRole::Primary
+                                         ? QStringLiteral("primary")
+                                         : QStringLiteral("replica");
+    status[QStringLiteral("sequence")] = static_cast<double>(m_sequence);
+    if (m_role == ReplicationRole::Replica)
+    {
+        status[QStringLiteral("primary_sequence")] =
+            static_cast<double>(m_primarySequence);
+        status[QStringLiteral("staleness_ms")] =
+            static_cast<double>(stalenessMs(nowMs));
+        status[QStringLiteral("max_staleness_ms")] =
+            static_cast<double>(m_maxStalenessMs);
+        status[QStringLiteral("in_sync")] = !m_outOfSync;
+    }
+    return status;
+}
+
+bool ReplicationStream::isTopologyMutation(const QString &command)
+{
+    static const QSet<QString> commands = {
+        QStringLiteral("resetServer"),
+        QStringLiteral("set_cost_function_parameters"),
+        QStringLiteral("fork_scenario"),
+        QStringLiteral("drop_scenario"),
+        QStringLiteral("add_terminal"),
+        QStringLiteral("add_terminals"),
+        QStringLiteral("add_alias_to_terminal"),
+        QStringLiteral("remove_terminal"),
+        QStringLiteral("add_route"),
+        QStringLiteral("add_routes"),
+        QStringLiteral("set_route_timetable"),
+        QStringLiteral("close_route"),
+        QStringLiteral("close_terminal"),
+        QStringLiteral("reopen")};
+    return commands.contains(command);
+}
+
+bool ReplicationStream::isRuntimeMutation(const QString &command)
+{
+    static const QSet<QString> commands = {
+        QStringLiteral("add_container"),
+        QStringLiteral("add_containers"),
+        QStringLiteral("add_containers_from_json"),
+        QStringLiteral("dequeue_containers"),
+        QStringLiteral("dequeue_containers_by_next_destination"),
+        QStringLiteral("reserve_containers"),
+        QStringLiteral("commit_container_reservation"),
+        QStringLiteral("release_container_reservation"),
+        QStringLiteral("clear_terminal"),
+        QStringLiteral("reset_runtime_state"),
+        QStringLiteral("update_system_dynamics"),
+        QStringLiteral("update_all_terminals_sd"),
+        QStringLiteral("clear_terminal_execution_results")};
+    return commands.contains(command);
+}
+
+bool ReplicationStream::isReplicaReadCommand(const QString &command)
+{
+    static const QSet<QString> commands = {
+        QStringLiteral("ping"),
+        QStringLiteral("get_lock_profile"),
+        QStringLiteral("find_shortest_path"),
+        QStringLiteral("find_top_paths"),
+        QStringLiteral("get_terminal_status"),
+        QStringLiteral("get_terminal_count"),
+        QStringLiteral("get_terminal"),
+        QStringLiteral("get_aliases_of_terminal"),
+        QStringLiteral("get_distance"),
+        QStringLiteral("find_reachable_terminals"),
+        QStringLiteral("get_closures")};
+    return commands.contains(command);
+}
+
+QString ReplicationStream::mutationRoutingKey()
+{
+    return MUTATION_ROUTING_KEY;
+}
+
+QString ReplicationStream::readRoutingKey()
+{
+    return READ_ROUTING_KEY;
+}
+
+QString ReplicationStream::replicaQueueName()
+{
+    return REPLICA_QUEUE_NAME;
+}
+
+QString ReplicationStream::mutationQueueName(const QString &serverId)
+{
+    return MUTATION_QUEUE_PREFIX + serverId;
+}
+
+} // namespace TerminalSim
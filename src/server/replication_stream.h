@@ -0,0 +1,148 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+namespace TerminalSim {
+
+/**
+ * @brief Part a server plays in primary/replica replication
+ */
+enum class ReplicationRole
+{
+    Standalone, ///< Serves every command, publishes nothing
+    Primary,    ///< Serves every command, publishes applied mutations
+    Replica     ///< Applies the primary's mutations, serves read queries
+};
+
+/**
+ * @brief Ordered stream of applied mutations, from either end
+ *
+ * The primary numbers every successfully applied mutation and publishes
+ * it as a record; between mutations it publishes heartbeats carrying its
+ * current sequence. A replica applies records strictly in order, ignores
+ * redelivered ones and stops serving on a gap, since its network would
+ * no longer match the primary's.
+ *
+ * Staleness is measured on the replica's own clock: it is the time since
+ * the replica last knew it had applied everything the primary had, so it
+ * is bounded by the heartbeat interval plus delivery delay while the
+ * stream flows, and grows when it does not.
+ *
+ * Topology commands are always replicated. Runtime state commands are
+ * replicated on request; terminal runtime involves sampling, so a
+ * replica's runtime state approximates the primary's rather than
+ * matching it.
+ */
+class ReplicationStream
+{
+public:
+    /**
+     * @param role Part this server plays
+     * @param includeRuntimeState Also replicate container and SD commands
+     * @param maxStalenessMs Replica refuses reads when staler; 0 disables
+     */
+    explicit ReplicationStream(ReplicationRole role = ReplicationRole::Standalone,
+                               bool            includeRuntimeState = false,
+                               qint64          maxStalenessMs      = 0);
+
+    ReplicationRole role() const { return m_role; }
+
+    /**
+     * @brief Last sequence recorded (primary) or applied (replica)
+     */
+    quint64 sequence() const { return m_sequence; }
+
+    /**
+     * @brief Whether the primary publishes a record for the command
+     */
+    bool records(const QString &command) const;
+
+    /**
+     * @brief Number the next applied mutation (primary)
+     * @param command Command name
+     * @param params Command parameters, with any minted IDs filled in
+     * @param nowMs Wall clock in ms since the epoch
+     */
+    QJsonObject recordMutation(const QString &command,
+                               const QJsonObject &params, qint64 nowMs);
+
+    /**
+     * @brief Heartbeat carrying the current sequence (primary)
+     */
+    QJsonObject heartbeat(qint64 nowMs) const;
+
+    /**
+     * @brief Check a delivered record before applying it (replica)
+     * @return True if it is the next mutation to apply, false for a
+     * heartbeat or a redelivered mutation
+     * @throws std::runtime_error on a gap in the stream, after which the
+     * replica stays out of sync
+     */
+    bool admit(const QJsonObject &record, qint64 nowMs);
+
+    /**
+     * @brief Note that an admitted mutation was applied (replica)
+     */
+    void markApplied(const QJsonObject &record, qint64 nowMs);
+
+    /**
+     * @brief Stop serving after a mutation failed to apply (replica)
+     */
+    void markOutOfSync() { m_outOfSync = true; }
+
+    /**
+     * @brief Refuse a read the replica cannot serve
+     * @throws std::invalid_argument for commands replicas do not serve
+     * @throws std::runtime_error when out of sync or staler than the bound
+     */
+    void checkReadable(const QString &command, qint64 nowMs) const;
+
+    /**
+     * @brief Milliseconds since the replica was last known current, or
+     * -1 if it never was
+     */
+    qint64 stalenessMs(qint64 nowMs) const;
+
+    /**
+     * @brief Replication fields added to command responses
+     */
+    QJsonObject status(qint64 nowMs) const;
+
+    static bool isTopologyMutation(const QString &command);
+    static bool isRuntimeMutation(const QString &command);
+    static bool isReplicaReadCommand(const QString &command);
+
+    /**
+     * @brief Routing key the primary publishes records with
+     */
+    static QString mutationRoutingKey();
+
+    /**
+     * @brief Routing key of read queries served by the replicas
+     */
+    static QString readRoutingKey();
+
+    /**
+     * @brief Read queue shared by the replicas, which compete for its
+     * messages
+     */
+    static QString replicaQueueName();
+
+    /**
+     * @brief Per-replica queue of the mutation stream
+     */
+    static QString mutationQueueName(const QString &serverId);
+
+private:
+    ReplicationRole m_role;
+    bool            m_includeRuntimeState;
+    qint64          m_maxStalenessMs;
+
+    quint64 m_sequence        = 0;
+    quint64 m_primarySequence = 0;  // Replica: highest sequence announced
+    qint64  m_currentAtMs     = -1; // Replica: last time known current
+    bool    m_outOfSync       = false;
+};
+
+} // namespace TerminalSim
@@ -0,0 +1,200 @@
+#include "shard_ring.h"
+
+#include <QJsonArray>
+#include <QSet>
+#include <stdexcept>
+
+namespace TerminalSim {
+
+namespace
+{
+
+const QString BROADCAST_ROUTING_KEY =
+    QStringLiteral("CargoNetSim.Command.TerminalSim");
+const QString SHARD_QUEUE_PREFIX =
+    QStringLiteral("CargoNetSim.CommandQueue.TerminalSim.Shard.");
+
+} // namespace
+
+ShardRing::ShardRing(int shardCount, int virtualNodes)
+    : m_shardCount(shardCount)
+{
+    if (shardCount < 1 || virtualNodes < 1)
+    {
+        throw std::invalid_argument(
+            "Shard count and virtual nodes must be positive");
+    }
+
+    for (int shard = 0; shard < shardCount; ++shard)
+    {
+        for (int node = 0; node < virtualNodes; ++node)
+        {
+            m_ring.insert(
+                stableHash(QStringLiteral("shard-%1#%2").arg(shard).arg(node)),
+                shard);
+        }
+    }
+}
+
+int ShardRing::shardFor(const QString &terminalId) const
+{
+    if (m_shardCount == 1)
+        return 0;
+
+    // First ring point clockwise from the key, wrapping at the end
+    auto it = m_ring.lowerBound(stableHash(terminalId));
+    if (it == m_ring.constEnd())
+        it = m_ring.constBegin();
+    return it.value();
+}
+
+QString ShardRing::canonicalName(const QString &name) const
+{
+    return m_aliases.value(name, name);
+}
+
+void ShardRing::bindAliases(const QJsonObject &command)
+{
+    const QString     name   = command.value("command").toString();
+    const QJsonObject params = command.value("params").toObject();
+
+    if (name == "add_terminal")
+    {
+        bindTerminalNames(params);
+    }
+    else if (name == "add_terminals")
+    {
+        for (const QJsonValue &terminal : params.value("terminals").toArray())
+            bindTerminalNames(terminal.toObject());
+    }
+    else if (name == "add_alias_to_terminal")
+    {
+        const QString canonical =
+            canonicalName(params.value("terminal_name").toString());
+        const QString alias = params.value("alias").toString();
+        if (!canonical.isEmpty() && !alias.isEmpty() && alias != canonical)
+            m_aliases.insert(alias, canonical);
+    }
+    else if (name == "remove_terminal")
+    {
+        const QString canonical =
+            canonicalName(params.value("terminal_name").toString());
+        for (auto it = m_aliases.begin(); it != m_aliases.end();)
+            it = it.value() == canonical ? m_aliases.erase(it) : std::next(it);
+    }
+    else if (name == "resetServer")
+    {
+        m_aliases.clear();
+    }
+}
+
+void ShardRing::bindTerminalNames(const QJsonObject &terminal)
+{
+    // Same forms the server accepts: one name, or a list led by the
+    // canonical name
+    const QJsonValue namesValue = terminal.value("terminal_names");
+    QStringList      names;
+    if (namesValue.isString())
+    {
+        names << namesValue.toString().trimmed();
+    }
+    else
+    {
+        for (const QJsonValue &nameValue : namesValue.toArray())
+        {
+            const QString name = nameValue.toString().trimmed();
+            if (!name.isEmpty())
+                names << name;
+        }
+    }
+
+    for (int i = 1; i < names.size(); ++i)
+    {
+        if (names[i] != names.first())
+            m_aliases.insert(names[i], names.first());
+    }
+}
+
+QString ShardRing::routingKeyFor(const QJsonObject &command) const
+{
+    const QString     name   = command.value("command").toString();
+    const QJsonObject params = command.value("params").toObject();
+
+    if (m_shardCount == 1 || isBroadcastCommand(name))
+        return broadcastRoutingKey();
+
+    // Ownership follows the canonical name, so aliases resolve first
+    const QString terminalId = params.value("terminal_id").toString();
+    if (!terminalId.isEmpty())
+        return shardRoutingKey(shardFor(canonicalName(terminalId)));
+
+    // Without a single terminal, runtime commands reach every owner
+    if (params.contains("terminal_ids") || name == "reset_runtime_state")
+        return broadcastRoutingKey();
+
+    const QString startTerminal = params.value("start_terminal").toString();
+    return shardRoutingKey(
+        startTerminal.isEmpty() ? 0 : shardFor(canonicalName(startTerminal)));
+}
+
+bool ShardRing::isBroadcastCommand(const QString &command)
+{
+    static const QSet<QString> broadcastCommands = {
+        QStringLiteral("resetServer"),
+        QStringLiteral("set_cost_function_parameters"),
+        QStringLiteral("fork_scenario"),
+        QStringLiteral("drop_scenario"),
+        QStringLiteral("add_terminal"),
+        QStringLiteral("add_terminals"),
+        QStringLiteral("add_alias_to_terminal"),
+        QStringLiteral("remove_terminal"),
+        QStringLiteral("add_route"),
+        QStringLiteral("add_routes"),
+        QStringLiteral("set_route_timetable"),
+        QStringLiteral("close_route"),
+        QStringLiteral("close_terminal"),
+        QStringLiteral("reopen"),
+        QStringLiteral("update_all_terminals_sd"),
+        QStringLiteral("get_terminals_runtime_state"),
+        QStringLiteral("get_terminals_runtime_projections"),
+        QStringLiteral("get_terminal_execution_results"),
+        QStringLiteral("clear_terminal_execution_results")};
+    return broadcastCommands.contains(command);
+}
+
+QString ShardRing::broadcastRoutingKey()
+{
+    return BROADCAST_ROUTING_KEY;
+}
+
+QString ShardRing::shardRoutingKey(int shardIndex)
+{
+    return QStringLiteral("%1.Shard.%2")
+        .arg(BROADCAST_ROUTING_KEY)
+        .arg(shardIndex);
+}
+
+QString ShardRing::shardQueueName(int shardIndex)
+{
+    return SHARD_QUEUE_PREFIX + QString::number(shardIndex);
+}
+
+quint64 ShardRing::stableHash(const QString &value)
+{
+    // FNV-1a over UTF-8, then the splitmix64 finalizer to spread the bits.
+    // qHash is seeded per process and cannot be shared with clients.
+    quint64 hash = 14695981039346656037ULL;
+    for (const char byte : value.toUtf8())
+    {
+        hash ^= static_cast<quint8>(byte);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+} // namespace TerminalSim
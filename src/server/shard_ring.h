@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+namespace TerminalSim {
+
+/**
+ * @brief Consistent-hash partition of terminals over server shards
+ *
+ * In a sharded deployment every process holds the whole topology, so any
+ * shard can answer routing queries, but the runtime state of a terminal
+ * (containers, reservations, system dynamics) lives only on the shard
+ * that owns it. Ownership is decided by the canonical terminal name on a
+ * ring of virtual nodes, hashed with a process-independent hash so that
+ * servers and clients agree without coordination. Adding a shard moves
+ * only about 1/N of the terminals.
+ *
+ * The same ring gives the routing key a client should publish a command
+ * with:
+ * - topology and configuration commands, and commands over several or
+ *   all terminals, go to the broadcast key, which every shard consumes;
+ *   each shard then answers for the terminals it owns
+ * - commands naming one terminal_id go to the owning shard
+ * - other queries go to the shard owning start_terminal, or shard 0
+ *
+ * Terminals may be addressed by alias. Ownership follows the canonical
+ * name, so the ring keeps a replica of the alias map, fed by passing each
+ * topology command to bindAliases() once it has been applied. A name the
+ * ring has not seen bound is routed as if it were canonical; if it is an
+ * alias of a terminal owned elsewhere, the receiving shard rejects the
+ * command and names the owner's routing key.
+ *
+ * Broadcast commands that would mint an ID (close_route, close_terminal,
+ * fork_scenario) must carry it explicitly so that the shards agree.
+ */
+class ShardRing
+{
+public:
+    /**
+     * @brief Build the ring
+     * @param shardCount Number of shards; 1 is an unsharded server
+     * @param virtualNodes Ring points per shard
+     * @throws std::invalid_argument if either count is not positive
+     */
+    explicit ShardRing(int shardCount = 1, int virtualNodes = 64);
+
+    int shardCount() const { return m_shardCount; }
+
+    /**
+     * @brief Shard owning a terminal
+     * @param terminalId Canonical terminal name
+     */
+    int shardFor(const QString &terminalId) const;
+
+    /**
+     * @brief Canonical name of a terminal name or alias
+     * @param name Terminal name or alias
+     * @return The bound canonical name, or name itself if none is bound
+     */
+    QString canonicalName(const QString &name) const;
+
+    /**
+     * @brief Track the aliases a topology command binds or unbinds
+     *
+     * Handles add_terminal, add_terminals, add_alias_to_terminal,
+     * remove_terminal and resetServer; other commands are ignored. Call
+     * once the command has been applied by the shards.
+     * @param command Command message with "command" and "params"
+     */
+    void bindAliases(const QJsonObject &command);
+
+    /**
+     * @brief Routing key a client should publish the command with
+     *
+     * terminal_id and start_terminal are resolved through the alias map
+     * before hashing.
+     * @param command Command message with "command" and "params"
+     */
+    QString routingKeyFor(const QJsonObject &command) const;
+
+    /**
+     * @brief True for commands every shard must apply or answer
+     */
+    static bool isBroadcastCommand(const QString &command);
+
+    /**
+     * @brief Command routing key consumed by every shard
+     */
+    static QString broadcastRoutingKey();
+
+    /**
+     * @brief Command routing key consumed only by one shard
+     */
+    static QString shardRoutingKey(int shardIndex);
+
+    /**
+     * @brief Command queue name of a shard
+     */
+    static QString shardQueueName(int shardIndex);
+
+    /**
+     * @brief Stable 64-bit hash of a string, equal in every process
+     */
+    static quint64 stableHash(const QString &value);
+
+private:
+    // Bind every name of a terminal spec to its first, canonical, name
+    void bindTerminalNames(const QJsonObject &terminal);
+
+    int                     m_shardCount;
+    QMap<quint64, int>      m_ring;    // ring point -> shard index
+    QHash<QString, QString> m_aliases; // alias -> canonical name
+};
+
+} // namespace TerminalSim
@@ -40,6 +40,7 @@ static const std::string HEALTH_RECEIVING_ROUTING_KEY =
     "CargoNetSim.Command.Health.TerminalSim";
 static const std::string HEALTH_PUBLISHING_ROUTING_KEY =
     "CargoNetSim.Response.Health.TerminalSim";
+static const int REPLICATION_HEARTBEAT_MS = 1000;
 
 } // namespace
 
@@ -413,25 +414,32 @@ TerminalGraphServer::getInstance(const QString& pathToTerminalsDirectory)
 TerminalGraphServer::TerminalGraphServer(
     const QString& pathToTerminalsDirectory)
     : QObject(nullptr),
+    m_taskPool(new WorkStealingPool()),
     m_graph(new TerminalGraph(pathToTerminalsDirectory)),
     m_pathToTerminalsDirectory(pathToTerminalsDirectory),
     m_rabbitMQHandler(nullptr),
     m_healthControlPlane(nullptr),
     m_commandProcessor(nullptr),
-    m_serverId(QUuid::createUuid().toString())
+    m_serverId(QUuid::createUuid().toString()),
+    m_shardIndex(0),
+    m_shardCount(1),
+    m_replicationRole(ReplicationRole::Standalone),
+    m_heartbeatTimer(nullptr)
 {
     qCDebug(lcServer) << "Terminal Graph Server created with ID:" << m_serverId
                      << "and terminal directory:"
                      << (!pathToTerminalsDirectory.isEmpty() ?
                              pathToTerminalsDirectory : "None");
     
+    m_graph->setTaskPool(m_taskPool);
+
     // Create command processor
     m_commandProcessor = new CommandProcessor(m_graph, this);
 }
 
 TerminalGraphServer::~TerminalGraphServer()
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     
     // Disconnect from RabbitMQ
     if (m_rabbitMQHandler) {
@@ -449,6 +457,8 @@ TerminalGraphServer::~TerminalGraphServer()
     // Delete graph
     delete m_graph;
     m_graph = nullptr;
+    delete m_taskPool;
+    m_taskPool = nullptr;
     
     qCDebug(lcServer) << "Terminal Graph Server destroyed";
     
@@ -465,7 +475,7 @@ bool TerminalGraphServer::initialize(
     const QString& rabbitMQUser,
     const QString& rabbitMQPassword)
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     
     // Create RabbitMQ handler if not already created
     if (!m_rabbitMQHandler) {
@@ -477,7 +487,12 @@ bool TerminalGraphServer::initialize(
 
         connect(m_rabbitMQHandler, &RabbitMQHandler::commandReceived,
                 this, &TerminalGraphServer::onMessageReceived);
+
+        connect(m_rabbitMQHandler, &RabbitMQHandler::mutationReceived,
+                this, &TerminalGraphServer::onMutationReceived);
     }
+    m_rabbitMQHandler->setShard(m_shardIndex, m_shardCount);
+    m_rabbitMQHandler->setReplicationRole(m_replicationRole, m_serverId);
 
     if (m_healthControlPlane)
     {
@@ -512,12 +527,71 @@ bool TerminalGraphServer::initialize(
     return connected;
 }
 
+void TerminalGraphServer::setShard(int shardIndex, int shardCount)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+
+    m_commandProcessor->setShard(shardIndex, shardCount);
+    m_shardIndex = shardIndex;
+    m_shardCount = shardCount;
+}
+
+void TerminalGraphServer::setWorkerThreads(int count)
+{
+    if (count < 0)
+        throw std::invalid_argument("Worker thread count cannot be negative");
+
+    ProfiledMutexLocker locker(&m_mutex);
+
+    WorkStealingPool* previous = m_taskPool;
+    m_taskPool = new WorkStealingPool(count);
+    m_graph->setTaskPool(m_taskPool);
+    delete previous;
+
+    qCDebug(lcServer) << "Command worker threads:"
+                      << m_taskPool->threadCount();
+}
+
+void TerminalGraphServer::setReplication(
+    const ReplicationStream& replication)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+
+    m_commandProcessor->setReplication(replication);
+    m_replicationRole = replication.role();
+
+    if (m_replicationRole == ReplicationRole::Primary) {
+        // Published under the processor lock, so records leave in order
+        connect(m_commandProcessor, &CommandProcessor::mutationRecorded,
+                this, [this](const QJsonObject& record) {
+                    if (m_rabbitMQHandler) {
+                        m_rabbitMQHandler->sendResponse(
+                            record, ReplicationStream::mutationRoutingKey());
+                    }
+                }, Qt::DirectConnection);
+
+        m_heartbeatTimer = new QTimer(this);
+        connect(m_heartbeatTimer, &QTimer::timeout, this, [this]() {
+            if (m_rabbitMQHandler) {
+                m_rabbitMQHandler->sendResponse(
+                    m_commandProcessor->replicationHeartbeat(),
+                    ReplicationStream::mutationRoutingKey());
+            }
+        });
+        m_heartbeatTimer->start(REPLICATION_HEARTBEAT_MS);
+    }
+}
+
 void TerminalGraphServer::shutdown()
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     
     qCDebug(lcServer) << "Shutting down Terminal Graph Server...";
     
+    if (m_heartbeatTimer) {
+        m_heartbeatTimer->stop();
+    }
+
     // Disconnect from RabbitMQ
     if (m_rabbitMQHandler) {
         m_rabbitMQHandler->disconnect();
@@ -538,7 +612,7 @@ void TerminalGraphServer::shutdown()
 
 bool TerminalGraphServer::isConnected() const
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     
     return m_rabbitMQHandler && m_rabbitMQHandler->isConnected();
 }
@@ -547,7 +621,7 @@ QVariant
 TerminalGraphServer::processCommand(const QString& command,
                                     const QVariantMap& params)
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     
     if (!m_commandProcessor) {
         qCWarning(lcServer) << "Cannot process command: command processor is null";
@@ -559,7 +633,7 @@ TerminalGraphServer::processCommand(const QString& command,
 
 void TerminalGraphServer::onMessageReceived(const QJsonObject& message)
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     
     // Emit signal for monitoring
     emit messageReceived(message);
@@ -578,6 +652,9 @@ void TerminalGraphServer::onMessageReceived(const QJsonObject& message)
         
         // Add server ID to response
         response["server_id"] = m_serverId;
+        if (m_shardCount > 1) {
+            response["shard_index"] = m_shardIndex;
+        }
         
         // Copy message ID if present
         if (message.contains("message_id")) {
@@ -620,4 +697,19 @@ void TerminalGraphServer::onMessageReceived(const QJsonObject& message)
         message.value("replyRoutingKey").toString());
 }
 
+void TerminalGraphServer::onMutationReceived(const QJsonObject& record)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+
+    if (!m_commandProcessor) {
+        return;
+    }
+
+    try {
+        m_commandProcessor->applyReplicatedMutation(record);
+    } catch (const std::exception& e) {
+        qCCritical(lcServer) << "Replica stopped serving reads:" << e.what();
+    }
+}
+
 } // namespace TerminalSim
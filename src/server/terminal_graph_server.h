@@ -49,6 +49,40 @@ public:
         const QString& rabbitMQPassword = "guest"
     );
     
+    /**
+     * @brief Run as one shard of a sharded deployment
+     *
+     * Each shard holds the whole topology and the runtime state of the
+     * terminals it owns on the consistent-hash ring. Call before
+     * initialize().
+     * @param shardIndex Index of this shard
+     * @param shardCount Number of shards; 1 is an unsharded server
+     * @throws std::invalid_argument if the index is out of range
+     * @see ShardRing
+     */
+    void setShard(int shardIndex, int shardCount);
+
+    /**
+     * @brief Run as the primary or a replica of a replicated deployment
+     *
+     * A primary publishes its applied mutations and a heartbeat every
+     * second; a replica applies them and serves read queries. Call before
+     * initialize().
+     * @param replication Role, runtime replication and staleness bound
+     * @see ReplicationStream
+     */
+    void setReplication(const ReplicationStream& replication);
+
+    /**
+     * @brief Size the pool that runs the parallel parts of commands
+     *
+     * Batch routing, top-path searches, bulk terminal imports and system
+     * dynamics sweeps share it. Call before initialize().
+     * @param count Worker threads; 0 uses one per core
+     * @throws std::invalid_argument if count is negative
+     */
+    void setWorkerThreads(int count);
+
     /**
      * @brief Shut down the server
      */
@@ -94,6 +128,12 @@ private slots:
      * @param message The received message
      */
     void onMessageReceived(const QJsonObject& message);
+
+    /**
+     * @brief Apply a record of the primary's mutation stream
+     * @param record The received record
+     */
+    void onMutationReceived(const QJsonObject& record);
     
 private:
     // Constructor is private for singleton
@@ -109,6 +149,9 @@ private:
     static TerminalGraphServer* s_instance;
     static QMutex s_instanceMutex;
     
+    // Workers for the graph's parallel work; outlives the graph
+    WorkStealingPool* m_taskPool;
+
     // Terminal graph
     TerminalGraph* m_graph;
     QString m_pathToTerminalsDirectory;
@@ -122,9 +165,17 @@ private:
     
     // Server ID
     QString m_serverId;
+
+    // Shard served by this process
+    int m_shardIndex;
+    int m_shardCount;
+
+    // Replication role, and the primary's heartbeat
+    ReplicationRole m_replicationRole;
+    QTimer* m_heartbeatTimer;
     
     // Thread safety
-    mutable QMutex m_mutex;
+    mutable ProfiledMutex m_mutex{"TerminalGraphServer::m_mutex"};
 };
 
 } // namespace TerminalSim
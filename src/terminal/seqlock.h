@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace TerminalSim
+{
+
+/**
+ * @brief Copy of a small value that readers take without a lock
+ *
+ * A single writer, serialized by the owner's lock, bumps the sequence to
+ * odd, stores the value and bumps it back to even. A reader copies the
+ * value between two reads of the sequence and retries if a write
+ * overlapped. The value is held as atomic words so that a torn copy is
+ * discarded rather than being a data race.
+ *
+ * Readers never block writers; they only spin while a store is in
+ * flight, which for a few dozen bytes is a handful of instructions.
+ */
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock values are copied word by word");
+
+public:
+    SeqLock() { store(T{}); }
+
+    /**
+     * @brief Publish a new value; callers must not store concurrently
+     */
+    void store(const T &value)
+    {
+        std::array<quint64, Words> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const quint32 sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = 0; i < Words; ++i)
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy of the last published value
+     */
+    T load() const
+    {
+        std::array<quint64, Words> words;
+        quint32 before = 0;
+        quint32 after  = 0;
+        do
+        {
+            before = m_sequence.load(std::memory_order_acquire);
+            for (int i = 0; i < Words; ++i)
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1U) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr int Words =
+        static_cast<int>((sizeof(T) + sizeof(quint64) - 1) / sizeof(quint64));
+
+    std::atomic<quint32>                   m_sequence{0};
+    std::array<std::atomic<quint64>, Words> m_words{};
+};
+
+} // namespace TerminalSim
@@ -182,7 +182,6 @@ Terminal::Terminal(
     , m_fixedCost(0.0)
     , m_customsCost(0.0)
     , m_riskFactor(0.0)
-    , m_storage(nullptr)
     , m_folderPath(pathToTerminalFolder)
     , m_sdParams()
     , m_sdState()
@@ -308,7 +307,7 @@ Terminal::Terminal(
 
     // Initialize storage
     if (m_folderPath.isEmpty() || !QDir(m_folderPath).exists()) {
-        m_storage = new ContainerCore::ContainerMap();
+        m_storage = std::make_shared<ContainerCore::ContainerMap>();
         m_sqlFile = QString();
     } else {
         QDir storageDir = QDir(m_folderPath);
@@ -317,8 +316,10 @@ Terminal::Terminal(
         }
         
         m_sqlFile = storageDir.filePath(m_terminalName + ".sql");
-        m_storage = new ContainerCore::ContainerMap(m_sqlFile);
+        m_storage = std::make_shared<ContainerCore::ContainerMap>(m_sqlFile);
     }
+    publishContainerCountLocked();
+    publishSystemDynamicsLocked();
     
     qCDebug(lcTerminal) << "Terminal" << m_terminalName
                        << "initialized with" << m_interfaces.size()
@@ -330,13 +331,12 @@ Terminal::Terminal(
 Terminal::~Terminal()
 {
     qCDebug(lcTerminal) << "Destroying terminal" << m_terminalName;
-    delete m_storage;
 }
 
 QString Terminal::getAliasByModeNetwork(TransportationMode mode,
                                         const QString& network) const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     return m_modeNetworkAliases.value(qMakePair(mode, network));
 }
 
@@ -344,7 +344,7 @@ void Terminal::addAliasForModeNetwork(TransportationMode mode,
                                       const QString& network,
                                       const QString& alias)
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
     m_modeNetworkAliases[qMakePair(mode, network)] = alias;
     qCDebug(lcTerminal) << "Added alias" << alias
                        << "for terminal" << m_terminalName
@@ -355,10 +355,13 @@ void Terminal::addAliasForModeNetwork(TransportationMode mode,
 QPair<bool, QString>
 Terminal::checkCapacityStatusInternal(int additionalContainers) const
 {
-    // Caller must hold m_mutex
-    int currentCount = m_storage->size();
-    int newCount = currentCount + additionalContainers;
+    // Caller must hold m_lock
+    return capacityStatusFor(static_cast<int>(m_storage->size())
+                             + additionalContainers);
+}
 
+QPair<bool, QString> Terminal::capacityStatusFor(int newCount) const
+{
     // If unlimited capacity
     if (m_maxCapacity == std::numeric_limits<int>::max()) {
         return qMakePair(true, QString("OK"));
@@ -400,13 +403,14 @@ Terminal::checkCapacityStatusInternal(int additionalContainers) const
 QPair<bool, QString>
 Terminal::checkCapacityStatus(int additionalContainers) const
 {
-    QMutexLocker locker(&m_mutex);
-    return checkCapacityStatusInternal(additionalContainers);
+    // Wait-free: the published count against capacity settings that never
+    // change once the terminal is shared
+    return capacityStatusFor(getContainerCount() + additionalContainers);
 }
 
 double Terminal::estimateContainerHandlingTime() const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
 
     double totalSeconds = 0.0;
 
@@ -432,7 +436,7 @@ Terminal::estimateContainerCostInternal(
     const ContainerCore::Container *container,
     bool applyCustoms) const
 {
-    // Caller must hold m_mutex
+    // Caller must hold m_lock
     double totalCost = 0.0;
 
     // Add fixed cost if applicable
@@ -467,7 +471,7 @@ double
 Terminal::estimateContainerCost(const ContainerCore::Container *container,
                                 bool applyCustoms) const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     return estimateContainerCostInternal(container, applyCustoms);
 }
 
@@ -482,7 +486,7 @@ double Terminal::estimateTotalCostByWeights(
 bool Terminal::canAcceptTransport(TransportationMode mode,
                                   TerminalInterface side) const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     
     auto it = m_interfaces.find(side);
     if (it == m_interfaces.end()) {
@@ -497,7 +501,8 @@ void Terminal::addContainer(const ContainerCore::Container& container,
                             TransportationMode arrivalMode,
                             TerminalArrivalSemantics arrivalSemantics)
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
     const QJsonObject before = runtimeTerminalSnapshotLocked();
     const HandlingMetadata metadata =
         extractHandlingMetadataLocked(container, arrivalMode);
@@ -520,9 +525,10 @@ Terminal::addContainers(const QList<ContainerCore::Container>& containers,
                         TransportationMode arrivalMode,
                         TerminalArrivalSemantics arrivalSemantics)
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
 
-    // Check capacity before adding containers (internal — we hold m_mutex)
+    // Check capacity before adding containers (internal — we hold m_lock)
     int containerCount = containers.size();
 
     QPair<bool, QString> capacityStatus = checkCapacityStatusInternal(containerCount);
@@ -684,7 +690,7 @@ QJsonArray
 Terminal::getContainers(
     const ContainerCore::ContainerSelectionCriteria &criteria) const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
 
     QVector<ContainerCore::Container *> containers =
         m_storage->getContainers(criteria);
@@ -715,7 +721,8 @@ Terminal::dequeueContainers(
     const ContainerCore::ContainerSelectionCriteria &criteria,
     double operationTime)
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
 
     ContainerCore::ContainerSelectionCriteria effectiveCriteria = criteria;
     int remainingCapacity = -1;
@@ -761,7 +768,8 @@ QJsonObject Terminal::reserveContainers(
             "reservation_id must be provided");
     }
 
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
     const QString normalizedReservationId = reservationId.trimmed();
 
     if (m_completedContainerReservations.contains(normalizedReservationId))
@@ -851,7 +859,8 @@ QJsonObject Terminal::commitContainerReservation(
             "reservation_id must be provided");
     }
 
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
     const QString normalizedReservationId = reservationId.trimmed();
 
     if (m_completedContainerReservations.contains(normalizedReservationId))
@@ -913,7 +922,8 @@ QJsonObject Terminal::releaseContainerReservation(
             "reservation_id must be provided");
     }
 
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
     const QString normalizedReservationId = reservationId.trimmed();
 
     if (m_completedContainerReservations.contains(normalizedReservationId))
@@ -939,37 +949,32 @@ QJsonObject Terminal::releaseContainerReservation(
 
 int Terminal::getContainerCount() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_storage->size();
+    // Wait-free. A terminal still behind the run epoch is empty as far as
+    // callers can tell, whatever its storage holds until it next syncs.
+    if (runtimeEpochPending())
+        return 0;
+    return m_containerCount.load(std::memory_order_acquire);
 }
 
 int Terminal::getAvailableCapacity() const
 {
-    // Create a copy of needed values with minimal locking
-    QMutexLocker locker(&m_mutex);
-    int maxCap = m_maxCapacity;
-    locker.unlock();
-
-    // Get the container count
-    int currentCount =
-        getContainerCount(); // This method will handle its own locking
-
-    if (maxCap == std::numeric_limits<int>::max()) {
+    if (m_maxCapacity == std::numeric_limits<int>::max()) {
         return std::numeric_limits<int>::max();
     }
 
-    return maxCap - currentCount;
+    return m_maxCapacity - getContainerCount();
 }
 
 int Terminal::getMaxCapacity() const
 {
-    QMutexLocker locker(&m_mutex);
+    // Set before the terminal is shared and never changed after
     return m_maxCapacity;
 }
 
 void Terminal::clear()
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
 
     qCDebug(lcTerminal) << "Clearing all containers from terminal" << m_terminalName;
     resetRuntimeStateLocked(/*clearExecutionRecords=*/false);
@@ -977,16 +982,63 @@ void Terminal::clear()
 
 void Terminal::resetRuntimeState()
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
 
     qCDebug(lcTerminal) << "Resetting runtime state for terminal"
                         << m_terminalName;
     resetRuntimeStateLocked(/*clearExecutionRecords=*/true);
 }
 
+Terminal *Terminal::fork() const
+{
+    ReadLocker locker(this);
+
+    auto *branch = new Terminal(m_terminalName, m_displayName, m_interfaces,
+                                m_modeNetworkAliases);
+    branch->m_maxCapacity          = m_maxCapacity;
+    branch->m_criticalThreshold    = m_criticalThreshold;
+    branch->m_dwellTimeMethod      = m_dwellTimeMethod;
+    branch->m_dwellTimeParameters  = m_dwellTimeParameters;
+    branch->m_customsProbability   = m_customsProbability;
+    branch->m_customsDelayMean     = m_customsDelayMean;
+    branch->m_customsDelayVariance = m_customsDelayVariance;
+    branch->m_fixedCost            = m_fixedCost;
+    branch->m_customsCost          = m_customsCost;
+    branch->m_riskFactor           = m_riskFactor;
+    branch->m_sdParams             = m_sdParams;
+    branch->m_sdState              = m_sdState;
+
+    // An SQL-backed map is tied to its file, so only in-memory storage is
+    // shared. Neither side owns shared storage any more; whichever writes
+    // first copies it, even if the other side is gone by then.
+    if (m_sqlFile.isEmpty()) {
+        branch->m_storage = m_storage;
+        branch->m_ownsStorage.store(false, std::memory_order_relaxed);
+        m_ownsStorage.store(false, std::memory_order_relaxed);
+    } else {
+        branch->m_storage = copyStorageLocked();
+    }
+    branch->publishContainerCountLocked();
+    branch->publishSystemDynamicsLocked();
+
+    branch->m_handlingBatchRecordsByExecution =
+        m_handlingBatchRecordsByExecution;
+    branch->m_containerReservations  = m_containerReservations;
+    branch->m_reservedContainerIds   = m_reservedContainerIds;
+    branch->m_completedContainerReservations =
+        m_completedContainerReservations;
+    branch->m_releasedContainerReservations =
+        m_releasedContainerReservations;
+
+    qCDebug(lcTerminal) << "Forked terminal" << m_terminalName << "with"
+                        << m_storage->size() << "containers";
+    return branch;
+}
+
 QJsonObject Terminal::toJson() const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
 
     QJsonObject json;
 
@@ -1342,32 +1394,25 @@ Terminal::parseModeNetworkAliases(const QVariantMap &aliasesMap)
 // System Dynamics Implementation
 // ============================================================================
 
-double Terminal::calculateCongestion(double utilization) const
+double SystemDynamicsParams::congestion(double utilization) const
 {
     // Equation 4: G_k(t) = clamp(((U_k - U_crit) / (1 - U_crit))^γ, 0, 1)
-    if (utilization <= m_sdParams.criticalUtilization)
+    if (utilization <= criticalUtilization)
     {
         return 0.0;
     }
 
-    double normalized = (utilization - m_sdParams.criticalUtilization) /
-                        (1.0 - m_sdParams.criticalUtilization);
-    double congestion = std::pow(normalized, m_sdParams.congestionExponent);
+    double normalized = (utilization - criticalUtilization) /
+                        (1.0 - criticalUtilization);
+    double congestion = std::pow(normalized, congestionExponent);
     return std::min(1.0, congestion);
 }
 
-double Terminal::calculateServiceCapacity(double congestion) const
-{
-    // Equation 5: S_k^cap = S_max / (1 + β * G_k)
-    return m_sdParams.maxServiceRate /
-           (1.0 + m_sdParams.congestionSensitivity * congestion);
-}
-
-double Terminal::calculateDelayMultiplier(double utilization,
-                                          TransportationMode mode) const
+double SystemDynamicsParams::delayMultiplier(double utilization,
+                                             TransportationMode mode) const
 {
     // If utilization is below critical threshold, no congestion delay
-    if (utilization <= m_sdParams.criticalUtilization) {
+    if (utilization <= criticalUtilization) {
         return 1.0;
     }
 
@@ -1375,34 +1420,33 @@ double Terminal::calculateDelayMultiplier(double utilization,
     const ModeDelayParams* params = nullptr;
     switch (mode) {
         case TransportationMode::Ship:
-            params = &m_sdParams.shipDelay;
+            params = &shipDelay;
             break;
         case TransportationMode::Truck:
-            params = &m_sdParams.truckDelay;
+            params = &truckDelay;
             break;
         case TransportationMode::Train:
-            params = &m_sdParams.trainDelay;
+            params = &trainDelay;
             break;
         case TransportationMode::Any:
         default:
             // Fallback: use legacy linear formula M = 1 + δ * G_k
-            return 1.0 + m_sdParams.delaySensitivity *
-                         calculateCongestion(utilization);
+            return 1.0 + delaySensitivity * congestion(utilization);
     }
 
     // Continuous BPR-inspired volume-delay function (normalized excess):
     // M_k(t, mode) = 1 + α · ((U_k - U_crit) / (1 - U_crit))^β
     // Continuous at U_k = U_crit (numerator → 0), max multiplier 1+α at U_k = 1.
-    double range  = 1.0 - m_sdParams.criticalUtilization;
-    double excess = utilization - m_sdParams.criticalUtilization;
+    double range  = 1.0 - criticalUtilization;
+    double excess = utilization - criticalUtilization;
     return 1.0 + params->alpha * std::pow(excess / range, params->beta);
 }
 
-double Terminal::calculateArrivalPenalty(double utilization,
-                                         TransportationMode mode) const
+double SystemDynamicsParams::arrivalPenalty(double utilization,
+                                            TransportationMode mode) const
 {
     // No penalty below critical utilization
-    if (utilization <= m_sdParams.criticalUtilization) {
+    if (utilization <= criticalUtilization) {
         return 0.0;
     }
 
@@ -1410,13 +1454,13 @@ double Terminal::calculateArrivalPenalty(double utilization,
     double basePenalty = 0.0;
     switch (mode) {
         case TransportationMode::Ship:
-            basePenalty = m_sdParams.shipArrivalPenalty;
+            basePenalty = shipArrivalPenalty;
             break;
         case TransportationMode::Truck:
-            basePenalty = m_sdParams.truckArrivalPenalty;
+            basePenalty = truckArrivalPenalty;
             break;
         case TransportationMode::Train:
-            basePenalty = m_sdParams.trainArrivalPenalty;
+            basePenalty = trainArrivalPenalty;
             break;
         case TransportationMode::Any:
         default:
@@ -1424,8 +1468,118 @@ double Terminal::calculateArrivalPenalty(double utilization,
     }
 
     // Scale penalty by congestion level G_k(t) in [0, 1]
-    double congestion = calculateCongestion(utilization);
-    return basePenalty * congestion;
+    return basePenalty * congestion(utilization);
+}
+
+double TerminalHandlingModel::utilizationFor(int containers) const
+{
+    if (maxCapacity > 0 && maxCapacity != std::numeric_limits<int>::max())
+    {
+        return static_cast<double>(containers)
+               / static_cast<double>(maxCapacity);
+    }
+
+    // Unlimited capacity means no congestion from utilization
+    return 0.0;
+}
+
+TerminalHandlingModel::Sample
+TerminalHandlingModel::sampleArrival(double             utilization,
+                                     TransportationMode mode,
+                                     std::mt19937      &generator) const
+{
+    // Mirrors the runtime branch of Terminal::handleContainerArrivalLocked
+    Sample sample;
+    if (!dwellTimeMethod.isEmpty() && !dwellTimeParameters.isEmpty())
+    {
+        sample.yardDwellSeconds = ContainerDwellTime::sampleDwellTime(
+            dwellTimeMethod, dwellTimeParameters, generator);
+    }
+
+    if (dynamics.enabled)
+    {
+        const double yardMultiplier =
+            dynamics.delayMultiplier(utilization, mode);
+        if (yardMultiplier > 1.0)
+        {
+            sample.yardDwellSeconds *= yardMultiplier;
+        }
+    }
+
+    if (customsProbability > 0.0 && customsDelayMean > 0.0)
+    {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        if (uniform(generator) < customsProbability)
+        {
+            const double stdDev = (customsDelayVariance > 0.0)
+                                      ? std::sqrt(customsDelayVariance)
+                                      : 1.0;
+            std::normal_distribution<double> normalDist(customsDelayMean,
+                                                        stdDev);
+            sample.customsDelaySeconds = qMax(0.0, normalDist(generator));
+            sample.customsApplied      = true;
+        }
+    }
+
+    if (dynamics.enabled && utilization > dynamics.criticalUtilization)
+    {
+        sample.arrivalPenaltySeconds =
+            dynamics.arrivalPenalty(utilization, mode);
+    }
+
+    if (fixedCost > 0.0)
+    {
+        sample.directCostUsd += fixedCost;
+    }
+    if (sample.customsApplied && customsCost > 0.0)
+    {
+        sample.directCostUsd += customsCost;
+    }
+    return sample;
+}
+
+TerminalHandlingModel Terminal::handlingModel() const
+{
+    ReadLocker locker(this);
+
+    TerminalHandlingModel model;
+    model.terminalName         = m_terminalName;
+    model.dwellTimeMethod      = m_dwellTimeMethod;
+    model.dwellTimeParameters  = m_dwellTimeParameters;
+    model.customsProbability   = m_customsProbability;
+    model.customsDelayMean     = m_customsDelayMean;
+    model.customsDelayVariance = m_customsDelayVariance;
+    model.fixedCost            = m_fixedCost;
+    model.customsCost          = m_customsCost;
+    model.maxCapacity          = m_maxCapacity;
+    model.containerCount       = m_storage ? m_storage->size() : 0;
+    model.utilization          = m_sdState.utilization;
+    model.dynamics             = m_sdParams;
+    return model;
+}
+
+double Terminal::calculateCongestion(double utilization) const
+{
+    return m_sdParams.congestion(utilization);
+}
+
+double Terminal::calculateServiceCapacity(double congestion) const
+{
+    // Equation 5: S_k^cap = S_max / (1 + β * G_k)
+    return m_sdParams.maxServiceRate /
+           (1.0 + m_sdParams.congestionSensitivity * congestion);
+}
+
+double Terminal::calculateDelayMultiplier(double utilization,
+                                          TransportationMode mode) const
+{
+    return m_sdParams.delayMultiplier(utilization, mode);
+}
+
+double Terminal::calculateArrivalPenalty(double utilization,
+                                         TransportationMode mode) const
+{
+    return m_sdParams.arrivalPenalty(utilization, mode);
 }
 
 QJsonObject Terminal::runtimeTerminalProjectionLocked(
@@ -1564,7 +1718,7 @@ Terminal::ContainerHandlingOutcome Terminal::handleContainerArrivalLocked(
     TransportationMode              arrivalMode,
     TerminalArrivalSemantics        arrivalSemantics)
 {
-    // Caller must hold m_mutex.
+    // Caller must hold m_lock.
     QPair<bool, QString> capacityStatus =
         checkCapacityStatusInternal(1);
     if (!capacityStatus.first) {
@@ -1705,10 +1859,11 @@ Terminal::ContainerHandlingOutcome Terminal::handleContainerArrivalLocked(
             NoHauler::noHauler, "time", totalTime);
     }
     containerCopy->setContainerCurrentLocation(m_terminalName);
-    m_storage->addContainer(containerCopy->getContainerID(),
-                            containerCopy,
-                            outcome.baseAddingTime,
-                            outcome.baseDeparture);
+    mutableStorageLocked()->addContainer(containerCopy->getContainerID(),
+                                         containerCopy,
+                                         outcome.baseAddingTime,
+                                         outcome.baseDeparture);
+    publishContainerCountLocked();
 
     qCDebug(lcTerminal) << "Container" << containerCopy->getContainerID()
                         << "added to terminal" << m_terminalName
@@ -1834,8 +1989,9 @@ QJsonArray Terminal::removeContainersAndRecordPickupLocked(
                    : container->getContainerLeavingTime());
         groupedOutcomes[key].append(outcome);
 
-        m_storage->removeContainerByID(containerId);
+        mutableStorageLocked()->removeContainerByID(containerId);
     }
+    publishContainerCountLocked();
 
     const QJsonObject stateSnapshotAfter =
         runtimeTerminalSnapshotLocked();
@@ -1943,7 +2099,8 @@ QList<TerminalExecutionResult> Terminal::terminalExecutionResultsLocked(
 
 void Terminal::updateSystemDynamics(double currentTime, double deltaT)
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
 
     if (!m_sdParams.enabled)
     {
@@ -1998,26 +2155,36 @@ void Terminal::updateSystemDynamics(double currentTime, double deltaT)
 
 QJsonObject Terminal::getSystemDynamicsState() const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     return runtimeTerminalSnapshotLocked();
 }
 
+SystemDynamicsState Terminal::systemDynamicsState() const
+{
+    // Lock-free unless a pending epoch reset has to run first
+    if (runtimeEpochPending()) {
+        ReadLocker locker(this);
+        return m_sdState;
+    }
+    return m_sdSnapshot.load();
+}
+
 QJsonObject Terminal::getRuntimeTerminalSnapshot() const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     return runtimeTerminalSnapshotLocked();
 }
 
 QJsonObject Terminal::getRuntimeTerminalProjection(
     TransportationMode mode) const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     return runtimeTerminalProjectionLocked(mode);
 }
 
 QJsonObject Terminal::getRuntimeTerminalProjectionsByMode() const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     QJsonObject projections;
     projections["terminal_id"] = m_terminalName;
     projections["ship"] = runtimeTerminalProjectionLocked(
@@ -2033,7 +2200,7 @@ QJsonArray Terminal::getTerminalExecutionResults(
     const QString     &executionId,
     const QStringList &canonicalPathKeys) const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     QJsonArray   results;
     for (const auto &result :
          terminalExecutionResultsLocked(executionId, canonicalPathKeys)) {
@@ -2045,7 +2212,8 @@ QJsonArray Terminal::getTerminalExecutionResults(
 int Terminal::clearTerminalExecutionResults(
     const QString &executionId)
 {
-    QMutexLocker locker(&m_mutex);
+    WriteLocker locker(this);
+    syncRuntimeEpochLocked();
     if (executionId.isEmpty()) {
         int cleared = 0;
         for (auto it = m_handlingBatchRecordsByExecution.constBegin();
@@ -2062,15 +2230,30 @@ int Terminal::clearTerminalExecutionResults(
     return cleared;
 }
 
+double Terminal::getDelayMultiplier() const
+{
+    return systemDynamicsState().delayMultiplier;
+}
+
+double Terminal::getCongestionLevel() const
+{
+    return systemDynamicsState().congestion;
+}
+
+double Terminal::getServiceCapacity() const
+{
+    return systemDynamicsState().serviceCapacity;
+}
+
 double Terminal::getDelayMultiplier(TransportationMode mode) const
 {
-    QMutexLocker locker(&m_mutex);
-    return calculateDelayMultiplier(m_sdState.utilization, mode);
+    // SD parameters are fixed once the terminal is built
+    return calculateDelayMultiplier(systemDynamicsState().utilization, mode);
 }
 
 int Terminal::getRemainingServiceCapacity() const
 {
-    QMutexLocker locker(&m_mutex);
+    ReadLocker locker(this);
     return remainingServiceCapacityLocked();
 }
 
@@ -2089,15 +2272,143 @@ int Terminal::remainingServiceCapacityLocked() const
 
 int Terminal::capacityThisStep() const
 {
-    // Caller must hold m_mutex (or be on a read-only path).
+    // Caller must hold m_lock (or be on a read-only path).
     return m_sdState.serviceCapacityThisStep;
 }
 
+void Terminal::setRuntimeEpochSource(
+    std::shared_ptr<const std::atomic<quint64>> source)
+{
+    WriteLocker locker(this);
+    m_runtimeEpochSource = std::move(source);
+    m_runtimeEpoch.store(m_runtimeEpochSource
+                             ? m_runtimeEpochSource->load(
+                                   std::memory_order_acquire)
+                             : 0,
+                         std::memory_order_release);
+}
+
+void Terminal::syncRuntimeEpochLocked() const
+{
+    // Caller must hold m_lock exclusively. State from an earlier epoch is
+    // already gone as far as callers can tell, so dropping it here is not a
+    // visible change and const callers may do it too.
+    if (!m_runtimeEpochSource)
+        return;
+
+    const quint64 epoch =
+        m_runtimeEpochSource->load(std::memory_order_acquire);
+    if (epoch == m_runtimeEpoch.load(std::memory_order_relaxed))
+        return;
+
+    auto *self = const_cast<Terminal *>(this);
+    self->resetRuntimeStateLocked(/*clearExecutionRecords=*/true);
+    self->m_runtimeEpoch.store(epoch, std::memory_order_release);
+}
+
+bool Terminal::runtimeEpochPending() const
+{
+    // Lock-free; the source is set before the terminal is shared
+    return m_runtimeEpochSource
+           && m_runtimeEpochSource->load(std::memory_order_acquire)
+                  != m_runtimeEpoch.load(std::memory_order_acquire);
+}
+
+void Terminal::publishSystemDynamicsLocked()
+{
+    // Caller must hold m_lock exclusively, or own a terminal not yet
+    // shared.
+    m_sdSnapshot.store(m_sdState);
+}
+
+Terminal::ReadLocker::ReadLocker(const Terminal *terminal, const char *site)
+    : m_lock(&terminal->m_lock)
+{
+    if (!terminal->m_sqlFile.isEmpty()) {
+        m_lock->lockForWrite(site);
+        terminal->syncRuntimeEpochLocked();
+        return;
+    }
+
+    // The reset needs the lock to itself; loop in case the epoch moves
+    // again before the shared lock is back
+    m_lock->lockForRead(site);
+    while (terminal->runtimeEpochPending()) {
+        m_lock->unlock();
+        m_lock->lockForWrite(site);
+        terminal->syncRuntimeEpochLocked();
+        m_lock->unlock();
+        m_lock->lockForRead(site);
+    }
+}
+
+Terminal::ReadLocker::~ReadLocker()
+{
+    m_lock->unlock();
+}
+
+Terminal::WriteLocker::WriteLocker(Terminal *terminal, const char *site)
+    : m_terminal(terminal)
+{
+    m_terminal->m_lock.lockForWrite(site);
+}
+
+Terminal::WriteLocker::~WriteLocker()
+{
+    m_terminal->publishSystemDynamicsLocked();
+    m_terminal->m_lock.unlock();
+}
+
+void Terminal::publishContainerCountLocked()
+{
+    // Caller must hold m_lock, or own a terminal not yet shared. Count
+    // readers skip the lock, so this follows every storage change.
+    const int count = m_storage ? static_cast<int>(m_storage->size()) : 0;
+    m_containerCount.store(count, std::memory_order_release);
+}
+
+ContainerCore::ContainerMap *Terminal::mutableStorageLocked()
+{
+    // Caller must hold m_lock for writing. Storage shared at fork time is
+    // read-only; the first write takes a private copy of every container.
+    if (!m_ownsStorage.load(std::memory_order_relaxed)) {
+        m_storage = copyStorageLocked();
+        m_ownsStorage.store(true, std::memory_order_relaxed);
+    }
+    return m_storage.get();
+}
+
+std::shared_ptr<ContainerCore::ContainerMap>
+Terminal::copyStorageLocked() const
+{
+    // Caller must hold m_lock.
+    auto copy = std::make_shared<ContainerCore::ContainerMap>();
+
+    ContainerCore::ContainerSelectionCriteria criteria;
+    criteria.limit = -1;
+    const QVector<ContainerCore::Container *> containers =
+        m_storage->getContainers(criteria);
+    for (const auto *container : containers) {
+        if (!container)
+            continue;
+        copy->addContainer(container->getContainerID(), container->copy(),
+                           container->getContainerAddedTime(),
+                           container->getContainerLeavingTime());
+    }
+    return copy;
+}
+
 void Terminal::resetRuntimeStateLocked(bool clearExecutionRecords)
 {
-    // Caller must hold m_mutex.
-    if (m_storage)
+    // Caller must hold m_lock. A fork may still read shared storage, so
+    // it is let go rather than cleared.
+    if (!m_ownsStorage.load(std::memory_order_relaxed)) {
+        m_storage = std::make_shared<ContainerCore::ContainerMap>();
+        m_ownsStorage.store(true, std::memory_order_relaxed);
+    } else if (m_storage) {
         m_storage->clear();
+    }
+    publishContainerCountLocked();
     m_containerReservations.clear();
     m_reservedContainerIds.clear();
     m_completedContainerReservations.clear();
@@ -2111,11 +2422,12 @@ void Terminal::resetRuntimeStateLocked(bool clearExecutionRecords)
         m_sdState.delayMultiplier = 1.0;
         refreshServiceCapacityBudgetLocked();
     }
+    publishSystemDynamicsLocked();
 }
 
 void Terminal::refreshServiceCapacityBudgetLocked()
 {
-    // Caller must hold m_mutex.
+    // Caller must hold m_lock.
     if (!m_sdParams.enabled) {
         m_sdState.serviceCapacityThisStep =
             std::numeric_limits<int>::max();
@@ -4,18 +4,23 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QMap>
-#include <QMutex>
 #include <QObject>
 #include <QPair>
 #include <QSet>
 #include <QString>
 #include <QStringList>
 #include <QVariantMap>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <random>
 
 #include <containerLib/container.h>
 #include <containerLib/containermap.h>
 
+#include "common/ProfiledMutex.h"
 #include "common/common.h"
+#include "seqlock.h"
 
 namespace TerminalSim
 {
@@ -63,6 +68,26 @@ struct SystemDynamicsParams
     double shipArrivalPenalty  = 14400.0;  ///< Ship arrival penalty (seconds). 4 hours of berth waiting at anchorage.
     double truckArrivalPenalty =  1800.0;  ///< Truck arrival penalty (seconds). 0.5 hours of gate-in queue.
     double trainArrivalPenalty =  7200.0;  ///< Train arrival penalty (seconds). 2 hours of rail unloading.
+
+    /**
+     * @brief Congestion level G_k for a utilization (Equation 4)
+     */
+    double congestion(double utilization) const;
+
+    /**
+     * @brief Delay multiplier M_k for a utilization and mode
+     *
+     * Uses the mode's BPR-style parameters; Any falls back to 1 + δ · G_k.
+     */
+    double delayMultiplier(double utilization, TransportationMode mode) const;
+
+    /**
+     * @brief Arrival-side penalty (seconds) for a utilization and mode
+     *
+     * The mode's base penalty scaled by G_k; zero below critical
+     * utilization and for Any.
+     */
+    double arrivalPenalty(double utilization, TransportationMode mode) const;
 };
 
 /**
@@ -85,6 +110,52 @@ struct SystemDynamicsState
     double deltaT            = 3600.0; ///< Current time step duration (seconds). Default 3600.0 = 1 hour.
 };
 
+/**
+ * @brief Copy of the inputs that drive a terminal's handling draws
+ *
+ * Taken from a live terminal with Terminal::handlingModel(). It draws the
+ * same dwell, customs and arrival-penalty outcomes as a runtime arrival,
+ * but from a caller-owned generator and at a caller-given utilization, so
+ * replications can run in parallel without touching the terminal.
+ */
+struct TerminalHandlingModel
+{
+    struct Sample
+    {
+        double yardDwellSeconds      = 0.0;
+        double customsDelaySeconds   = 0.0;
+        double arrivalPenaltySeconds = 0.0;
+        double directCostUsd         = 0.0;
+        bool   customsApplied        = false;
+    };
+
+    QString              terminalName;
+    QString              dwellTimeMethod;
+    QVariantMap          dwellTimeParameters;
+    double               customsProbability   = 0.0;
+    double               customsDelayMean     = 0.0; ///< Seconds
+    double               customsDelayVariance = 0.0; ///< Seconds²
+    double               fixedCost            = 0.0;
+    double               customsCost          = 0.0;
+    int                  maxCapacity = std::numeric_limits<int>::max();
+    int                  containerCount = 0;   ///< Inventory when taken
+    double               utilization    = 0.0; ///< U_k when taken
+    SystemDynamicsParams dynamics;
+
+    /**
+     * @brief U_k for an inventory, as updateSystemDynamics() computes it
+     */
+    double utilizationFor(int containers) const;
+
+    /**
+     * @brief Draw the handling of one container arriving by a mode
+     *
+     * Value-based risk cost is left out since no container is given.
+     */
+    Sample sampleArrival(double utilization, TransportationMode mode,
+                         std::mt19937 &generator) const;
+};
+
 enum class TerminalArrivalSemantics
 {
     Infer,
@@ -250,7 +321,8 @@ public:
     QJsonObject releaseContainerReservation(
         const QString &reservationId);
 
-    // Terminal status
+    // Terminal status. The counts are wait-free reads of atomics kept in
+    // step with the storage, so status polls never wait on the lock.
     int  getContainerCount() const;
     int  getAvailableCapacity() const;
     int  getMaxCapacity() const;
@@ -268,6 +340,30 @@ public:
         return m_interfaces;
     }
 
+    /**
+     * @brief Copy-on-write branch of this terminal and its runtime state
+     *
+     * The branch shares container storage with this terminal until either
+     * side adds, removes or clears containers; records and reservations
+     * are implicitly shared Qt containers. Terminals backed by an SQL file
+     * are copied up front, and the branch itself is always in memory.
+     * @return New terminal owned by the caller
+     */
+    Terminal *fork() const;
+
+    /**
+     * @brief Follow a run epoch shared with the owning graph
+     *
+     * The terminal joins the current epoch with its current state. Once
+     * the epoch moves on, the next call that takes the terminal lock
+     * resets the runtime state first, so a graph-wide reset only has to
+     * bump the counter. Must be called before the terminal is shared
+     * between threads, since the lock-free counts read the source too.
+     * @param source Counter bumped by TerminalGraph::resetRuntimeState()
+     */
+    void setRuntimeEpochSource(
+        std::shared_ptr<const std::atomic<quint64>> source);
+
     // Serialization
     QJsonObject      toJson() const;
     static Terminal *fromJson(const QJsonObject &json,
@@ -294,6 +390,14 @@ public:
      * @return JSON object containing all SD state variables and parameters
      */
     QJsonObject getSystemDynamicsState() const;
+
+    /**
+     * @brief Copy of the current system dynamics state variables
+     *
+     * Read from a seqlock'd copy, without the terminal lock, as are the
+     * delay multiplier, congestion and service capacity getters.
+     */
+    SystemDynamicsState systemDynamicsState() const;
     QJsonObject getRuntimeTerminalSnapshot() const;
     QJsonObject getRuntimeTerminalProjection(TransportationMode mode) const;
     QJsonObject getRuntimeTerminalProjectionsByMode() const;
@@ -309,11 +413,25 @@ public:
      */
     bool isSystemDynamicsEnabled() const { return m_sdParams.enabled; }
 
+    /**
+     * @brief Check if containers are stored in an SQL file
+     *
+     * SQL storage is tied to the thread that opened it, so callers keep
+     * such terminals off worker pools.
+     */
+    bool hasSqlStorage() const { return !m_sqlFile.isEmpty(); }
+
+    /**
+     * @brief Get system dynamics configuration
+     * @return Parameters set at construction
+     */
+    const SystemDynamicsParams &getSystemDynamicsParams() const { return m_sdParams; }
+
     /**
      * @brief Get current delay multiplier M_k(t)
      * @return Delay multiplier (>= 1.0)
      */
-    double getDelayMultiplier() const { return m_sdState.delayMultiplier; }
+    double getDelayMultiplier() const;
 
     /**
      * @brief Get mode-specific delay multiplier M_k(t, mode)
@@ -326,13 +444,13 @@ public:
      * @brief Get current congestion level G_k(t)
      * @return Congestion level [0, 1]
      */
-    double getCongestionLevel() const { return m_sdState.congestion; }
+    double getCongestionLevel() const;
 
     /**
      * @brief Get current service capacity S_k^cap(t)
      * @return Service capacity in TEU/hour
      */
-    double getServiceCapacity() const { return m_sdState.serviceCapacity; }
+    double getServiceCapacity() const;
 
     /**
      * @brief Get remaining service capacity for current time step
@@ -341,6 +459,12 @@ public:
      */
     int getRemainingServiceCapacity() const;
 
+    /**
+     * @brief Copy the handling parameters and current inventory
+     * @return Model that samples like this terminal without locking it
+     */
+    TerminalHandlingModel handlingModel() const;
+
 private:
     struct ContainerHandlingOutcome
     {
@@ -382,7 +506,7 @@ private:
     QMap<TerminalInterface, QSet<TransportationMode>> m_interfaces;
     QMap<QPair<TransportationMode, QString>, QString> m_modeNetworkAliases;
 
-    // Capacity parameters
+    // Capacity parameters, fixed once the terminal is built
     int    m_maxCapacity;
     double m_criticalThreshold;
 
@@ -400,8 +524,12 @@ private:
     double m_customsCost;
     double m_riskFactor;
 
-    // Storage
-    ContainerCore::ContainerMap *m_storage;
+    // Storage, shared with forks until one of them writes. Shared storage
+    // is never written in place; m_ownsStorage is cleared on both sides at
+    // fork time and the first write after that copies the map.
+    std::shared_ptr<ContainerCore::ContainerMap> m_storage;
+    mutable std::atomic<bool>    m_ownsStorage{true};
+    std::atomic<int>             m_containerCount{0}; // m_storage->size()
     QString                      m_folderPath;
     QString                      m_sqlFile;
 
@@ -416,11 +544,56 @@ private:
     QHash<QString, QJsonObject> m_completedContainerReservations;
     QSet<QString> m_releasedContainerReservations;
 
-    // Thread safety
-    mutable QMutex m_mutex;
+    // Run epoch of the runtime state above; see setRuntimeEpochSource()
+    std::shared_ptr<const std::atomic<quint64>> m_runtimeEpochSource;
+    std::atomic<quint64>                        m_runtimeEpoch{0};
+
+    // Thread safety. Read-only calls share the lock and writers hold it
+    // exclusively, through the lockers below.
+    mutable ProfiledReadWriteLock m_lock{"Terminal::m_lock"};
 
-    // Lock-free helpers (caller must hold m_mutex)
+    // m_sdState as of the last writer, for reads that skip the lock
+    SeqLock<SystemDynamicsState> m_sdSnapshot;
+
+    /**
+     * @brief Lock for read-only calls, with the runtime epoch synced
+     *
+     * Shared for in-memory storage. Exclusive for SQL-backed storage,
+     * whose connection cannot run two queries at once. A pending epoch
+     * reset is run under the exclusive lock before the shared one is
+     * taken.
+     */
+    class ReadLocker
+    {
+    public:
+        explicit ReadLocker(const Terminal *terminal,
+                            const char     *site = TERMINALSIM_LOCK_SITE);
+        ~ReadLocker();
+
+    private:
+        Q_DISABLE_COPY(ReadLocker)
+        ProfiledReadWriteLock *m_lock;
+    };
+
+    /**
+     * @brief Exclusive lock for writers; publishes m_sdState on release
+     */
+    class WriteLocker
+    {
+    public:
+        explicit WriteLocker(Terminal   *terminal,
+                             const char *site = TERMINALSIM_LOCK_SITE);
+        ~WriteLocker();
+
+    private:
+        Q_DISABLE_COPY(WriteLocker)
+        Terminal *m_terminal;
+    };
+
+    // Lock-free helpers (caller must hold m_lock)
     QPair<bool, QString> checkCapacityStatusInternal(int additionalContainers) const;
+    // Needs no lock: reads only the capacity settings fixed at construction
+    QPair<bool, QString> capacityStatusFor(int newCount) const;
     double estimateContainerCostInternal(
         const ContainerCore::Container *container = nullptr,
         bool applyCustoms = false) const;
@@ -432,8 +605,16 @@ private:
      *         The /3600.0 bridge lives here so callers need not repeat it.
      */
     int capacityThisStep() const;
+
+    // Storage to write to, copied first if it was shared by a fork
+    ContainerCore::ContainerMap *mutableStorageLocked();
+    std::shared_ptr<ContainerCore::ContainerMap> copyStorageLocked() const;
     int remainingServiceCapacityLocked() const;
     void resetRuntimeStateLocked(bool clearExecutionRecords);
+    void syncRuntimeEpochLocked() const;
+    bool runtimeEpochPending() const;
+    void publishContainerCountLocked();
+    void publishSystemDynamicsLocked();
     void refreshServiceCapacityBudgetLocked();
 
     // Private SD helper methods
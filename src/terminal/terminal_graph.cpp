@@ -15,8 +15,13 @@
 #include <QUrl>
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <limits>
+#include <numeric>
+#include <random>
 #include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 #include "common/LogCategories.h"
 
@@ -388,11 +393,18 @@ QString buildPathUid(const Path &path)
             QCryptographicHash::Sha256)
             .toHex();
 
+    // Single-mode requests keep the plain mode number so their ids are
+    // unchanged; mixed mode sets are tagged with their bits
+    const QString modeSignature =
+        path.requestedModes.singleMode().has_value()
+            ? QString::number(path.requestedMode)
+            : QStringLiteral("set-%1").arg(path.requestedModes.bits());
+
     return QStringLiteral(
                "pf|v2|start=%1|end=%2|mode=%3|policy=%4|sig=%5")
         .arg(percentEncode(path.startTerminal),
              percentEncode(path.endTerminal),
-             QString::number(path.requestedMode),
+             modeSignature,
              percentEncode(policySignature),
              QString::fromLatin1(signatureHash));
 }
@@ -402,6 +414,51 @@ double estimatedCostValue(const PathSegment &segment, const char *key)
     return segment.estimatedCost.value(QString::fromLatin1(key)).toDouble();
 }
 
+// Mean, sample standard deviation and interpolated percentiles of draws,
+// keyed p05, p50, p95 and so on
+QVariantMap distributionSummary(std::vector<double> values,
+                                const QList<double> &percentiles = {5.0, 50.0,
+                                                                    95.0})
+{
+    if (values.empty())
+    {
+        return QVariantMap();
+    }
+
+    std::sort(values.begin(), values.end());
+    const double count = static_cast<double>(values.size());
+    const double mean =
+        std::accumulate(values.begin(), values.end(), 0.0) / count;
+    double squares = 0.0;
+    for (double value : values)
+    {
+        squares += (value - mean) * (value - mean);
+    }
+
+    auto quantile = [&values](double q) {
+        const double position = q * static_cast<double>(values.size() - 1);
+        const size_t lower    = static_cast<size_t>(std::floor(position));
+        const size_t upper    = std::min(lower + 1, values.size() - 1);
+        return values[lower]
+               + (position - static_cast<double>(lower))
+                     * (values[upper] - values[lower]);
+    };
+
+    QVariantMap summary{
+        {QStringLiteral("mean"), mean},
+        {QStringLiteral("std_dev"),
+         values.size() > 1 ? std::sqrt(squares / (count - 1.0)) : 0.0},
+        {QStringLiteral("min"), values.front()},
+        {QStringLiteral("max"), values.back()}};
+    for (double percentile : percentiles)
+    {
+        summary[QStringLiteral("p")
+                + QString::number(percentile).rightJustified(
+                    2, QLatin1Char('0'))] = quantile(percentile / 100.0);
+    }
+    return summary;
+}
+
 } // namespace
 
 TerminalGraph::TerminalGraph(const QString &dir)
@@ -410,17 +467,25 @@ TerminalGraph::TerminalGraph(const QString &dir)
 {
     m_costFunctionParametersWeights = defaultCostFunctionParameters();
     m_defaultLinkAttributes = defaultLinkAttributes();
+    m_hotRoutePool.setMaxThreadCount(1);
 
     qCInfo(lcTerminalGraph) << "Graph initialized with dir:" << (dir.isEmpty() ? "None" : dir);
 }
 
 TerminalGraph::~TerminalGraph()
 {
+    // Stop route warming before the data it reads goes away
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        m_hotRoutePrecomputeCount = 0;
+    }
+    m_hotRoutePool.waitForDone();
+
     // Copy terminals to a local list while holding the lock
     QList<Terminal *> terminalsToDelete;
 
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
         for (auto it = m_terminals.begin(); it != m_terminals.end(); ++it)
         {
             terminalsToDelete.append(it.value());
@@ -440,8 +505,10 @@ TerminalGraph::~TerminalGraph()
 void TerminalGraph::setCostFunctionParameters(const QVariantMap &params)
 {
     validateCostFunctionParameters(params);
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     m_costFunctionParametersWeights = params;
+    ++m_topologyGeneration;
+    networkChangedLocked();
 }
 
 void TerminalGraph::setLinkDefaultAttributes(const QVariantMap &attrs)
@@ -449,19 +516,23 @@ void TerminalGraph::setLinkDefaultAttributes(const QVariantMap &attrs)
     const QVariantMap validated = validatedAttributeMap(
         attrs, routeAttributeKeys(), routeAttributeKeys(),
         QStringLiteral("default_link_attributes"));
-    QMutexLocker locker(&m_mutex);   // Ensure thread safety
+    ProfiledMutexLocker locker(&m_mutex);   // Ensure thread safety
     m_defaultLinkAttributes = validated; // Update attributes
 }
 
 void TerminalGraph::resetConfigurationToDefaults()
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     m_costFunctionParametersWeights = defaultCostFunctionParameters();
     m_defaultLinkAttributes = defaultLinkAttributes();
+    ++m_topologyGeneration;
+    networkChangedLocked();
 }
 
-Terminal *TerminalGraph::addTerminalInternal(const QVariantMap &terminalData)
+Terminal *TerminalGraph::createTerminal(const QVariantMap &terminalData) const
 {
+    // Reads only settings fixed at construction, so bulk imports may
+    // build terminals in parallel
     const QStringList terminalNames = parseTerminalNames(
         terminalData.value(QStringLiteral("terminal_names")),
         QStringLiteral("terminal"));
@@ -469,7 +540,6 @@ Terminal *TerminalGraph::addTerminalInternal(const QVariantMap &terminalData)
     QString     canonical    = terminalNames.first();
     QString     displayName  = terminalData["display_name"].toString();
     QVariantMap customConfig = terminalData["custom_config"].toMap();
-    QString     region = terminalData.value("region", QString()).toString();
 
     const auto interfaces = parseTerminalInterfaces(
         terminalData.value(QStringLiteral("terminal_interfaces")).toMap(),
@@ -488,9 +558,19 @@ Terminal *TerminalGraph::addTerminalInternal(const QVariantMap &terminalData)
         customConfig.value("cost").toMap(),
         customConfig.value("system_dynamics").toMap(),
         m_pathToTerminalsDirectory);
+    term->setRuntimeEpochSource(m_runtimeEpoch);
+    return term;
+}
+
+Terminal *TerminalGraph::addTerminalInternal(const QVariantMap &terminalData,
+                                             Terminal          *term)
+{
+    const QStringList terminalNames = parseTerminalNames(
+        terminalData.value(QStringLiteral("terminal_names")),
+        QStringLiteral("terminal"));
 
-    // Add vertex to graph
-    m_graph.addVertex(canonical);
+    QString canonical = terminalNames.first();
+    QString region    = terminalData.value("region", QString()).toString();
 
     // Store node attributes
     if (!region.isEmpty())
@@ -513,7 +593,10 @@ Terminal *TerminalGraph::addTerminalInternal(const QVariantMap &terminalData)
 
     // retrieve terminal details
     m_terminalData[canonical] = TerminalDetails{
-        term->estimateContainerHandlingTime(), term->estimateContainerCost()};
+        term->estimateContainerHandlingTime(), term->estimateContainerCost(),
+        term->getSystemDynamicsParams()};
+    ++m_topologyGeneration;
+    networkChangedLocked();
 
     qCDebug(lcTerminalGraph) << "Added terminal" << canonical << "with"
                              << (terminalNames.size() - 1) << "aliases";
@@ -523,7 +606,7 @@ Terminal *TerminalGraph::addTerminalInternal(const QVariantMap &terminalData)
 
 Terminal *TerminalGraph::addTerminal(const QVariantMap &terminalData)
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
 
     // Validate required fields
     if (!terminalData.contains("terminal_names")
@@ -562,13 +645,13 @@ Terminal *TerminalGraph::addTerminal(const QVariantMap &terminalData)
         terminalData.value(QStringLiteral("terminal_interfaces")).toMap(),
         canonical);
 
-    return addTerminalInternal(terminalData);
+    return addTerminalInternal(terminalData, createTerminal(terminalData));
 }
 
 QMap<QString, Terminal *>
 TerminalGraph::addTerminals(const QList<QVariantMap> &terminalsList)
 {
-    QMutexLocker              locker(&m_mutex);
+    ProfiledMutexLocker       locker(&m_mutex);
     QMap<QString, Terminal *> addedTerminals;
     QSet<QString>             allNames;
 
@@ -619,10 +702,24 @@ TerminalGraph::addTerminals(const QList<QVariantMap> &terminalsList)
             canonical);
     }
 
-    // Add all terminals after validation
-    for (const QVariantMap &terminalData : terminalsList)
+    // Build all terminals after validation, then add them in order. SQL
+    // storage opens its connection on the building thread, so only
+    // in-memory terminals are built on the pool.
+    std::vector<std::unique_ptr<Terminal>> built(terminalsList.size());
+    const auto build = [&](size_t i) {
+        built[i].reset(
+            createTerminal(terminalsList.at(static_cast<qsizetype>(i))));
+    };
+    if (m_pathToTerminalsDirectory.isEmpty())
+        taskPool()->parallelFor(built.size(), build);
+    else
+        for (size_t i = 0; i < built.size(); ++i)
+            build(i);
+
+    for (qsizetype i = 0; i < terminalsList.size(); ++i)
     {
-        Terminal *term            = addTerminalInternal(terminalData);
+        const QVariantMap &terminalData = terminalsList.at(i);
+        Terminal *term = addTerminalInternal(terminalData, built[i].release());
         QString   canonical       = term->getTerminalName();
         addedTerminals[canonical] = term;
     }
@@ -633,8 +730,8 @@ TerminalGraph::addTerminals(const QList<QVariantMap> &terminalsList)
 void TerminalGraph::addAliasToTerminal(const QString &name,
                                        const QString &alias)
 {
-    QMutexLocker locker(&m_mutex);
-    QString      canonical = getCanonicalName(name);
+    ProfiledMutexLocker locker(&m_mutex);
+    QString             canonical = getCanonicalName(name);
     if (!m_terminals.contains(canonical))
     {
         throw std::invalid_argument("Terminal not found: "
@@ -648,8 +745,8 @@ void TerminalGraph::addAliasToTerminal(const QString &name,
 
 QStringList TerminalGraph::getAliasesOfTerminal(const QString &name) const
 {
-    QMutexLocker locker(&m_mutex);
-    QString      canonical = getCanonicalName(name);
+    ProfiledMutexLocker locker(&m_mutex);
+    QString             canonical = getCanonicalName(name);
     return m_canonicalToAliases.value(canonical).values();
 }
 
@@ -666,8 +763,8 @@ TerminalGraph::addRouteInternal(const QString &id, const QString &start,
                 .toStdString());
     }
 
-    QString startCanonical = m_terminalAliases.value(start, start);
-    QString endCanonical   = m_terminalAliases.value(end, end);
+    QString startCanonical = getCanonicalName(start);
+    QString endCanonical   = getCanonicalName(end);
 
     if (!m_terminals.contains(startCanonical)
         || !m_terminals.contains(endCanonical))
@@ -753,12 +850,12 @@ TerminalGraph::addRouteInternal(const QString &id, const QString &start,
     params["terminal_delay"] = delay;           // seconds; sum of both endpoints' handlingTime
     params["terminal_cost"]  = terminalCost;    // USD per container
 
-    // Compute total cost
-    double cost = computeCost(params, m_costFunctionParametersWeights, mode);
+    // Price the route now so bad attributes fail here rather than on the
+    // next graph rebuild
+    computeCost(params, m_costFunctionParametersWeights, mode);
 
-    // Add edges to the graph (both directions)
-    m_graph.addEdge(startCanonical, endCanonical, cost, mode);
-    m_graph.addEdge(endCanonical, startCanonical, cost, mode);
+    ++m_topologyGeneration;
+    networkChangedLocked();
 
     qCDebug(lcTerminalGraph) << "Added bidirectional route" << id << "between" << startCanonical
                              << "and" << endCanonical << "with mode" << static_cast<int>(mode);
@@ -771,22 +868,24 @@ QPair<QString, QString> TerminalGraph::addRoute(const QString     &id,
                                                 TransportationMode mode,
                                                 const QVariantMap &attrs)
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     return addRouteInternal(id, start, end, mode, attrs);
 }
 
 QList<QPair<QString, QString>>
 TerminalGraph::addRoutes(const QList<QVariantMap> &routesList)
 {
-    QMutexLocker                   locker(&m_mutex);
+    ProfiledMutexLocker            locker(&m_mutex);
     QList<QPair<QString, QString>> addedRoutes;
     struct ValidatedRoute
     {
         QString            id;
         QString            start;
         QString            end;
-        TransportationMode mode;
-        QVariantMap        attrs;
+        TransportationMode        mode;
+        QVariantMap               attrs;
+        bool                      hasTimetable;
+        QList<TimetableDeparture> timetable;
     };
     QList<ValidatedRoute> validatedRoutes;
 
@@ -850,8 +949,19 @@ TerminalGraph::addRoutes(const QList<QVariantMap> &routesList)
             attrs, m_defaultLinkAttributes,
             QStringLiteral("route '%1'").arg(id));
 
-        validatedRoutes.append(
-            ValidatedRoute{id, start, end, mode, validatedAttrs});
+        // Get timetable for the start -> end direction (optional)
+        const bool hasTimetable = routeData.contains("timetable");
+        QList<TimetableDeparture> timetable;
+        if (hasTimetable)
+        {
+            timetable = parseTimetable(routeData.value("timetable"),
+                                       validatedAttrs,
+                                       QStringLiteral("route '%1'").arg(id));
+        }
+
+        validatedRoutes.append(ValidatedRoute{id, start, end, mode,
+                                              validatedAttrs, hasTimetable,
+                                              timetable});
     }
 
     // Add all routes after complete validation so a bad batch leaves topology
@@ -863,15 +973,148 @@ TerminalGraph::addRoutes(const QList<QVariantMap> &routesList)
             addRouteInternal(routeData.id, routeData.start, routeData.end,
                              routeData.mode, routeData.attrs);
         addedRoutes.append(route);
+
+        if (routeData.hasTimetable)
+        {
+            const EdgeIdentifier key(route.first, route.second,
+                                     routeData.mode);
+            if (routeData.timetable.isEmpty())
+                m_timetables.remove(key);
+            else
+                m_timetables[key] = routeData.timetable;
+        }
     }
 
     return addedRoutes;
 }
 
+QList<TimetableDeparture>
+TerminalGraph::parseTimetable(const QVariant    &value,
+                              const QVariantMap &routeAttributes,
+                              const QString     &context)
+{
+    if (!value.canConvert<QVariantList>())
+    {
+        throw std::invalid_argument(
+            QString("Timetable must be a list in %1")
+                .arg(context)
+                .toStdString());
+    }
+
+    const double defaultTravelTime =
+        routeAttributes.value(QStringLiteral("travelTime"), 0.0).toDouble();
+
+    QList<TimetableDeparture> departures;
+    const QVariantList        entries = value.toList();
+    for (int i = 0; i < entries.size(); ++i)
+    {
+        const QString entryContext =
+            QStringLiteral("%1.timetable[%2]").arg(context).arg(i);
+        if (!entries[i].canConvert<QVariantMap>())
+        {
+            throw std::invalid_argument(
+                QString("Timetable entry must be an object in %1")
+                    .arg(entryContext)
+                    .toStdString());
+        }
+
+        const QVariantMap entry = entries[i].toMap();
+        if (!entry.contains(QStringLiteral("departure_time")))
+        {
+            throw std::invalid_argument(
+                QString("Missing departure_time in %1")
+                    .arg(entryContext)
+                    .toStdString());
+        }
+
+        const double departure = numericAttributeValue(
+            entry.value(QStringLiteral("departure_time")),
+            entryContext + QStringLiteral(".departure_time"));
+        validateNonNegative(departure,
+                            entryContext + QStringLiteral(".departure_time"));
+
+        double arrival = departure + defaultTravelTime;
+        if (entry.contains(QStringLiteral("arrival_time")))
+        {
+            arrival = numericAttributeValue(
+                entry.value(QStringLiteral("arrival_time")),
+                entryContext + QStringLiteral(".arrival_time"));
+            if (arrival < departure)
+            {
+                throw std::invalid_argument(
+                    QString("arrival_time precedes departure_time in %1")
+                        .arg(entryContext)
+                        .toStdString());
+            }
+        }
+        else if (entry.contains(QStringLiteral("travel_time")))
+        {
+            const double travelTime = numericAttributeValue(
+                entry.value(QStringLiteral("travel_time")),
+                entryContext + QStringLiteral(".travel_time"));
+            validateNonNegative(travelTime,
+                                entryContext + QStringLiteral(".travel_time"));
+            arrival = departure + travelTime;
+        }
+
+        departures.append(TimetableDeparture{
+            departure, arrival,
+            entry.value(QStringLiteral("trip_id")).toString()});
+    }
+
+    std::sort(departures.begin(), departures.end(),
+              [](const TimetableDeparture &a, const TimetableDeparture &b) {
+                  return a.departureTime < b.departureTime;
+              });
+    return departures;
+}
+
+int TerminalGraph::setRouteTimetable(const QString     &start,
+                                     const QString     &end,
+                                     TransportationMode mode,
+                                     const QVariantList &departures)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    const EdgeIdentifier key(getCanonicalName(start), getCanonicalName(end),
+                             mode);
+    if (!isConcreteMode(mode) || m_edgeData.value(key).isEmpty())
+    {
+        throw std::invalid_argument(
+            QString("Route not found: %1 -> %2 (%3)")
+                .arg(start, end, EnumUtils::transportationModeToString(mode))
+                .toStdString());
+    }
+
+    const QList<TimetableDeparture> timetable = parseTimetable(
+        departures, m_edgeData.value(key).first().attributes,
+        QStringLiteral("route '%1'").arg(m_edgeData.value(key).first().routeId));
+
+    if (timetable.isEmpty())
+        m_timetables.remove(key);
+    else
+        m_timetables[key] = timetable;
+    ++m_topologyGeneration;
+    networkChangedLocked();
+
+    qCDebug(lcTerminalGraph) << "Timetable for" << key.from << "->" << key.to
+                             << "mode" << static_cast<int>(mode) << "set with"
+                             << timetable.size() << "departures";
+    return timetable.size();
+}
+
+QList<TimetableDeparture>
+TerminalGraph::getRouteTimetable(const QString &start, const QString &end,
+                                 TransportationMode mode) const
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    return m_timetables.value(
+        EdgeIdentifier(getCanonicalName(start), getCanonicalName(end), mode));
+}
+
 Terminal *TerminalGraph::getTerminal(const QString &name) const
 {
-    QMutexLocker locker(&m_mutex);
-    QString      canonical = getCanonicalName(name);
+    ProfiledMutexLocker locker(&m_mutex);
+    QString             canonical = getCanonicalName(name);
     if (!m_terminals.contains(canonical))
     {
         throw std::invalid_argument("Terminal not found: "
@@ -883,8 +1126,8 @@ Terminal *TerminalGraph::getTerminal(const QString &name) const
 
 bool TerminalGraph::terminalExists(const QString &name) const
 {
-    QMutexLocker locker(&m_mutex);
-    QString      canonical = getCanonicalName(name);
+    ProfiledMutexLocker locker(&m_mutex);
+    QString             canonical = getCanonicalName(name);
     return m_terminals.contains(canonical);
 }
 
@@ -894,8 +1137,8 @@ bool TerminalGraph::removeTerminal(const QString &name)
     bool      success      = false;
 
     {
-        QMutexLocker locker(&m_mutex);
-        QString      canonical = getCanonicalName(name);
+        ProfiledMutexLocker locker(&m_mutex);
+        QString             canonical = getCanonicalName(name);
         if (!m_terminals.contains(canonical))
         {
             return false; // Terminal not found
@@ -925,16 +1168,36 @@ bool TerminalGraph::removeTerminal(const QString &name)
         for (const auto &edge : edgesToRemove)
         {
             m_edgeData.remove(edge);
+            m_timetables.remove(edge);
         }
 
-        m_graph.removeVertex(canonical);
-
         // Remove terminal from map (but don't delete yet)
         m_terminals.remove(canonical);
 
         // Remove node attributes
         m_nodeAttributes.remove(canonical);
         m_terminalData.remove(canonical);
+        ++m_topologyGeneration;
+        networkChangedLocked();
+
+        // Drop closures that refer to the terminal or its routes
+        for (auto it = m_closures.begin(); it != m_closures.end();)
+        {
+            const Closure &closure = it.value();
+            if (closure.terminal == canonical
+                || (closure.route.has_value()
+                    && (closure.route->from == canonical
+                        || closure.route->to == canonical)))
+            {
+                it = m_closures.erase(it);
+                ++m_closureGeneration;
+                ++m_searchClosureGeneration;
+            }
+            else
+            {
+                ++it;
+            }
+        }
 
         success = true;
     }
@@ -948,14 +1211,14 @@ bool TerminalGraph::removeTerminal(const QString &name)
 
 int TerminalGraph::getTerminalCount() const
 {
-    QMutexLocker locker(&m_mutex);
+    ProfiledMutexLocker locker(&m_mutex);
     return m_terminals.size();
 }
 
 QMap<QString, QStringList>
 TerminalGraph::getAllTerminalNames(bool includeAliases) const
 {
-    QMutexLocker               locker(&m_mutex);
+    ProfiledMutexLocker        locker(&m_mutex);
     QMap<QString, QStringList> result;
 
     if (includeAliases)
@@ -982,7 +1245,7 @@ void TerminalGraph::clear()
     QList<Terminal *> terminalsToDelete;
 
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
 
         // Copy terminals to delete later
         for (auto it = m_terminals.begin(); it != m_terminals.end(); ++it)
@@ -996,10 +1259,15 @@ void TerminalGraph::clear()
         m_canonicalToAliases.clear();
         m_nodeAttributes.clear();
         m_edgeData.clear();
+        m_timetables.clear();
         m_terminalData.clear();
-
-        // Clear the graph
-        m_graph = GraphType();
+        m_closures.clear();
+        m_hotQueries.clear();
+        m_topPathsCache.clear();
+        ++m_closureGeneration;
+        ++m_searchClosureGeneration;
+        ++m_topologyGeneration;
+        networkChangedLocked();
     }
 
     // Now delete all terminals without holding the lock
@@ -1017,40 +1285,37 @@ int TerminalGraph::resetRuntimeState(const QStringList &terminalIds)
     QStringList       resolvedTerminalIds;
 
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
 
         if (terminalIds.isEmpty())
         {
-            for (auto it = m_terminals.constBegin();
-                 it != m_terminals.constEnd(); ++it)
-            {
-                terminalsToReset.append(it.value());
-                resolvedTerminalIds.append(it.key());
-            }
+            // Terminals catch up with the new epoch when next locked
+            m_runtimeEpoch->fetch_add(1, std::memory_order_acq_rel);
+            qCInfo(lcTerminalGraph)
+                << "Runtime state reset for all" << m_terminals.size()
+                << "terminals, epoch" << m_runtimeEpoch->load();
+            return m_terminals.size();
         }
-        else
+
+        QSet<QString> seen;
+        for (const QString &terminalId : terminalIds)
         {
-            QSet<QString> seen;
-            for (const QString &terminalId : terminalIds)
+            const QString canonical = getCanonicalName(terminalId.trimmed());
+            if (canonical.isEmpty())
+                continue;
+            if (!m_terminals.contains(canonical))
             {
-                const QString canonical =
-                    getCanonicalName(terminalId.trimmed());
-                if (canonical.isEmpty())
-                    continue;
-                if (!m_terminals.contains(canonical))
-                {
-                    throw std::invalid_argument(
-                        QString("Terminal not found: %1")
-                            .arg(terminalId)
-                            .toStdString());
-                }
-                if (seen.contains(canonical))
-                    continue;
-
-                seen.insert(canonical);
-                terminalsToReset.append(m_terminals.value(canonical));
-                resolvedTerminalIds.append(canonical);
+                throw std::invalid_argument(
+                    QString("Terminal not found: %1")
+                        .arg(terminalId)
+                        .toStdString());
             }
+            if (seen.contains(canonical))
+                continue;
+
+            seen.insert(canonical);
+            terminalsToReset.append(m_terminals.value(canonical));
+            resolvedTerminalIds.append(canonical);
         }
     }
 
@@ -1065,6 +1330,82 @@ int TerminalGraph::resetRuntimeState(const QStringList &terminalIds)
     return terminalsToReset.size();
 }
 
+void TerminalGraph::setTaskPool(WorkStealingPool *pool)
+{
+    m_taskPool = pool;
+}
+
+WorkStealingPool *TerminalGraph::taskPool() const
+{
+    return m_taskPool ? m_taskPool : WorkStealingPool::globalInstance();
+}
+
+TerminalGraph::GraphAlgorithmsType::ParallelFor
+TerminalGraph::poolParallelFor() const
+{
+    WorkStealingPool *pool = taskPool();
+    return [pool](size_t count, const std::function<void(size_t)> &task) {
+        pool->parallelFor(count, task);
+    };
+}
+
+TerminalGraph *TerminalGraph::fork()
+{
+    auto *branch = new TerminalGraph();
+
+    // Same lock order as distanceOracle() and timetableIndex()
+    QMutexLocker oracleLocker(&m_distanceOracleMutex);
+    QMutexLocker indexLocker(&m_timetableIndexMutex);
+    ProfiledMutexLocker locker(&m_mutex);
+
+    branch->m_edgeData           = m_edgeData;
+    branch->m_timetables         = m_timetables;
+    branch->m_terminalAliases    = m_terminalAliases;
+    branch->m_canonicalToAliases = m_canonicalToAliases;
+    branch->m_nodeAttributes     = m_nodeAttributes;
+    branch->m_terminalData       = m_terminalData;
+    branch->m_costFunctionParametersWeights = m_costFunctionParametersWeights;
+    branch->m_defaultLinkAttributes         = m_defaultLinkAttributes;
+    branch->m_topologyGeneration = m_topologyGeneration;
+    branch->m_taskPool           = m_taskPool;
+
+    branch->m_closures                = m_closures;
+    branch->m_closureGeneration       = m_closureGeneration;
+    branch->m_searchClosureGeneration = m_searchClosureGeneration;
+    branch->m_nextClosureId           = m_nextClosureId;
+
+    // The all-mode graph and the derived indexes are immutable and valid
+    // for the copied generation
+    branch->m_graph                    = m_graph;
+    branch->m_travelTimes              = m_travelTimes;
+    branch->m_graphGeneration          = m_graphGeneration;
+    branch->m_distanceOracles          = m_distanceOracles;
+    branch->m_distanceOracleGeneration = m_distanceOracleGeneration;
+    branch->m_timetableIndexes         = m_timetableIndexes;
+    branch->m_timetableIndexGeneration = m_timetableIndexGeneration;
+
+    branch->m_topPathsCache           = m_topPathsCache;
+    branch->m_topPathsCacheTopology   = m_topPathsCacheTopology;
+    branch->m_topPathsCacheClosures   = m_topPathsCacheClosures;
+    branch->m_hotQueries              = m_hotQueries;
+    branch->m_hotRoutePrecomputeCount = m_hotRoutePrecomputeCount;
+    branch->m_hotRouteWarmedTopology  = m_hotRouteWarmedTopology;
+    branch->m_hotRouteWarmedClosures  = m_hotRouteWarmedClosures;
+
+    for (auto it = m_terminals.constBegin(); it != m_terminals.constEnd();
+         ++it)
+    {
+        Terminal *terminal = it.value()->fork();
+        terminal->setRuntimeEpochSource(branch->m_runtimeEpoch);
+        branch->m_terminals.insert(it.key(), terminal);
+    }
+
+    qCInfo(lcTerminalGraph) << "Forked graph with" << m_terminals.size()
+                            << "terminals at generation"
+                            << m_topologyGeneration;
+    return branch;
+}
+
 QVariantMap TerminalGraph::getTerminalStatus(const QString &name) const
 {
     if (!name.isEmpty())
@@ -1074,8 +1415,8 @@ QVariantMap TerminalGraph::getTerminalStatus(const QString &name) const
         QStringList aliases;
 
         {
-            QMutexLocker locker(&m_mutex);
-            QString      canonical = getCanonicalName(name);
+            ProfiledMutexLocker locker(&m_mutex);
+            QString             canonical = getCanonicalName(name);
             if (!m_terminals.contains(canonical))
             {
                 throw std::invalid_argument("Terminal not found");
@@ -1092,7 +1433,7 @@ QVariantMap TerminalGraph::getTerminalStatus(const QString &name) const
             aliases = m_canonicalToAliases[canonical].values();
         }
 
-        // Call terminal methods without holding the lock
+        // Terminal counts are wait-free reads; no terminal lock is taken
         QVariantMap status;
         status["container_count"]    = term->getContainerCount();
         status["available_capacity"] = term->getAvailableCapacity();
@@ -1110,7 +1451,7 @@ QVariantMap TerminalGraph::getTerminalStatus(const QString &name) const
         QMap<QString, QVariant>    regionsCopy;
 
         {
-            QMutexLocker locker(&m_mutex);
+            ProfiledMutexLocker locker(&m_mutex);
 
             // Create copies of the data we need
             for (auto it = m_terminals.begin(); it != m_terminals.end(); ++it)
@@ -1200,7 +1541,8 @@ void TerminalGraph::buildPathSegment(PathSegment &segment, int sequenceIndex,
                                      bool skipEndTerminal,
                                      const QString &from, const QString &to,
                                      TransportationMode mode,
-                                     const QVariantMap &attributes) const
+                                     const QVariantMap &attributes,
+                                     const TopologySnapshot *snapshot) const
 {
     segment.from           = from;
     segment.to             = to;
@@ -1215,8 +1557,16 @@ void TerminalGraph::buildPathSegment(PathSegment &segment, int sequenceIndex,
     double fromCost         = 0.0;
     double toCost           = 0.0;
 
+    if (snapshot != nullptr)
+    {
+        fromHandlingTime = snapshot->terminalData.value(from).handlingTime;
+        toHandlingTime   = snapshot->terminalData.value(to).handlingTime;
+        fromCost         = snapshot->terminalData.value(from).handlingCost;
+        toCost           = snapshot->terminalData.value(to).handlingCost;
+    }
+    else
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
         fromHandlingTime = m_terminalData[from].handlingTime;
         toHandlingTime   = m_terminalData[to].handlingTime;
         fromCost         = m_terminalData[from].handlingCost;
@@ -1233,8 +1583,13 @@ void TerminalGraph::buildPathSegment(PathSegment &segment, int sequenceIndex,
 
     // Get cost function weights safely
     QVariantMap costFunctionWeights;
+    if (snapshot != nullptr)
+    {
+        costFunctionWeights = snapshot->costWeights;
+    }
+    else
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
         costFunctionWeights = m_costFunctionParametersWeights;
     }
 
@@ -1315,83 +1670,122 @@ void TerminalGraph::buildPathSegment(PathSegment &segment, int sequenceIndex,
     segment.weight = segment.rankingCostContribution;
 }
 
-void TerminalGraph::updateGraph(TransportationMode requestedMode)
+TerminalGraph::TopologySnapshot TerminalGraph::snapshotTopology() const
 {
-    // Create a new graph
-    GraphType newGraph;
-
-    // Copy necessary data while holding the lock
-    QHash<QString, Terminal *>                      terminalsCopy;
-    QHash<EdgeIdentifier, QList<EdgeData>>          edgeDataCopy;
-    QHash<QString, TerminalDetails>                 terminalData;
-    QVariantMap costFunctionParamsWeightsCopy;
-
-    {
-        QMutexLocker locker(&m_mutex);
-
-        // Make copies of all needed data
-        terminalsCopy                 = m_terminals;
-        edgeDataCopy                  = m_edgeData;
-        terminalData                  = m_terminalData;
-        costFunctionParamsWeightsCopy = m_costFunctionParametersWeights;
-    }
+    TopologySnapshot snapshot;
+
+    ProfiledMutexLocker locker(&m_mutex);
+    snapshot.terminals    = m_terminals.keys();
+    snapshot.edgeData     = m_edgeData;
+    snapshot.terminalData = m_terminalData;
+    snapshot.costWeights  = m_costFunctionParametersWeights;
+    snapshot.generation   = m_topologyGeneration;
+    return snapshot;
+}
 
-    // Now build the graph without holding the lock
+TerminalGraph::GraphType
+TerminalGraph::buildGraphForMode(const TopologySnapshot &snapshot,
+                                 TransportationModeMask  modes,
+                                 bool includeTerminalCosts) const
+{
+    GraphType newGraph;
 
     // First step - add all vertices
-    for (auto it = terminalsCopy.begin(); it != terminalsCopy.end(); ++it)
+    for (const QString &terminal : snapshot.terminals)
     {
-        newGraph.addVertex(it.key());
+        newGraph.addVertex(terminal);
     }
 
     // Second step - add all edges
-    for (auto it = edgeDataCopy.begin(); it != edgeDataCopy.end(); ++it)
+    for (auto it = snapshot.edgeData.begin(); it != snapshot.edgeData.end();
+         ++it)
     {
-        QString startName = it.key().from;
-        QString endName   = it.key().to;
+        const QString &startName = it.key().from;
+        const QString &endName   = it.key().to;
 
         // Get all edges between these vertices
         const QList<EdgeData> &edges = it.value();
 
         for (const EdgeData &edgeData : edges)
         {
-            // Skip edges that don't match the requested mode
-            if (requestedMode != TransportationMode::Any
-                && edgeData.mode != requestedMode)
+            // Skip edges that don't match the requested modes
+            if (!modes.contains(edgeData.mode))
             {
                 continue;
             }
 
-            // Calculate terminal costs without holding locks
-            double delay = terminalData[startName].handlingTime
-                           + terminalData[endName].handlingTime;
-            double terminalCost = terminalData[startName].handlingCost
-                                  + terminalData[endName].handlingCost;
-
             // Prepare parameters for cost function
-            QVariantMap params       = edgeData.attributes;
-            params["terminal_delay"] = delay;
-            params["terminal_cost"]  = terminalCost;
+            QVariantMap params = edgeData.attributes;
+            if (includeTerminalCosts)
+            {
+                // Calculate terminal costs without holding locks
+                const TerminalDetails startDetails =
+                    snapshot.terminalData.value(startName);
+                const TerminalDetails endDetails =
+                    snapshot.terminalData.value(endName);
+                params["terminal_delay"] =
+                    startDetails.handlingTime + endDetails.handlingTime;
+                params["terminal_cost"] =
+                    startDetails.handlingCost + endDetails.handlingCost;
+            }
 
             // Compute total cost
-            double cost = computeCost(params, costFunctionParamsWeightsCopy,
-                                      edgeData.mode);
+            double cost =
+                computeCost(params, snapshot.costWeights, edgeData.mode);
 
             // Add edge to the graph
             newGraph.addEdge(startName, endName, cost, edgeData.mode);
         }
     }
 
-    // Update the graph pointer under lock
+    return newGraph;
+}
+
+std::shared_ptr<const TerminalGraph::GraphType> TerminalGraph::currentGraph(
+    std::shared_ptr<const QHash<EdgeIdentifier, double>> *travelTimes)
+{
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        if (m_graphGeneration == m_topologyGeneration)
+        {
+            if (travelTimes)
+            {
+                *travelTimes = m_travelTimes;
+            }
+            return m_graph;
+        }
+    }
+
+    // Build the graph from a snapshot without holding the lock. Every mode
+    // is kept; queries select mode layers instead of rebuilding per mode.
+    // Travel times come from the same snapshot so the two always agree.
+    const TopologySnapshot snapshot = snapshotTopology();
+    auto newGraph = std::make_shared<const GraphType>(
+        buildGraphForMode(snapshot, TransportationMode::Any));
+    auto newTravelTimes = std::make_shared<const QHash<EdgeIdentifier, double>>(
+        routeTravelTimes(snapshot));
+
+    // Publish them unless a newer generation got there first
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        if (m_graphGeneration <= snapshot.generation)
+        {
+            m_graph           = newGraph;
+            m_travelTimes     = newTravelTimes;
+            m_graphGeneration = snapshot.generation;
+        }
+    }
+    if (travelTimes)
     {
-        QMutexLocker locker(&m_mutex);
-        m_graph = newGraph;
+        *travelTimes = newTravelTimes;
     }
+    return newGraph;
 }
 
 Path TerminalGraph::convertEdgePathToTerminalPath(
     const EdgePathInfoType &pathInfo, int displayPathId,
-    TransportationMode requestedMode, bool skipDelays) const
+    TransportationModeMask requestedModes, bool skipDelays,
+    const TopologySnapshot *snapshot) const
 {
     Path path;
     path.pathId             = displayPathId;
@@ -1399,7 +1793,9 @@ Path TerminalGraph::convertEdgePathToTerminalPath(
     path.totalTerminalCosts = 0;
     path.totalPathCost      = 0;
     path.rankingCost        = 0;
-    path.requestedMode      = static_cast<int>(requestedMode);
+    path.requestedMode      = static_cast<int>(
+        requestedModes.singleMode().value_or(TransportationMode::Any));
+    path.requestedModes     = requestedModes;
     path.costBreakdown = QVariantMap{
         {QStringLiteral("weighted_edge"),
          QVariantMap{
@@ -1428,8 +1824,14 @@ Path TerminalGraph::convertEdgePathToTerminalPath(
     QHash<EdgeIdentifier, QList<EdgeData>> edgeDataCopy;
     QHash<QString, TerminalDetails>        terminalData;
 
+    if (snapshot != nullptr)
+    {
+        edgeDataCopy = snapshot->edgeData;
+        terminalData = snapshot->terminalData;
+    }
+    else
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
         edgeDataCopy  = m_edgeData;
         terminalData  = m_terminalData;
     }
@@ -1500,8 +1902,7 @@ Path TerminalGraph::convertEdgePathToTerminalPath(
 
         for (const EdgeData &data : edgesData)
         {
-            if (requestedMode == TransportationMode::Any
-                || data.mode == requestedMode)
+            if (requestedModes.contains(data.mode))
             {
                 edgeData = data;
                 found    = true;
@@ -1511,8 +1912,9 @@ Path TerminalGraph::convertEdgePathToTerminalPath(
 
         if (!found)
         {
-            qCWarning(lcTerminalGraph) << "No matching edge found for mode"
-                                       << static_cast<int>(requestedMode);
+            qCWarning(lcTerminalGraph) << "No matching edge found for modes"
+                                       << EnumUtils::transportationModeMaskToString(
+                                              requestedModes);
             continue;
         }
 
@@ -1527,7 +1929,7 @@ Path TerminalGraph::convertEdgePathToTerminalPath(
         buildPathSegment(segment, static_cast<int>(i), isStart, isEnd,
                          skipPreviousTerminalCost,
                          skipNextTerminalCost, fromName, toName, edgeData.mode,
-                         edgeData.attributes);
+                         edgeData.attributes, snapshot);
         path.segments.append(segment);
 
         // Add to path-level weighted costs
@@ -1670,15 +2072,15 @@ Path TerminalGraph::convertEdgePathToTerminalPath(
     return path;
 }
 
-QList<PathSegment> TerminalGraph::findShortestPath(const QString     &start,
-                                                   const QString     &end,
-                                                   TransportationMode mode)
+QList<PathSegment> TerminalGraph::findShortestPath(const QString         &start,
+                                                   const QString         &end,
+                                                   TransportationModeMask modes)
 {
     QString startCanonical;
     QString endCanonical;
 
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
         startCanonical = getCanonicalName(start);
         endCanonical   = getCanonicalName(end);
 
@@ -1689,12 +2091,14 @@ QList<PathSegment> TerminalGraph::findShortestPath(const QString     &start,
         }
     }
 
-    // Update graph with the current network and mode
-    updateGraph(mode);
+    // Search this generation's graph; later changes publish a new one
+    const std::shared_ptr<const GraphType> graph = currentGraph();
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
 
     // Use the GraphAlgorithms to find shortest path
     auto shortestPathOpt = GraphAlgorithmsType::dijkstraShortestPath(
-        m_graph, startCanonical, endCanonical, mode);
+        *graph, startCanonical, endCanonical, modes,
+        closures.empty() ? nullptr : &closures);
 
     // Check if path exists
     if (!shortestPathOpt.has_value())
@@ -1704,15 +2108,15 @@ QList<PathSegment> TerminalGraph::findShortestPath(const QString     &start,
 
     // Convert to TerminalSim Path
     Path terminalPath =
-        convertEdgePathToTerminalPath(shortestPathOpt.value(), 1, mode, false);
+        convertEdgePathToTerminalPath(shortestPathOpt.value(), 1, modes, false);
 
     return terminalPath.segments;
 }
 
 QList<Path> TerminalGraph::findTopNShortestPaths(const QString &start,
                                                  const QString &end, int n,
-                                                 TransportationMode mode,
-                                                 bool               skipDelays)
+                                                 TransportationModeMask modes,
+                                                 bool skipDelays)
 {
     // Return early for invalid input
     if (n <= 0)
@@ -1725,7 +2129,7 @@ QList<Path> TerminalGraph::findTopNShortestPaths(const QString &start,
     QString endCanonical;
 
     {
-        QMutexLocker locker(&m_mutex);
+        ProfiledMutexLocker locker(&m_mutex);
         startCanonical = getCanonicalName(start);
         endCanonical   = getCanonicalName(end);
 
@@ -1736,59 +2140,2075 @@ QList<Path> TerminalGraph::findTopNShortestPaths(const QString &start,
                                      << " end=" << endCanonical;
             return QList<Path>();
         }
-    }
 
-    // Update graph with the current network and mode
-    updateGraph(mode);
+        // Count the query so it can be warmed after the next change. When
+        // the table is full, forget one-off queries to make room.
+        const QString hotKey = QStringLiteral("%1\n%2\n%3\n%4\n%5")
+                                   .arg(startCanonical, endCanonical)
+                                   .arg(modes.bits())
+                                   .arg(n)
+                                   .arg(skipDelays ? 1 : 0);
+        constexpr int maxHotQueries = 4096;
+        if (!m_hotQueries.contains(hotKey)
+            && m_hotQueries.size() >= maxHotQueries)
+        {
+            for (auto it = m_hotQueries.begin(); it != m_hotQueries.end();)
+            {
+                it = it->hits <= 1 ? m_hotQueries.erase(it) : std::next(it);
+            }
+        }
+        if (m_hotQueries.contains(hotKey)
+            || m_hotQueries.size() < maxHotQueries)
+        {
+            HotQuery &hot = m_hotQueries[hotKey];
+            if (hot.hits == 0)
+            {
+                hot = HotQuery{startCanonical, endCanonical, modes, n,
+                               skipDelays, 0};
+            }
+            ++hot.hits;
+        }
+    }
 
-    // Use the GraphAlgorithms to find k shortest paths
-    auto kPaths = GraphAlgorithmsType::kShortestPathsModified(
-        m_graph, startCanonical, endCanonical, n, mode);
+    return sharedTopNShortestPaths(startCanonical, endCanonical, n, modes,
+                                   skipDelays, false);
+}
 
-    // Convert paths to TerminalSim Paths
-    QVector<Path> result;
-    QSet<QString> uniquePathSignatures;
+QList<Path> TerminalGraph::sharedTopNShortestPaths(
+    const QString &start, const QString &end, int n,
+    TransportationModeMask modes, bool skipDelays, bool precompute)
+{
+    QString                         queryKey;
+    QString                         flightKey;
+    quint64                         topologyGeneration = 0;
+    quint64                         closureGeneration  = 0;
+    std::promise<QList<Path>>       promise;
+    std::shared_future<QList<Path>> inFlight;
 
-    for (size_t i = 0; i < kPaths.size(); ++i)
     {
-        Path path =
-            convertEdgePathToTerminalPath(kPaths[i], i + 1, mode, skipDelays);
+        ProfiledMutexLocker locker(&m_mutex);
+        topologyGeneration = m_topologyGeneration;
+        closureGeneration  = m_searchClosureGeneration;
+
+        // Cached results outlive closures that miss their paths, so the
+        // cache key leaves the closure generation out. Identical queries
+        // against the same closures share one search.
+        queryKey = QStringLiteral("%1\n%2\n%3\n%4\n%5\n%6")
+                       .arg(start, end)
+                       .arg(modes.bits())
+                       .arg(n)
+                       .arg(skipDelays ? 1 : 0)
+                       .arg(topologyGeneration);
+        flightKey = queryKey + QStringLiteral("\n%1").arg(closureGeneration);
+
+        if (m_topPathsCacheTopology != topologyGeneration
+            || m_topPathsCacheClosures != closureGeneration)
+        {
+            m_topPathsCache.clear();
+            m_topPathsCacheTopology = topologyGeneration;
+            m_topPathsCacheClosures = closureGeneration;
+        }
 
-        // Create a signature for this path
-        QString pathSignature;
-        for (const PathSegment &segment : path.segments)
+        auto cached = m_topPathsCache.constFind(queryKey);
+        if (cached != m_topPathsCache.constEnd())
         {
-            pathSignature += segment.from + "->" + segment.to + ":"
-                             + QString::number(static_cast<int>(segment.mode))
-                             + "|";
+            if (!precompute)
+            {
+                ++m_topPathsCacheHits;
+            }
+            return cached.value();
+        }
+        if (!precompute)
+        {
+            ++m_topPathsCacheMisses;
         }
 
-        // Only add if this path signature is unique
-        if (!uniquePathSignatures.contains(pathSignature))
+        // A client does not wait on a warmer-led search, which runs at the
+        // lowest priority; it leads its own and later callers join that.
+        // The warmer may still join a client's search.
+        auto it = m_inFlightTopPaths.constFind(flightKey);
+        if (it != m_inFlightTopPaths.constEnd()
+            && (precompute || !it->precompute))
         {
-            uniquePathSignatures.insert(pathSignature);
-            result.append(path);
+            inFlight = it->result;
+        }
+        else
+        {
+            m_inFlightTopPaths.insert(
+                flightKey, {promise.get_future().share(), precompute});
         }
     }
 
-    // Resort and assign authoritative rank/display metadata after dedupe.
-    std::sort(result.begin(), result.end(), [](const Path &a, const Path &b) {
-        return a.rankingCost < b.rankingCost;
-    });
+    if (inFlight.valid())
+    {
+        qCDebug(lcTerminalGraph) << "Joining in-flight search from" << start
+                                 << "to" << end;
+        return inFlight.get();
+    }
 
-    for (int i = 0; i < result.size(); i++)
+    // This caller leads; publish the outcome before releasing the key so
+    // that no waiter is left behind
+    try
     {
-        result[i].rank = i;
-        result[i].pathId = i + 1;
-        result[i].requestedMode = static_cast<int>(mode);
-        result[i].requestedTopN = n;
-        result[i].skipSameModeTerminalDelaysAndCosts = skipDelays;
-        result[i].pathUid = buildPathUid(result[i]);
+        QList<Path> paths =
+            computeTopNShortestPaths(start, end, n, modes, skipDelays);
+        promise.set_value(paths);
+        ProfiledMutexLocker locker(&m_mutex);
+        releaseInFlightLocked(flightKey, precompute);
+
+        // Only keep results that still describe the current network
+        if (m_topologyGeneration == topologyGeneration
+            && m_searchClosureGeneration == closureGeneration
+            && m_topPathsCacheTopology == topologyGeneration
+            && m_topPathsCacheClosures == closureGeneration)
+        {
+            constexpr int maxCachedQueries = 4096;
+            if (m_topPathsCache.size() >= maxCachedQueries)
+            {
+                m_topPathsCache.clear();
+            }
+            m_topPathsCache.insert(queryKey, paths);
+            if (precompute)
+            {
+                ++m_topPathsPrecomputed;
+            }
+        }
+        return paths;
     }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+        ProfiledMutexLocker locker(&m_mutex);
+        releaseInFlightLocked(flightKey, precompute);
+        throw;
+    }
+}
 
-    qCDebug(lcTerminalGraph) << "Found" << result.size() << "paths from" << startCanonical
-                             << "to" << endCanonical;
-    return result.toList();
+void TerminalGraph::releaseInFlightLocked(const QString &flightKey,
+                                          bool           precompute)
+{
+    // Caller holds m_mutex. A client may have taken the key over from the
+    // warmer; that entry is the client's to remove.
+    auto it = m_inFlightTopPaths.find(flightKey);
+    if (it != m_inFlightTopPaths.end() && it->precompute == precompute)
+    {
+        m_inFlightTopPaths.erase(it);
+    }
+}
+
+void TerminalGraph::setHotRoutePrecomputeCount(int count)
+{
+    if (count < 0)
+    {
+        throw std::invalid_argument(
+            "Hot route precompute count must not be negative");
+    }
+
+    ProfiledMutexLocker locker(&m_mutex);
+    m_hotRoutePrecomputeCount = count;
+}
+
+bool TerminalGraph::waitForHotRoutePrecompute(int msecs)
+{
+    return m_hotRoutePool.waitForDone(msecs);
+}
+
+QVariantMap TerminalGraph::getPathCacheStatistics() const
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    const bool current =
+        m_topPathsCacheTopology == m_topologyGeneration
+        && m_topPathsCacheClosures == m_searchClosureGeneration;
+    return QVariantMap{
+        {QStringLiteral("hits"), m_topPathsCacheHits},
+        {QStringLiteral("misses"), m_topPathsCacheMisses},
+        {QStringLiteral("precomputed"), m_topPathsPrecomputed},
+        {QStringLiteral("cached_queries"),
+         current ? static_cast<int>(m_topPathsCache.size()) : 0},
+        {QStringLiteral("tracked_queries"),
+         static_cast<int>(m_hotQueries.size())},
+        {QStringLiteral("warming"), m_hotRouteWarmupRunning}};
+}
+
+void TerminalGraph::networkChangedLocked()
+{
+    // Caller holds m_mutex
+    if (m_hotRouteWarmupRunning || m_hotRoutePrecomputeCount <= 0
+        || m_hotQueries.isEmpty())
+    {
+        return;
+    }
+
+    m_hotRouteWarmupRunning = true;
+    m_hotRoutePool.start([this]() { warmHotRoutes(); });
+}
+
+void TerminalGraph::warmHotRoutes()
+{
+    // Client queries come first; warming only uses spare cycles
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+    while (true)
+    {
+        QList<HotQuery> batch;
+        quint64         topologyGeneration = 0;
+        quint64         closureGeneration  = 0;
+
+        {
+            ProfiledMutexLocker locker(&m_mutex);
+            if (m_hotRoutePrecomputeCount <= 0
+                || (m_hotRouteWarmedTopology == m_topologyGeneration
+                    && m_hotRouteWarmedClosures == m_searchClosureGeneration))
+            {
+                m_hotRouteWarmupRunning = false;
+                return;
+            }
+            topologyGeneration = m_topologyGeneration;
+            closureGeneration  = m_searchClosureGeneration;
+
+            // Queries asked at least twice are worth warming
+            for (const HotQuery &hot : std::as_const(m_hotQueries))
+            {
+                if (hot.hits >= 2)
+                {
+                    batch.append(hot);
+                }
+            }
+            std::sort(batch.begin(), batch.end(),
+                      [](const HotQuery &a, const HotQuery &b) {
+                          return a.hits > b.hits;
+                      });
+            if (batch.size() > m_hotRoutePrecomputeCount)
+            {
+                batch.resize(m_hotRoutePrecomputeCount);
+            }
+
+            for (auto it = m_hotQueries.begin(); it != m_hotQueries.end();)
+            {
+                it->hits /= 2;
+                it = it->hits == 0 ? m_hotQueries.erase(it) : std::next(it);
+            }
+        }
+
+        for (const HotQuery &hot : std::as_const(batch))
+        {
+            {
+                ProfiledMutexLocker locker(&m_mutex);
+                if (m_topologyGeneration != topologyGeneration
+                    || m_searchClosureGeneration != closureGeneration)
+                {
+                    break;
+                }
+                if (!m_terminals.contains(hot.start)
+                    || !m_terminals.contains(hot.end))
+                {
+                    continue;
+                }
+            }
+
+            try
+            {
+                sharedTopNShortestPaths(hot.start, hot.end, hot.n, hot.modes,
+                                        hot.skipDelays, true);
+            }
+            catch (const std::exception &e)
+            {
+                qCWarning(lcTerminalGraph)
+                    << "Warming route from" << hot.start << "to" << hot.end
+                    << "failed:" << e.what();
+            }
+        }
+
+        qCDebug(lcTerminalGraph) << "Warmed" << batch.size()
+                                 << "hot route queries";
+
+        ProfiledMutexLocker locker(&m_mutex);
+        m_hotRouteWarmedTopology = topologyGeneration;
+        m_hotRouteWarmedClosures = closureGeneration;
+    }
+}
+
+QList<Path> TerminalGraph::computeTopNShortestPaths(
+    const QString &start, const QString &end, int n,
+    TransportationModeMask modes, bool skipDelays)
+{
+    // Search this generation's graph; later changes publish a new one, so
+    // the warmer never reads a graph that is being replaced
+    const std::shared_ptr<const GraphType> graph = currentGraph();
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+
+    // Use the GraphAlgorithms to find k shortest paths
+    auto kPaths = GraphAlgorithmsType::kShortestPathsModified(
+        *graph, start, end, n, modes,
+        closures.empty() ? nullptr : &closures, poolParallelFor());
+
+    return rankTopPaths(kPaths, start, end, n, modes, skipDelays);
+}
+
+QList<Path> TerminalGraph::findTopNTransferAwarePaths(
+    const QString &start, const QString &end, int n,
+    TransportationModeMask modes, bool skipDelays)
+{
+    // Return early for invalid input
+    if (n <= 0)
+    {
+        qCDebug(lcTerminalGraph) << "Invalid request: n must be positive";
+        return QList<Path>();
+    }
+
+    QString startCanonical;
+    QString endCanonical;
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        startCanonical = getCanonicalName(start);
+        endCanonical   = getCanonicalName(end);
+
+        if (!m_terminals.contains(startCanonical)
+            || !m_terminals.contains(endCanonical))
+        {
+            qCDebug(lcTerminalGraph) << "Terminal not found: start=" << startCanonical
+                                     << " end=" << endCanonical;
+            return QList<Path>();
+        }
+    }
+
+    // Edge weights carry only route attributes; terminal handling is priced
+    // by the search on the (terminal, arrival mode) state
+    const TopologySnapshot snapshot = snapshotTopology();
+    const GraphType        graph    = buildGraphForMode(snapshot, modes, false);
+
+    const QList<TransportationMode> concreteModes = {
+        TransportationMode::Ship, TransportationMode::Truck,
+        TransportationMode::Train};
+    QHash<QString, QHash<int, double>> terminalCosts;
+    for (auto it = snapshot.terminalData.constBegin();
+         it != snapshot.terminalData.constEnd(); ++it)
+    {
+        for (TransportationMode concreteMode : concreteModes)
+        {
+            terminalCosts[it.key()][static_cast<int>(concreteMode)] =
+                computeCost({{"terminal_delay", it.value().handlingTime}},
+                            snapshot.costWeights, concreteMode)
+                + computeCost({{"terminal_cost", it.value().handlingCost}},
+                              snapshot.costWeights, concreteMode);
+        }
+    }
+
+    // Same pricing as convertEdgePathToTerminalPath(): the origin is free,
+    // the destination is paid in full, and a mode change splits the cost
+    // of the transfer terminal between the two modes
+    auto transferCost = [&terminalCosts](const QString     &terminal,
+                                         TransportationMode arrivalMode,
+                                         TransportationMode departureMode) {
+        if (arrivalMode == TransportationMode::Any
+            || arrivalMode == departureMode)
+        {
+            return 0.0;
+        }
+
+        const QHash<int, double> costs = terminalCosts.value(terminal);
+        const double arrivalCost = costs.value(static_cast<int>(arrivalMode));
+        if (departureMode == TransportationMode::Any)
+        {
+            return arrivalCost;
+        }
+        return (arrivalCost + costs.value(static_cast<int>(departureMode)))
+               / 2.0;
+    };
+
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+    auto kPaths = GraphAlgorithmsType::kShortestPathsWithTransfers(
+        graph, startCanonical, endCanonical, n, transferCost, modes,
+        closures.empty() ? nullptr : &closures, poolParallelFor());
+
+    return rankTopPaths(kPaths, startCanonical, endCanonical, n, modes,
+                        skipDelays);
+}
+
+QList<QList<Path>>
+TerminalGraph::findTopNShortestPathsBatch(const QList<RouteQuery> &queries,
+                                          int n, bool skipDelays)
+{
+    QList<QList<Path>> results(queries.size());
+    if (n <= 0)
+    {
+        qCDebug(lcTerminalGraph) << "Invalid request: n must be positive";
+        return results;
+    }
+
+    // Collapse queries onto distinct (start, end, modes) groups
+    struct QueryGroup
+    {
+        QString                start;
+        QString                end;
+        TransportationModeMask modes;
+    };
+    QList<QueryGroup>   groups;
+    QList<int>          groupOfQuery(queries.size(), -1);
+    QHash<QString, int> groupIndex;
+    quint64             topologyGeneration = 0;
+    quint64             closureGeneration  = 0;
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        topologyGeneration = m_topologyGeneration;
+        closureGeneration  = m_searchClosureGeneration;
+        for (int i = 0; i < queries.size(); ++i)
+        {
+            const QString start = getCanonicalName(queries[i].start);
+            const QString end   = getCanonicalName(queries[i].end);
+            if (!m_terminals.contains(start) || !m_terminals.contains(end))
+            {
+                continue;
+            }
+
+            const QString key = start + QLatin1Char('\n') + end
+                                + QLatin1Char('\n')
+                                + QString::number(queries[i].modes.bits());
+            auto it = groupIndex.constFind(key);
+            if (it == groupIndex.constEnd())
+            {
+                it = groupIndex.insert(key, groups.size());
+                groups.append(QueryGroup{start, end, queries[i].modes});
+            }
+            groupOfQuery[i] = it.value();
+        }
+    }
+
+    // Groups already answered by the top-N cache skip the search; the key
+    // matches the one single queries use, so both fill the same cache
+    auto queryKeyFor = [&](const QueryGroup &group) {
+        return QStringLiteral("%1\n%2\n%3\n%4\n%5\n%6")
+            .arg(group.start, group.end)
+            .arg(group.modes.bits())
+            .arg(n)
+            .arg(skipDelays ? 1 : 0)
+            .arg(topologyGeneration);
+    };
+
+    QList<QList<Path>> groupPaths(groups.size());
+    QList<QueryGroup>  missedGroups;
+    QList<int>         missedIndex;
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        if (m_topPathsCacheTopology != topologyGeneration
+            || m_topPathsCacheClosures != closureGeneration)
+        {
+            m_topPathsCache.clear();
+            m_topPathsCacheTopology = topologyGeneration;
+            m_topPathsCacheClosures = closureGeneration;
+        }
+
+        for (int g = 0; g < groups.size(); ++g)
+        {
+            auto cached = m_topPathsCache.constFind(queryKeyFor(groups[g]));
+            if (cached != m_topPathsCache.constEnd())
+            {
+                ++m_topPathsCacheHits;
+                groupPaths[g] = cached.value();
+            }
+            else
+            {
+                ++m_topPathsCacheMisses;
+                missedGroups.append(groups[g]);
+                missedIndex.append(g);
+            }
+        }
+    }
+
+    // Every remaining group searches this generation's graph
+    const std::shared_ptr<const GraphType> graph = currentGraph();
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+    const GraphLib::ClosureOverlay<QString> *closuresPtr =
+        closures.empty() ? nullptr : &closures;
+
+    const QList<QList<Path>> searchedPaths =
+        taskPool()->mapped<QList<Path>>(
+            missedGroups, [&](const QueryGroup &group) {
+                std::vector<EdgePathInfoType> kPaths;
+                if (n == 1)
+                {
+                    auto shortest = GraphAlgorithmsType::dijkstraShortestPath(
+                        *graph, group.start, group.end, group.modes,
+                        closuresPtr);
+                    if (shortest.has_value())
+                    {
+                        kPaths.push_back(std::move(*shortest));
+                    }
+                }
+                else
+                {
+                    kPaths = GraphAlgorithmsType::kShortestPathsModified(
+                        *graph, group.start, group.end, n, group.modes,
+                        closuresPtr, poolParallelFor());
+                }
+                return rankTopPaths(kPaths, group.start, group.end, n,
+                                    group.modes, skipDelays);
+            });
+
+    {
+        // Only keep results that still describe the current network
+        ProfiledMutexLocker locker(&m_mutex);
+        const bool current =
+            m_topologyGeneration == topologyGeneration
+            && m_searchClosureGeneration == closureGeneration
+            && m_topPathsCacheTopology == topologyGeneration
+            && m_topPathsCacheClosures == closureGeneration;
+        constexpr int maxCachedQueries = 4096;
+        for (int m = 0; m < missedGroups.size(); ++m)
+        {
+            groupPaths[missedIndex[m]] = searchedPaths[m];
+            if (current)
+            {
+                if (m_topPathsCache.size() >= maxCachedQueries)
+                {
+                    m_topPathsCache.clear();
+                }
+                m_topPathsCache.insert(queryKeyFor(missedGroups[m]),
+                                       searchedPaths[m]);
+            }
+        }
+    }
+
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        if (groupOfQuery[i] >= 0)
+        {
+            results[i] = groupPaths[groupOfQuery[i]];
+        }
+    }
+
+    qCDebug(lcTerminalGraph) << "Batch path search answered" << queries.size()
+                             << "queries with" << missedGroups.size()
+                             << "searches";
+    return results;
+}
+
+QList<QList<QList<Path>>>
+TerminalGraph::sweepTopNShortestPaths(const QList<QVariantMap> &weightSets,
+                                      const QList<RouteQuery>  &queries,
+                                      int n, bool skipDelays)
+{
+    QList<QList<QList<Path>>> results(
+        weightSets.size(), QList<QList<Path>>(queries.size()));
+    if (n <= 0)
+    {
+        qCDebug(lcTerminalGraph) << "Invalid request: n must be positive";
+        return results;
+    }
+
+    // Every weight set prices the same topology; only the weights differ
+    const TopologySnapshot  base = snapshotTopology();
+    QList<TopologySnapshot> snapshots;
+    for (const QVariantMap &weightSet : weightSets)
+    {
+        QVariantMap weights = base.costWeights;
+        for (auto it = weightSet.constBegin(); it != weightSet.constEnd(); ++it)
+        {
+            if (!it.value().canConvert<QVariantMap>())
+            {
+                throw std::invalid_argument(
+                    QString("Cost-function overrides for mode %1 must be a map")
+                        .arg(it.key())
+                        .toStdString());
+            }
+            QVariantMap modeWeights = weights.value(it.key()).toMap();
+            const QVariantMap overrides = it.value().toMap();
+            for (auto override = overrides.constBegin();
+                 override != overrides.constEnd(); ++override)
+            {
+                modeWeights[override.key()] = override.value();
+            }
+            weights[it.key()] = modeWeights;
+        }
+        validateCostFunctionParameters(weights);
+
+        TopologySnapshot snapshot = base;
+        snapshot.costWeights      = weights;
+        snapshots.append(snapshot);
+    }
+
+    struct SweepSearch
+    {
+        int                    weightSet;
+        int                    query;
+        QString                start;
+        QString                end;
+        TransportationModeMask modes;
+    };
+    QList<SweepSearch> searches;
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        for (int q = 0; q < queries.size(); ++q)
+        {
+            const QString start = getCanonicalName(queries[q].start);
+            const QString end   = getCanonicalName(queries[q].end);
+            if (!base.terminalData.contains(start)
+                || !base.terminalData.contains(end))
+            {
+                continue;
+            }
+            for (int w = 0; w < snapshots.size(); ++w)
+            {
+                searches.append(
+                    SweepSearch{w, q, start, end, queries[q].modes});
+            }
+        }
+    }
+
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+    const GraphLib::ClosureOverlay<QString> *closuresPtr =
+        closures.empty() ? nullptr : &closures;
+
+    const QList<GraphType> graphs =
+        taskPool()->mapped<GraphType>(
+            snapshots, [this](const TopologySnapshot &snapshot) {
+                return buildGraphForMode(snapshot, TransportationMode::Any);
+            });
+
+    const QList<QList<Path>> searchPaths =
+        taskPool()->mapped<QList<Path>>(
+            searches, [&](const SweepSearch &search) {
+                const GraphType &graph = graphs.at(search.weightSet);
+                std::vector<EdgePathInfoType> kPaths;
+                if (n == 1)
+                {
+                    auto shortest = GraphAlgorithmsType::dijkstraShortestPath(
+                        graph, search.start, search.end, search.modes,
+                        closuresPtr);
+                    if (shortest.has_value())
+                    {
+                        kPaths.push_back(std::move(*shortest));
+                    }
+                }
+                else
+                {
+                    kPaths = GraphAlgorithmsType::kShortestPathsModified(
+                        graph, search.start, search.end, n, search.modes,
+                        closuresPtr, poolParallelFor());
+                }
+                return rankTopPaths(kPaths, search.start, search.end, n,
+                                    search.modes, skipDelays,
+                                    &snapshots.at(search.weightSet));
+            });
+
+    for (int i = 0; i < searches.size(); ++i)
+    {
+        results[searches[i].weightSet][searches[i].query] = searchPaths[i];
+    }
+
+    qCDebug(lcTerminalGraph) << "Cost sweep answered" << queries.size()
+                             << "queries under" << weightSets.size()
+                             << "weight sets";
+    return results;
+}
+
+std::optional<Path> TerminalGraph::findConstrainedShortestPath(
+    const QString &start, const QString &end, TransportationModeMask modes,
+    std::optional<int> maxHops, std::optional<int> maxTransfers,
+    std::optional<double> maxTravelTime)
+{
+    if ((maxHops.has_value() && *maxHops < 0)
+        || (maxTransfers.has_value() && *maxTransfers < 0)
+        || (maxTravelTime.has_value() && *maxTravelTime < 0.0))
+    {
+        throw std::invalid_argument("Path limits must be non-negative");
+    }
+
+    QString startCanonical;
+    QString endCanonical;
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        startCanonical = getCanonicalName(start);
+        endCanonical   = getCanonicalName(end);
+
+        if (!m_terminals.contains(startCanonical)
+            || !m_terminals.contains(endCanonical))
+        {
+            throw std::invalid_argument("Terminal not found");
+        }
+    }
+
+    // Graph and travel times are published together per generation
+    std::shared_ptr<const QHash<EdgeIdentifier, double>> travelTimes;
+    const std::shared_ptr<const GraphType> graph = currentGraph(&travelTimes);
+
+    GraphAlgorithmsType::PathConstraints constraints;
+    if (maxHops.has_value())
+    {
+        constraints.maxHops = static_cast<size_t>(*maxHops);
+    }
+    if (maxTransfers.has_value())
+    {
+        constraints.maxTransfers = static_cast<size_t>(*maxTransfers);
+    }
+    constraints.maxResource = maxTravelTime;
+
+    auto travelTime = [&travelTimes](const EdgeType &edge) {
+        return travelTimes->value(
+            EdgeIdentifier(edge.source(), edge.target(), edge.mode()), 0.0);
+    };
+
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+    auto pathOpt = GraphAlgorithmsType::constrainedShortestPath(
+        *graph, startCanonical, endCanonical, constraints, travelTime, modes,
+        closures.empty() ? nullptr : &closures);
+    if (!pathOpt.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return convertEdgePathToTerminalPath(*pathOpt, 1, modes, false);
+}
+
+QList<QPair<QString, double>>
+TerminalGraph::findReachableTerminals(const QString &start, double budget,
+                                      ReachabilityMetric     metric,
+                                      TransportationModeMask modes)
+{
+    if (!std::isfinite(budget) || budget < 0.0)
+    {
+        throw std::invalid_argument("Budget must be a non-negative number");
+    }
+
+    QString startCanonical;
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        startCanonical = getCanonicalName(start);
+
+        if (!m_terminals.contains(startCanonical))
+        {
+            throw std::invalid_argument("Terminal not found");
+        }
+    }
+
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+    const GraphLib::ClosureOverlay<QString> *closuresPtr =
+        closures.empty() ? nullptr : &closures;
+
+    std::vector<std::pair<QString, double>> reachable;
+    if (metric == ReachabilityMetric::Cost)
+    {
+        reachable = GraphAlgorithmsType::reachableWithin(
+            *currentGraph(), startCanonical, budget, {}, modes, closuresPtr);
+    }
+    else
+    {
+        // Graph and travel times are published together per generation
+        std::shared_ptr<const QHash<EdgeIdentifier, double>> travelTimes;
+        const std::shared_ptr<const GraphType> graph =
+            currentGraph(&travelTimes);
+
+        auto travelTime = [&travelTimes](const EdgeType &edge) {
+            return travelTimes->value(
+                EdgeIdentifier(edge.source(), edge.target(), edge.mode()),
+                0.0);
+        };
+        reachable = GraphAlgorithmsType::reachableWithin(
+            *graph, startCanonical, budget, travelTime, modes, closuresPtr);
+    }
+
+    QList<QPair<QString, double>> result;
+    result.reserve(static_cast<qsizetype>(reachable.size()));
+    for (const auto &[terminal, distance] : reachable)
+    {
+        result.append(qMakePair(terminal, distance));
+    }
+    return result;
+}
+
+QHash<EdgeIdentifier, double>
+TerminalGraph::routeTravelTimes(const TopologySnapshot &snapshot)
+{
+    // The graph keeps the first route per (from, to, mode), as does this
+    QHash<EdgeIdentifier, double> travelTimes;
+    for (auto it = snapshot.edgeData.constBegin();
+         it != snapshot.edgeData.constEnd(); ++it)
+    {
+        for (const EdgeData &edgeData : it.value())
+        {
+            const EdgeIdentifier key(it.key().from, it.key().to, edgeData.mode);
+            if (!travelTimes.contains(key))
+            {
+                travelTimes.insert(
+                    key, edgeData.attributes
+                             .value(QStringLiteral("travelTime"), 0.0)
+                             .toDouble());
+            }
+        }
+    }
+    return travelTimes;
+}
+
+QList<Path>
+TerminalGraph::rankTopPaths(const std::vector<EdgePathInfoType> &kPaths,
+                            const QString &start, const QString &end, int n,
+                            TransportationModeMask  modes,
+                            bool                    skipDelays,
+                            const TopologySnapshot *snapshot) const
+{
+    // Convert paths to TerminalSim Paths
+    QVector<Path> result;
+    QSet<QString> uniquePathSignatures;
+
+    for (size_t i = 0; i < kPaths.size(); ++i)
+    {
+        Path path = convertEdgePathToTerminalPath(kPaths[i], i + 1, modes,
+                                                  skipDelays, snapshot);
+
+        // Create a signature for this path
+        QString pathSignature;
+        for (const PathSegment &segment : path.segments)
+        {
+            pathSignature += segment.from + "->" + segment.to + ":"
+                             + QString::number(static_cast<int>(segment.mode))
+                             + "|";
+        }
+
+        // Only add if this path signature is unique
+        if (!uniquePathSignatures.contains(pathSignature))
+        {
+            uniquePathSignatures.insert(pathSignature);
+            result.append(path);
+        }
+    }
+
+    // Resort and assign authoritative rank/display metadata after dedupe.
+    std::sort(result.begin(), result.end(), [](const Path &a, const Path &b) {
+        return a.rankingCost < b.rankingCost;
+    });
+
+    for (int i = 0; i < result.size(); i++)
+    {
+        result[i].rank = i;
+        result[i].pathId = i + 1;
+        result[i].requestedMode = static_cast<int>(
+            modes.singleMode().value_or(TransportationMode::Any));
+        result[i].requestedModes = modes;
+        result[i].requestedTopN = n;
+        result[i].skipSameModeTerminalDelaysAndCosts = skipDelays;
+        result[i].pathUid = buildPathUid(result[i]);
+    }
+
+    qCDebug(lcTerminalGraph) << "Found" << result.size() << "paths from" << start
+                             << "to" << end;
+    return result.toList();
+}
+
+std::shared_ptr<const TerminalGraph::HubLabelsType>
+TerminalGraph::distanceOracle(TransportationModeMask modes)
+{
+    QMutexLocker buildLocker(&m_distanceOracleMutex);
+
+    QHash<int, std::shared_ptr<const HubLabelsType>> rebuilt;
+    quint64                                          cachedGeneration = 0;
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        cachedGeneration = m_topologyGeneration;
+        if (m_distanceOracleGeneration == m_topologyGeneration)
+        {
+            if (m_distanceOracles.contains(static_cast<int>(modes.bits())))
+            {
+                return m_distanceOracles.value(
+                    static_cast<int>(modes.bits()));
+            }
+            rebuilt = m_distanceOracles;
+        }
+    }
+
+    // One snapshot and one all-mode graph feed every oracle so they all
+    // describe the same generation; the builds are independent and run in
+    // parallel. A stale cache rebuilds Any and each single mode, mixed
+    // mode sets are added when first asked for.
+    const TopologySnapshot snapshot = snapshotTopology();
+    const GraphType graph = buildGraphForMode(snapshot, TransportationMode::Any);
+
+    // The topology may have moved on since the cache was copied; its
+    // oracles must not be stored under the newer generation
+    if (snapshot.generation != cachedGeneration)
+    {
+        rebuilt.clear();
+    }
+
+    QList<TransportationModeMask> oracleModes;
+    if (rebuilt.isEmpty())
+    {
+        oracleModes = {TransportationMode::Any, TransportationMode::Ship,
+                       TransportationMode::Truck, TransportationMode::Train};
+    }
+    if (!oracleModes.contains(modes))
+    {
+        oracleModes.append(modes);
+    }
+
+    const QList<std::shared_ptr<const HubLabelsType>> oracles =
+        taskPool()->mapped<std::shared_ptr<const HubLabelsType>>(
+            oracleModes, [&graph](TransportationModeMask oracleMode) {
+                return std::make_shared<const HubLabelsType>(
+                    HubLabelsType::build(graph, oracleMode));
+            });
+
+    for (int i = 0; i < oracleModes.size(); ++i)
+    {
+        rebuilt.insert(static_cast<int>(oracleModes[i].bits()), oracles[i]);
+    }
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        m_distanceOracles          = rebuilt;
+        m_distanceOracleGeneration = snapshot.generation;
+    }
+
+    qCDebug(lcTerminalGraph) << "Rebuilt distance oracles for generation"
+                             << snapshot.generation;
+    return rebuilt.value(static_cast<int>(modes.bits()));
+}
+
+std::optional<double> TerminalGraph::getDistance(const QString         &start,
+                                                 const QString         &end,
+                                                 TransportationModeMask modes)
+{
+    QString startCanonical;
+    QString endCanonical;
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        startCanonical = getCanonicalName(start);
+        endCanonical   = getCanonicalName(end);
+
+        if (!m_terminals.contains(startCanonical)
+            || !m_terminals.contains(endCanonical))
+        {
+            throw std::invalid_argument("Terminal not found");
+        }
+    }
+
+    // The oracle describes the open network
+    const std::shared_ptr<const HubLabelsType> oracle = distanceOracle(modes);
+    const std::optional<double> openDistance =
+        oracle->distance(startCanonical, endCanonical);
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+    if (closures.empty() || !openDistance.has_value())
+    {
+        return openDistance;
+    }
+
+    if (closures.isVertexClosed(startCanonical)
+        || closures.isVertexClosed(endCanonical))
+    {
+        return std::nullopt;
+    }
+    if (startCanonical == endCanonical)
+    {
+        return 0.0;
+    }
+
+    // A closure lengthens the distance only if it lies on a shortest path
+    // of the open network, which the oracle can tell from the distances
+    // around it. Ties count as on the path, so rounding errs towards the
+    // search below.
+    const std::shared_ptr<const GraphType> graph = currentGraph();
+    const double slack = 1e-9 * std::max(1.0, *openDistance);
+    auto onShortestPath = [&](const QString &from, double via,
+                              const QString &to) {
+        const std::optional<double> head =
+            oracle->distance(startCanonical, from);
+        const std::optional<double> tail = oracle->distance(to, endCanonical);
+        return head.has_value() && tail.has_value()
+               && *head + via + *tail <= *openDistance + slack;
+    };
+
+    bool affected = false;
+    for (const QString &terminal : closures.closedVertices())
+    {
+        if (onShortestPath(terminal, 0.0, terminal))
+        {
+            affected = true;
+            break;
+        }
+    }
+    for (const auto &closedEdge : closures.closedEdges())
+    {
+        const TransportationMode mode = std::get<2>(closedEdge);
+        if (affected || !modes.contains(mode))
+        {
+            continue;
+        }
+        const QString &from = std::get<0>(closedEdge);
+        const QString &to   = std::get<1>(closedEdge);
+        graph->forEachOutgoingEdge(from, mode, [&](const EdgeType &edge) {
+            if (edge.target() == to
+                && onShortestPath(from, edge.weight(), to))
+            {
+                affected = true;
+            }
+        });
+    }
+    if (!affected)
+    {
+        return openDistance;
+    }
+
+    const auto path = GraphAlgorithmsType::dijkstraShortestPath(
+        *graph, startCanonical, endCanonical, modes, &closures);
+    if (!path.has_value())
+    {
+        return std::nullopt;
+    }
+    return path->second;
+}
+
+std::shared_ptr<const TerminalGraph::TimetableIndex>
+TerminalGraph::timetableIndex(TransportationMode mode)
+{
+    QMutexLocker buildLocker(&m_timetableIndexMutex);
+
+    QHash<EdgeIdentifier, QList<TimetableDeparture>> timetables;
+    QHash<EdgeIdentifier, QList<EdgeData>>           edgeData;
+    QHash<QString, TerminalDetails>                  terminalData;
+    quint64                                          generation = 0;
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        if (m_timetableIndexGeneration != m_topologyGeneration)
+        {
+            m_timetableIndexes.clear();
+            m_timetableIndexGeneration = m_topologyGeneration;
+        }
+        if (m_timetableIndexes.contains(static_cast<int>(mode)))
+        {
+            return m_timetableIndexes.value(static_cast<int>(mode));
+        }
+
+        timetables   = m_timetables;
+        edgeData     = m_edgeData;
+        terminalData = m_terminalData;
+        generation   = m_topologyGeneration;
+    }
+
+    auto index = std::make_shared<TimetableIndex>();
+    std::vector<ConnectionScanType::Connection> connections;
+    QHash<QString, int>                         tripIds;
+
+    for (auto it = timetables.constBegin(); it != timetables.constEnd(); ++it)
+    {
+        const EdgeIdentifier &key = it.key();
+        if (mode != TransportationMode::Any && key.mode != mode)
+        {
+            continue;
+        }
+
+        const QList<EdgeData> routes  = edgeData.value(key);
+        const QString         routeId =
+            routes.isEmpty() ? QString() : routes.first().routeId;
+
+        for (const TimetableDeparture &departure : it.value())
+        {
+            int trip = -1;
+            if (!departure.tripId.isEmpty())
+            {
+                auto tripIt = tripIds.find(departure.tripId);
+                if (tripIt == tripIds.end())
+                {
+                    tripIt = tripIds.insert(departure.tripId,
+                                            static_cast<int>(tripIds.size()));
+                }
+                trip = tripIt.value();
+            }
+
+            connections.push_back(ConnectionScanType::Connection{
+                key.from, key.to, departure.departureTime,
+                departure.arrivalTime, trip,
+                static_cast<int>(index->connections.size())});
+            index->connections.append(TimetableIndex::ConnectionInfo{
+                routeId, departure.tripId, key.mode});
+        }
+    }
+
+    // Changing trips at a terminal costs its container handling time
+    std::unordered_map<QString, double> transferTimes;
+    for (auto it = terminalData.constBegin(); it != terminalData.constEnd();
+         ++it)
+    {
+        transferTimes.emplace(it.key(), it.value().handlingTime);
+    }
+
+    index->engine = ConnectionScanType(std::move(connections), transferTimes);
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        if (m_timetableIndexGeneration == generation)
+        {
+            m_timetableIndexes.insert(static_cast<int>(mode), index);
+        }
+    }
+    return index;
+}
+
+QVariantMap TerminalGraph::findEarliestArrival(const QString     &start,
+                                               const QString     &end,
+                                               double             readyTime,
+                                               TransportationMode mode)
+{
+    QString startCanonical;
+    QString endCanonical;
+    double  destinationHandlingTime = 0.0;
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        startCanonical = getCanonicalName(start);
+        endCanonical   = getCanonicalName(end);
+
+        if (!m_terminals.contains(startCanonical)
+            || !m_terminals.contains(endCanonical))
+        {
+            throw std::invalid_argument("Terminal not found");
+        }
+        destinationHandlingTime =
+            m_terminalData.value(endCanonical).handlingTime;
+    }
+
+    QVariantMap result;
+    result["start_terminal"] = startCanonical;
+    result["end_terminal"]   = endCanonical;
+    result["mode"]           = static_cast<int>(mode);
+    result["ready_time"]     = readyTime;
+
+    if (startCanonical == endCanonical)
+    {
+        result["reachable"]      = true;
+        result["departure_time"] = readyTime;
+        result["arrival_time"]   = readyTime;
+        result["available_time"] = readyTime;
+        result["legs"]           = QVariantList();
+        return result;
+    }
+
+    const std::shared_ptr<const TimetableIndex> index = timetableIndex(mode);
+    const std::vector<bool> cancelled = cancelledConnections(*index);
+    const auto              journey   = index->engine.earliestArrival(
+        startCanonical, endCanonical, readyTime, &cancelled);
+
+    result["reachable"] = journey.has_value();
+    if (!journey.has_value())
+    {
+        return result;
+    }
+
+    const auto  &connections = index->engine.connections();
+    QVariantList legs;
+    for (const auto &leg : journey->legs)
+    {
+        const auto &enter = connections[leg.enter];
+        const auto &exit  = connections[leg.exit];
+        const auto &info  = index->connections[enter.payload];
+
+        QVariantMap legInfo;
+        legInfo["from"]           = enter.from;
+        legInfo["to"]             = exit.to;
+        legInfo["mode"]           = static_cast<int>(info.mode);
+        legInfo["route_id"]       = info.routeId;
+        legInfo["trip_id"]        = info.tripId;
+        legInfo["departure_time"] = enter.departure;
+        legInfo["arrival_time"]   = exit.arrival;
+        legs.append(legInfo);
+    }
+
+    result["departure_time"] =
+        legs.first().toMap().value(QStringLiteral("departure_time"));
+    result["arrival_time"]   = journey->arrival;
+    result["available_time"] = journey->arrival + destinationHandlingTime;
+    result["legs"]           = legs;
+    return result;
+}
+
+QVariantList TerminalGraph::findArrivalProfile(const QString     &start,
+                                               const QString     &end,
+                                               double             windowStart,
+                                               double             windowEnd,
+                                               TransportationMode mode)
+{
+    if (windowEnd < windowStart)
+    {
+        throw std::invalid_argument(
+            "window_end must not precede window_start");
+    }
+
+    QString startCanonical;
+    QString endCanonical;
+
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        startCanonical = getCanonicalName(start);
+        endCanonical   = getCanonicalName(end);
+
+        if (!m_terminals.contains(startCanonical)
+            || !m_terminals.contains(endCanonical))
+        {
+            throw std::invalid_argument("Terminal not found");
+        }
+    }
+
+    const std::shared_ptr<const TimetableIndex> index = timetableIndex(mode);
+    const std::vector<bool> cancelled = cancelledConnections(*index);
+
+    QVariantList profile;
+    for (const auto &entry : index->engine.profile(
+             startCanonical, endCanonical, windowStart, windowEnd, &cancelled))
+    {
+        profile.append(QVariantMap{
+            {QStringLiteral("departure_time"), entry.departure},
+            {QStringLiteral("arrival_time"), entry.arrival}});
+    }
+    return profile;
+}
+
+QVariantMap TerminalGraph::assignTraffic(const QList<FlowDemand> &demands,
+                                         TransportationModeMask   modes,
+                                         double periodHours, int maxIterations,
+                                         double gapTolerance)
+{
+    if (!std::isfinite(periodHours) || periodHours <= 0.0)
+    {
+        throw std::invalid_argument("period_hours must be positive");
+    }
+    if (maxIterations <= 0)
+    {
+        throw std::invalid_argument("max_iterations must be positive");
+    }
+    if (!std::isfinite(gapTolerance) || gapTolerance < 0.0)
+    {
+        throw std::invalid_argument("gap_tolerance must be non-negative");
+    }
+
+    std::vector<TrafficAssignmentType::Demand> assignmentDemands;
+    assignmentDemands.reserve(static_cast<size_t>(demands.size()));
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        for (const FlowDemand &demand : demands)
+        {
+            const QString origin      = getCanonicalName(demand.origin);
+            const QString destination = getCanonicalName(demand.destination);
+            if (!m_terminals.contains(origin)
+                || !m_terminals.contains(destination))
+            {
+                throw std::invalid_argument("Terminal not found");
+            }
+            if (!std::isfinite(demand.teu) || demand.teu <= 0.0)
+            {
+                throw std::invalid_argument("Demand teu must be positive");
+            }
+            assignmentDemands.push_back({origin, destination, demand.teu});
+        }
+    }
+
+    // Edge weights carry only route attributes; terminal handling is added
+    // by the cost function so that it can depend on volume
+    const TopologySnapshot snapshot = snapshotTopology();
+    const GraphType        graph    = buildGraphForMode(snapshot, modes, false);
+    const GraphLib::ClosureOverlay<QString> closures = closureOverlay();
+    const TrafficAssignmentType             assignment(
+        graph, modes, closures.empty() ? nullptr : &closures);
+    const std::vector<EdgeType> &edges = assignment.edges();
+
+    // One congestion slot per (terminal, mode) that an edge touches
+    struct HandlingSlot
+    {
+        QString            terminal;
+        TransportationMode mode;
+        double             delayCost;
+        double             feeCost;
+        double             capacity; ///< TEU per period, 0 when uncongested
+        const SystemDynamicsParams *dynamics;
+    };
+    std::vector<HandlingSlot> slots;
+    QHash<QPair<QString, int>, int> slotIndex;
+    auto slotFor = [&](const QString &terminal, TransportationMode mode) {
+        const QPair<QString, int> key(terminal, static_cast<int>(mode));
+        auto it = slotIndex.constFind(key);
+        if (it != slotIndex.constEnd())
+        {
+            return it.value();
+        }
+
+        const TerminalDetails &details =
+            *snapshot.terminalData.constFind(terminal);
+        slots.push_back(HandlingSlot{
+            terminal, mode,
+            computeCost({{"terminal_delay", details.handlingTime}},
+                        snapshot.costWeights, mode),
+            computeCost({{"terminal_cost", details.handlingCost}},
+                        snapshot.costWeights, mode),
+            details.dynamics.enabled
+                ? details.dynamics.maxServiceRate * periodHours
+                : 0.0,
+            &details.dynamics});
+        slotIndex.insert(key, static_cast<int>(slots.size() - 1));
+        return static_cast<int>(slots.size() - 1);
+    };
+
+    std::vector<int> sourceSlot(edges.size());
+    std::vector<int> targetSlot(edges.size());
+    for (size_t e = 0; e < edges.size(); ++e)
+    {
+        sourceSlot[e] = slotFor(edges[e].source(), edges[e].mode());
+        targetSlot[e] = slotFor(edges[e].target(), edges[e].mode());
+    }
+
+    auto handlingCost = [&slots](int slot, double volume) {
+        const HandlingSlot &handling   = slots[slot];
+        double              multiplier = 1.0;
+        if (handling.capacity > 0.0)
+        {
+            multiplier = handling.dynamics->delayMultiplier(
+                volume / handling.capacity, handling.mode);
+        }
+        return handling.delayCost * multiplier + handling.feeCost;
+    };
+
+    // Every edge pays for handling at both ends, as in buildGraphForMode(),
+    // and a terminal's volume per mode is the flow on the edges it handles
+    auto slotVolumes = [&](const std::vector<double> &flows) {
+        std::vector<double> volumes(slots.size(), 0.0);
+        for (size_t e = 0; e < edges.size(); ++e)
+        {
+            volumes[sourceSlot[e]] += flows[e];
+            volumes[targetSlot[e]] += flows[e];
+        }
+        return volumes;
+    };
+    auto costFunction = [&](const std::vector<double> &flows,
+                            std::vector<double>       &costs) {
+        const std::vector<double> volumes = slotVolumes(flows);
+        for (size_t e = 0; e < edges.size(); ++e)
+        {
+            costs[e] = edges[e].weight()
+                       + handlingCost(sourceSlot[e], volumes[sourceSlot[e]])
+                       + handlingCost(targetSlot[e], volumes[targetSlot[e]]);
+        }
+    };
+
+    const TrafficAssignmentType::Result solution =
+        assignment.solve(assignmentDemands, costFunction, maxIterations,
+                         gapTolerance, poolParallelFor());
+
+    QVariantList links;
+    for (size_t e = 0; e < edges.size(); ++e)
+    {
+        if (solution.flows[e] <= 0.0)
+        {
+            continue;
+        }
+        links.append(QVariantMap{
+            {QStringLiteral("from"), edges[e].source()},
+            {QStringLiteral("to"), edges[e].target()},
+            {QStringLiteral("mode"), static_cast<int>(edges[e].mode())},
+            {QStringLiteral("flow"), solution.flows[e]},
+            {QStringLiteral("cost"), solution.costs[e]}});
+    }
+
+    const std::vector<double> volumes = slotVolumes(solution.flows);
+    QVariantList terminals;
+    for (size_t slot = 0; slot < slots.size(); ++slot)
+    {
+        if (volumes[slot] <= 0.0)
+        {
+            continue;
+        }
+        const HandlingSlot &handling = slots[slot];
+        terminals.append(QVariantMap{
+            {QStringLiteral("terminal"), handling.terminal},
+            {QStringLiteral("mode"), static_cast<int>(handling.mode)},
+            {QStringLiteral("volume"), volumes[slot]},
+            {QStringLiteral("utilization"),
+             handling.capacity > 0.0 ? QVariant(volumes[slot]
+                                                / handling.capacity)
+                                     : QVariant()},
+            {QStringLiteral("handling_cost"),
+             handlingCost(static_cast<int>(slot), volumes[slot])}});
+    }
+
+    QVariantList demandResults;
+    for (size_t i = 0; i < assignmentDemands.size(); ++i)
+    {
+        QVariantList paths;
+        for (const auto &pathFlow : solution.paths[i])
+        {
+            QVariantList pathTerminals{assignmentDemands[i].origin};
+            QVariantList pathModes;
+            double       cost = 0.0;
+            for (size_t edge : pathFlow.edges)
+            {
+                pathTerminals.append(edges[edge].target());
+                pathModes.append(static_cast<int>(edges[edge].mode()));
+                cost += solution.costs[edge];
+            }
+            paths.append(QVariantMap{{QStringLiteral("terminals"), pathTerminals},
+                                     {QStringLiteral("modes"), pathModes},
+                                     {QStringLiteral("flow"), pathFlow.flow},
+                                     {QStringLiteral("cost"), cost}});
+        }
+
+        demandResults.append(QVariantMap{
+            {QStringLiteral("origin"), assignmentDemands[i].origin},
+            {QStringLiteral("destination"), assignmentDemands[i].destination},
+            {QStringLiteral("teu"), assignmentDemands[i].volume},
+            {QStringLiteral("assigned"), !solution.paths[i].empty()},
+            {QStringLiteral("paths"), paths}});
+    }
+
+    QVariantMap result;
+    result["converged"]    = solution.converged;
+    result["iterations"]   = solution.iterations;
+    result["relative_gap"] = solution.relativeGap;
+    result["links"]        = links;
+    result["terminals"]    = terminals;
+    result["demands"]      = demandResults;
+    return result;
+}
+
+QVariantMap
+TerminalGraph::replicateHandling(const QList<HandlingEvent> &schedule,
+                                 int replications, quint64 seed)
+{
+    if (replications <= 0)
+    {
+        throw std::invalid_argument("replications must be positive");
+    }
+
+    struct ScheduledEvent
+    {
+        int                terminal; ///< Index into models
+        double             time;
+        bool               pickup;
+        int                containers;
+        TransportationMode mode;
+    };
+
+    // Copy each terminal's model once; replications only read the copies
+    QList<TerminalHandlingModel> models;
+    QHash<QString, int>          modelIndex;
+    std::vector<ScheduledEvent>  events;
+    events.reserve(static_cast<size_t>(schedule.size()));
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        for (const HandlingEvent &event : schedule)
+        {
+            const QString canonical = getCanonicalName(event.terminal);
+            Terminal     *terminal  = m_terminals.value(canonical, nullptr);
+            if (terminal == nullptr)
+            {
+                throw std::invalid_argument(
+                    QString("Terminal not found: %1")
+                        .arg(event.terminal)
+                        .toStdString());
+            }
+            if (!std::isfinite(event.time) || event.containers < 0)
+            {
+                throw std::invalid_argument(
+                    "Handling events need a finite time and a non-negative "
+                    "container count");
+            }
+
+            auto it = modelIndex.constFind(canonical);
+            if (it == modelIndex.constEnd())
+            {
+                models.append(terminal->handlingModel());
+                it = modelIndex.insert(canonical,
+                                       static_cast<int>(models.size() - 1));
+            }
+            events.push_back(ScheduledEvent{it.value(), event.time,
+                                            event.pickup, event.containers,
+                                            event.mode});
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const ScheduledEvent &a, const ScheduledEvent &b) {
+                         return a.time < b.time;
+                     });
+
+    struct TerminalTotals
+    {
+        double yardDwellSeconds      = 0.0;
+        double customsDelaySeconds   = 0.0;
+        double arrivalPenaltySeconds = 0.0;
+        double directCostUsd         = 0.0;
+        int    containers            = 0;
+        int    rejected              = 0;
+    };
+
+    auto replicate = [&models = std::as_const(models), &events,
+                      seed](int replication) {
+        // Independent stream per replication, reproducible from the seed
+        std::seed_seq seedSequence{static_cast<quint32>(seed),
+                                   static_cast<quint32>(seed >> 32),
+                                   static_cast<quint32>(replication)};
+        std::mt19937  generator(seedSequence);
+
+        std::vector<int> inventory;
+        inventory.reserve(static_cast<size_t>(models.size()));
+        for (const TerminalHandlingModel &model : models)
+        {
+            inventory.push_back(model.containerCount);
+        }
+
+        std::vector<TerminalTotals> totals(inventory.size());
+        for (const ScheduledEvent &event : events)
+        {
+            const TerminalHandlingModel &model = models[event.terminal];
+            TerminalTotals              &total = totals[event.terminal];
+            int                         &stock = inventory[event.terminal];
+            if (event.pickup)
+            {
+                stock -= std::min(event.containers, stock);
+                continue;
+            }
+
+            // A batch sees the utilization it arrives into
+            const double utilization = model.utilizationFor(stock);
+            for (int i = 0; i < event.containers; ++i)
+            {
+                if (stock >= model.maxCapacity)
+                {
+                    ++total.rejected;
+                    continue;
+                }
+                const TerminalHandlingModel::Sample sample =
+                    model.sampleArrival(utilization, event.mode, generator);
+                total.yardDwellSeconds += sample.yardDwellSeconds;
+                total.customsDelaySeconds += sample.customsDelaySeconds;
+                total.arrivalPenaltySeconds += sample.arrivalPenaltySeconds;
+                total.directCostUsd += sample.directCostUsd;
+                ++total.containers;
+                ++stock;
+            }
+        }
+        return totals;
+    };
+
+    QList<int> replicationIds(replications);
+    std::iota(replicationIds.begin(), replicationIds.end(), 0);
+    const QList<std::vector<TerminalTotals>> outcomes =
+        taskPool()->mapped<std::vector<TerminalTotals>>(
+            replicationIds, replicate);
+
+    QVariantMap terminals;
+    for (int t = 0; t < models.size(); ++t)
+    {
+        std::vector<double> yardDwell;
+        std::vector<double> customsDelay;
+        std::vector<double> arrivalPenalty;
+        std::vector<double> cost;
+        double              containers = 0.0;
+        double              rejected   = 0.0;
+        for (const std::vector<TerminalTotals> &outcome : outcomes)
+        {
+            const TerminalTotals &total = outcome[t];
+            const double perContainer =
+                total.containers > 0 ? 1.0 / total.containers : 0.0;
+            yardDwell.push_back(total.yardDwellSeconds * perContainer);
+            customsDelay.push_back(total.customsDelaySeconds * perContainer);
+            arrivalPenalty.push_back(total.arrivalPenaltySeconds
+                                     * perContainer);
+            cost.push_back(total.directCostUsd);
+            containers += total.containers;
+            rejected += total.rejected;
+        }
+
+        terminals[models[t].terminalName] = QVariantMap{
+            {QStringLiteral("containers"), containers / replications},
+            {QStringLiteral("rejected"), rejected / replications},
+            {QStringLiteral("yard_dwell_seconds"),
+             distributionSummary(std::move(yardDwell))},
+            {QStringLiteral("customs_delay_seconds"),
+             distributionSummary(std::move(customsDelay))},
+            {QStringLiteral("arrival_penalty_seconds"),
+             distributionSummary(std::move(arrivalPenalty))},
+            {QStringLiteral("cost_usd"), distributionSummary(std::move(cost))}};
+    }
+
+    QVariantMap result;
+    result["replications"] = replications;
+    result["seed"]         = seed;
+    result["terminals"]    = terminals;
+    return result;
+}
+
+QVariantList
+TerminalGraph::evaluatePathDistribution(const QList<QList<PathLeg>> &paths,
+                                        int samples, quint64 seed,
+                                        bool                 skipDelays,
+                                        const QList<double> &percentiles)
+{
+    if (samples <= 0)
+    {
+        throw std::invalid_argument("samples must be positive");
+    }
+    for (double percentile : percentiles)
+    {
+        if (!(percentile >= 0.0 && percentile <= 100.0))
+        {
+            throw std::invalid_argument(
+                "percentiles must be between 0 and 100");
+        }
+    }
+
+    // A terminal where handling applies, reached by a mode
+    struct Stop
+    {
+        int                model; ///< Index into models
+        TransportationMode mode;
+    };
+    struct PathPlan
+    {
+        QVariantList      legs;
+        double            travelTime = 0.0;
+        std::vector<Stop> stops;
+    };
+
+    QList<TerminalHandlingModel> models;
+    QHash<QString, int>          modelIndex;
+    std::vector<PathPlan>        plans;
+    {
+        ProfiledMutexLocker locker(&m_mutex);
+        for (int p = 0; p < paths.size(); ++p)
+        {
+            const QList<PathLeg> &legs = paths[p];
+            if (legs.isEmpty())
+            {
+                throw std::invalid_argument(
+                    QString("Path %1 has no legs").arg(p).toStdString());
+            }
+
+            PathPlan plan;
+            QString  previous;
+            for (int i = 0; i < legs.size(); ++i)
+            {
+                const QString from = getCanonicalName(legs[i].from);
+                const QString to   = getCanonicalName(legs[i].to);
+                if (i > 0 && from != previous)
+                {
+                    throw std::invalid_argument(
+                        QString("Path %1 breaks between legs %2 and %3")
+                            .arg(p)
+                            .arg(i - 1)
+                            .arg(i)
+                            .toStdString());
+                }
+                previous = to;
+
+                // The graph uses the first route per (from, to, mode)
+                const QList<EdgeData> routes =
+                    m_edgeData.value(EdgeIdentifier(from, to, legs[i].mode));
+                auto route = std::find_if(
+                    routes.cbegin(), routes.cend(),
+                    [&](const EdgeData &data) {
+                        return data.mode == legs[i].mode;
+                    });
+                if (route == routes.cend())
+                {
+                    throw std::invalid_argument(
+                        QString("No %1 route from %2 to %3 in path %4")
+                            .arg(EnumUtils::transportationModeToString(
+                                     legs[i].mode),
+                                 legs[i].from, legs[i].to)
+                            .arg(p)
+                            .toStdString());
+                }
+                plan.travelTime +=
+                    route->attributes.value(QStringLiteral("travelTime"), 0.0)
+                        .toDouble();
+                plan.legs.append(QVariantMap{
+                    {QStringLiteral("from"), from},
+                    {QStringLiteral("to"), to},
+                    {QStringLiteral("mode"), static_cast<int>(legs[i].mode)}});
+
+                // Same rule as the terminals_in_path costs_skipped flag
+                if (skipDelays && i < legs.size() - 1
+                    && legs[i].mode == legs[i + 1].mode)
+                {
+                    continue;
+                }
+                auto it = modelIndex.constFind(to);
+                if (it == modelIndex.constEnd())
+                {
+                    models.append(m_terminals.value(to)->handlingModel());
+                    it = modelIndex.insert(
+                        to, static_cast<int>(models.size() - 1));
+                }
+                plan.stops.push_back(Stop{it.value(), legs[i].mode});
+            }
+            plans.push_back(std::move(plan));
+        }
+    }
+
+    // Blocks of draws are the unit of parallel work; each block fills its
+    // slice one stop at a time
+    constexpr int blockSize = 4096;
+    struct Block
+    {
+        int path;
+        int first;
+        int count;
+    };
+    QList<Block> blocks;
+    for (int p = 0; p < static_cast<int>(plans.size()); ++p)
+    {
+        for (int first = 0; first < samples; first += blockSize)
+        {
+            blocks.append(Block{p, first, std::min(blockSize, samples - first)});
+        }
+    }
+
+    std::vector<std::vector<double>> handling(
+        plans.size(), std::vector<double>(static_cast<size_t>(samples), 0.0));
+    std::vector<std::vector<double>> cost(
+        plans.size(), std::vector<double>(static_cast<size_t>(samples), 0.0));
+    std::vector<std::vector<double>> stopMeans(plans.size());
+    for (size_t p = 0; p < plans.size(); ++p)
+    {
+        stopMeans[p].assign(plans[p].stops.size(), 0.0);
+    }
+    QMutex stopMeansMutex;
+
+    // Blocks write disjoint slices, so only the stop means need a lock
+    taskPool()->parallelFor(blocks.size(), [&](size_t b) {
+        const Block &block = blocks.at(static_cast<qsizetype>(b));
+        std::seed_seq seedSequence{static_cast<quint32>(seed),
+                                   static_cast<quint32>(seed >> 32),
+                                   static_cast<quint32>(block.path),
+                                   static_cast<quint32>(block.first)};
+        std::mt19937  generator(seedSequence);
+
+        const PathPlan     &plan = plans[block.path];
+        double             *time = handling[block.path].data() + block.first;
+        double             *usd  = cost[block.path].data() + block.first;
+        std::vector<double> stopTotals(plan.stops.size(), 0.0);
+        for (size_t s = 0; s < plan.stops.size(); ++s)
+        {
+            const TerminalHandlingModel &model =
+                models.at(plan.stops[s].model);
+            for (int i = 0; i < block.count; ++i)
+            {
+                const TerminalHandlingModel::Sample sample =
+                    model.sampleArrival(model.utilization, plan.stops[s].mode,
+                                        generator);
+                const double seconds = sample.yardDwellSeconds
+                                       + sample.customsDelaySeconds
+                                       + sample.arrivalPenaltySeconds;
+                time[i] += seconds;
+                usd[i] += sample.directCostUsd;
+                stopTotals[s] += seconds;
+            }
+        }
+
+        QMutexLocker locker(&stopMeansMutex);
+        for (size_t s = 0; s < stopTotals.size(); ++s)
+        {
+            stopMeans[block.path][s] += stopTotals[s] / samples;
+        }
+    });
+
+    QVariantList results;
+    for (size_t p = 0; p < plans.size(); ++p)
+    {
+        const PathPlan &plan = plans[p];
+        QVariantList    stops;
+        for (size_t s = 0; s < plan.stops.size(); ++s)
+        {
+            stops.append(QVariantMap{
+                {QStringLiteral("terminal"),
+                 models.at(plan.stops[s].model).terminalName},
+                {QStringLiteral("mode"), static_cast<int>(plan.stops[s].mode)},
+                {QStringLiteral("mean_handling_seconds"), stopMeans[p][s]}});
+        }
+
+        std::vector<double> doorToDoor(handling[p]);
+        for (double &value : doorToDoor)
+        {
+            value += plan.travelTime;
+        }
+
+        results.append(QVariantMap{
+            {QStringLiteral("legs"), plan.legs},
+            {QStringLiteral("travel_time_seconds"), plan.travelTime},
+            {QStringLiteral("stops"), stops},
+            {QStringLiteral("samples"), samples},
+            {QStringLiteral("door_to_door_seconds"),
+             distributionSummary(std::move(doorToDoor), percentiles)},
+            {QStringLiteral("handling_seconds"),
+             distributionSummary(std::move(handling[p]), percentiles)},
+            {QStringLiteral("cost_usd"),
+             distributionSummary(std::move(cost[p]), percentiles)}});
+    }
+    return results;
+}
+
+quint64 TerminalGraph::topologyGeneration() const
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    return m_topologyGeneration;
+}
+
+QString TerminalGraph::addClosure(const Closure &closure,
+                                  const QString &closureId)
+{
+    if (std::isnan(closure.fromTime) || std::isnan(closure.untilTime)
+        || closure.untilTime <= closure.fromTime)
+    {
+        throw std::invalid_argument(
+            "Closure until_time must be later than from_time");
+    }
+
+    // Caller holds m_mutex
+    QString id = closureId;
+    if (id.isEmpty())
+    {
+        do
+        {
+            id = QStringLiteral("closure-%1").arg(m_nextClosureId++);
+        } while (m_closures.contains(id));
+    }
+    else if (m_closures.contains(id))
+    {
+        throw std::invalid_argument(
+            QString("Closure already exists: %1").arg(id).toStdString());
+    }
+
+    m_closures.insert(id, closure);
+    closuresChangedLocked(closure, true);
+    return id;
+}
+
+QString TerminalGraph::closeRoute(const QString &start, const QString &end,
+                                  TransportationMode mode, double fromTime,
+                                  double untilTime, const QString &closureId)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    const QString startCanonical = getCanonicalName(start);
+    const QString endCanonical   = getCanonicalName(end);
+
+    const EdgeIdentifier key(startCanonical, endCanonical, mode);
+    if (!m_edgeData.contains(key))
+    {
+        throw std::invalid_argument(
+            QString("Route not found: %1 -> %2")
+                .arg(startCanonical, endCanonical)
+                .toStdString());
+    }
+
+    const QString id =
+        addClosure(Closure{QString(), key, fromTime, untilTime}, closureId);
+    qCDebug(lcTerminalGraph) << "Closed route" << startCanonical << "->"
+                             << endCanonical << "as" << id;
+    return id;
+}
+
+QString TerminalGraph::closeTerminal(const QString &name, double fromTime,
+                                     double         untilTime,
+                                     const QString &closureId)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    const QString canonical = getCanonicalName(name);
+    if (!m_terminals.contains(canonical))
+    {
+        throw std::invalid_argument("Terminal not found");
+    }
+
+    const QString id = addClosure(
+        Closure{canonical, std::nullopt, fromTime, untilTime}, closureId);
+    qCDebug(lcTerminalGraph) << "Closed terminal" << canonical << "as" << id;
+    return id;
+}
+
+bool TerminalGraph::reopen(const QString &closureId)
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    const auto it = m_closures.constFind(closureId);
+    if (it == m_closures.constEnd())
+    {
+        return false;
+    }
+    const Closure closure = it.value();
+    m_closures.erase(it);
+    closuresChangedLocked(closure, false);
+    return true;
+}
+
+void TerminalGraph::closuresChangedLocked(const Closure &closure, bool closed)
+{
+    // Caller holds m_mutex
+    ++m_closureGeneration;
+
+    // Windowed closures only reach timetable queries, which are not cached
+    if (std::isfinite(closure.fromTime) || std::isfinite(closure.untilTime))
+    {
+        return;
+    }
+
+    const bool cacheCurrent =
+        m_topPathsCacheClosures == m_searchClosureGeneration;
+    ++m_searchClosureGeneration;
+    if (cacheCurrent)
+    {
+        m_topPathsCacheClosures = m_searchClosureGeneration;
+        if (!closed)
+        {
+            // A reopened terminal or route may improve any query
+            m_topPathsCache.clear();
+        }
+        else
+        {
+            // Closing an element removes only paths that use it, so a
+            // ranking without it stays exact
+            auto uses = [&closure](const PathSegment &segment) {
+                if (!closure.route.has_value())
+                {
+                    return segment.from == closure.terminal
+                           || segment.to == closure.terminal;
+                }
+                const EdgeIdentifier &route = *closure.route;
+                return segment.mode == route.mode
+                       && ((segment.from == route.from
+                            && segment.to == route.to)
+                           || (segment.from == route.to
+                               && segment.to == route.from));
+            };
+            for (auto it = m_topPathsCache.begin();
+                 it != m_topPathsCache.end();)
+            {
+                const bool affected = std::any_of(
+                    it->cbegin(), it->cend(), [&uses](const Path &path) {
+                        return std::any_of(path.segments.cbegin(),
+                                           path.segments.cend(), uses);
+                    });
+                it = affected ? m_topPathsCache.erase(it) : std::next(it);
+            }
+        }
+    }
+    networkChangedLocked();
+}
+
+QVariantList TerminalGraph::getClosures() const
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    QVariantList closures;
+    for (auto it = m_closures.constBegin(); it != m_closures.constEnd(); ++it)
+    {
+        const Closure &closure = it.value();
+        QVariantMap    info;
+        info["closure_id"] = it.key();
+        if (closure.route.has_value())
+        {
+            info["start_terminal"] = closure.route->from;
+            info["end_terminal"]   = closure.route->to;
+            info["mode"]           = static_cast<int>(closure.route->mode);
+        }
+        else
+        {
+            info["terminal"] = closure.terminal;
+        }
+        // Unbounded windows are reported as null
+        info["from_time"] = std::isfinite(closure.fromTime)
+                                ? QVariant(closure.fromTime)
+                                : QVariant();
+        info["until_time"] = std::isfinite(closure.untilTime)
+                                 ? QVariant(closure.untilTime)
+                                 : QVariant();
+        closures.append(info);
+    }
+    return closures;
+}
+
+quint64 TerminalGraph::closureGeneration() const
+{
+    ProfiledMutexLocker locker(&m_mutex);
+    return m_closureGeneration;
+}
+
+GraphLib::ClosureOverlay<QString> TerminalGraph::closureOverlay() const
+{
+    ProfiledMutexLocker               locker(&m_mutex);
+    GraphLib::ClosureOverlay<QString> overlay;
+    for (const Closure &closure : m_closures)
+    {
+        // Searches without a clock cannot tell whether a window is open,
+        // so windowed closures are left to the timetable queries
+        if (std::isfinite(closure.fromTime) || std::isfinite(closure.untilTime))
+        {
+            continue;
+        }
+
+        if (closure.route.has_value())
+        {
+            // Routes are bidirectional, so close both directions
+            overlay.closeEdge(closure.route->from, closure.route->to,
+                              closure.route->mode);
+            overlay.closeEdge(closure.route->to, closure.route->from,
+                              closure.route->mode);
+        }
+        else
+        {
+            overlay.closeVertex(closure.terminal);
+        }
+    }
+    return overlay;
+}
+
+std::vector<bool>
+TerminalGraph::cancelledConnections(const TimetableIndex &index) const
+{
+    const auto       &connections = index.engine.connections();
+    std::vector<bool> cancelled(connections.size(), false);
+
+    ProfiledMutexLocker locker(&m_mutex);
+    if (m_closures.isEmpty())
+    {
+        return cancelled;
+    }
+
+    auto isActive = [](const Closure &closure, double time) {
+        return closure.fromTime <= time && time < closure.untilTime;
+    };
+
+    for (size_t i = 0; i < connections.size(); ++i)
+    {
+        const auto &connection = connections[i];
+        const TransportationMode mode =
+            index.connections[connection.payload].mode;
+
+        for (const Closure &closure : m_closures)
+        {
+            bool hit = false;
+            if (closure.route.has_value())
+            {
+                const EdgeIdentifier &route = *closure.route;
+                hit = route.mode == mode
+                      && ((route.from == connection.from
+                           && route.to == connection.to)
+                          || (route.from == connection.to
+                              && route.to == connection.from))
+                      && isActive(closure, connection.departure);
+            }
+            else
+            {
+                hit = (closure.terminal == connection.from
+                       && isActive(closure, connection.departure))
+                      || (closure.terminal == connection.to
+                          && isActive(closure, connection.arrival));
+            }
+
+            if (hit)
+            {
+                cancelled[i] = true;
+                break;
+            }
+        }
+    }
+    return cancelled;
 }
 
 QString TerminalGraph::getCanonicalName(const QString &name) const
@@ -9,15 +9,27 @@
 #include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <limits>
+#include <future>
+#include <memory>
+#include <optional>
 
 #include "common.h"
+#include "ProfiledMutex.h"
+#include "WorkStealingPool.h"
 #include "terminal/terminal.h"
 #include "terminal_path.h"
 #include "terminal_path_segment.h"
 
 // Include the new Graph library
 #include <Algorithms.h>
+#include <ClosureOverlay.h>
+#include <ConnectionScan.h>
 #include <Graph.h>
+#include <HubLabels.h>
+#include <TrafficAssignment.h>
 
 namespace TerminalSim
 {
@@ -55,14 +67,69 @@ struct EdgeIdentifier
     }
 };
 
-inline uint qHash(const EdgeIdentifier &edge, uint seed = 0)
+// Order-sensitive, so A->B and B->A (and A->A in any mode) spread out
+inline size_t qHash(const EdgeIdentifier &edge, size_t seed = 0)
 {
-    seed ^= qHash(edge.from, seed);
-    seed ^= qHash(edge.to, seed);
-    seed ^= static_cast<uint>(edge.mode);
-    return seed;
+    return qHashMulti(seed, edge.from, edge.to, static_cast<int>(edge.mode));
 }
 
+/**
+ * @struct TimetableDeparture
+ * @brief One scheduled departure on a route direction
+ */
+struct TimetableDeparture
+{
+    double  departureTime; ///< Seconds, simulation clock
+    double  arrivalTime;   ///< Seconds, simulation clock
+    QString tripId;        ///< Departures sharing a trip keep the load aboard
+};
+
+/**
+ * @struct FlowDemand
+ * @brief Container volume to move between two terminals in a period
+ */
+struct FlowDemand
+{
+    QString origin;
+    QString destination;
+    double  teu; ///< Volume over the assignment period
+};
+
+/**
+ * @struct RouteQuery
+ * @brief One origin-destination request in a batch path search
+ */
+struct RouteQuery
+{
+    QString                start;
+    QString                end;
+    TransportationModeMask modes = TransportationMode::Any;
+};
+
+/**
+ * @struct HandlingEvent
+ * @brief Scheduled container arrival or pickup at a terminal
+ */
+struct HandlingEvent
+{
+    QString            terminal;
+    double             time   = 0.0; ///< Seconds, simulation clock
+    bool               pickup = false;
+    int                containers = 0;
+    TransportationMode mode = TransportationMode::Any; ///< Arrival mode
+};
+
+/**
+ * @struct PathLeg
+ * @brief One route traversal of a caller-supplied path
+ */
+struct PathLeg
+{
+    QString            from;
+    QString            to;
+    TransportationMode mode = TransportationMode::Any;
+};
+
 /**
  * @class TerminalGraph
  * @brief Manages a network of terminals and routes using k-shortest paths
@@ -99,6 +166,23 @@ public:
     QList<QPair<QString, QString>>
     addRoutes(const QList<QVariantMap> &routesList);
 
+    /**
+     * @brief Replace the departures scheduled from start to end on a route
+     *
+     * Each entry needs departure_time and either arrival_time or
+     * travel_time; travel_time defaults to the route's travelTime
+     * attribute. An optional trip_id links departures of the same vehicle
+     * across routes. An empty list removes the timetable.
+     * @return Number of departures stored
+     */
+    int setRouteTimetable(const QString &start, const QString &end,
+                          TransportationMode  mode,
+                          const QVariantList &departures);
+
+    QList<TimetableDeparture>
+    getRouteTimetable(const QString &start, const QString &end,
+                      TransportationMode mode) const;
+
     // Terminal access
     Terminal *getTerminal(const QString &name) const;
     bool      terminalExists(const QString &name) const;
@@ -110,17 +194,313 @@ public:
                 getAllTerminalNames(bool includeAliases = false) const;
     QVariantMap getTerminalStatus(const QString &name = QString()) const;
     void        clear();
-    int         resetRuntimeState(const QStringList &terminalIds = {});
 
-    // Path finding
+    /**
+     * @brief Drop containers, reservations, records and SD state
+     *
+     * Resetting every terminal bumps a run epoch in O(1); each terminal
+     * drops its stale state the next time it is locked, so terminals a
+     * run never touches cost nothing. Named terminals reset at once.
+     * @param terminalIds Terminals to reset; empty resets all
+     * @return Number of terminals reset
+     */
+    int resetRuntimeState(const QStringList &terminalIds = {});
+
+    /**
+     * @brief Copy-on-write branch of the network and every terminal
+     *
+     * Topology, timetables, closures and cached results are implicitly
+     * shared Qt containers and distance oracles and timetable indexes are
+     * shared immutable pointers, so a branch costs little until it
+     * diverges. Terminals fork with Terminal::fork(). The branch keeps no
+     * terminal directory, so its terminals are always in memory.
+     * @return New graph owned by the caller
+     */
+    TerminalGraph *fork();
+
+    /**
+     * @brief Pool that runs the graph's parallel work
+     *
+     * Batch and sweep searches, spur searches, assignment trees, oracle
+     * builds, replications and bulk terminal imports all run on it, so
+     * they share its workers rather than oversubscribing the machine.
+     * Forks inherit it. Call before the graph is shared between threads.
+     * @param pool Pool owned by the caller; nullptr uses
+     * WorkStealingPool::globalInstance()
+     */
+    void setTaskPool(WorkStealingPool *pool);
+
+    /**
+     * @brief Pool set with setTaskPool(), or the global pool
+     */
+    WorkStealingPool *taskPool() const;
+
+    // Path finding; modes accepts a single mode or a set such as
+    // Truck | Train
     QList<PathSegment>
     findShortestPath(const QString &start, const QString &end,
-                     TransportationMode mode = TransportationMode::Any);
+                     TransportationModeMask modes = TransportationMode::Any);
 
     QList<Path>
     findTopNShortestPaths(const QString &start, const QString &end, int n = 5,
-                          TransportationMode mode = TransportationMode::Any,
-                          bool               skipDelays = true);
+                          TransportationModeMask modes = TransportationMode::Any,
+                          bool                   skipDelays = true);
+
+    /**
+     * @brief Top N paths ranked with transfer costs applied during search
+     *
+     * Searches over (terminal, arrival mode) states so that a terminal's
+     * handling cost is only paid where the mode changes, exactly as
+     * rankingCost prices it. Paths therefore come back in final rank order
+     * and no more than n candidates are generated.
+     */
+    QList<Path>
+    findTopNTransferAwarePaths(const QString &start, const QString &end,
+                               int                    n = 5,
+                               TransportationModeMask modes =
+                                   TransportationMode::Any,
+                               bool skipDelays = true);
+
+    /**
+     * @brief Top N paths for many queries over one graph snapshot
+     *
+     * Queries with the same start, end and mode set share a single search,
+     * and the distinct searches run in parallel, so routing thousands of
+     * containers costs one search per origin-destination group.
+     * @return Paths per query in query order; empty when a terminal is
+     * unknown or no path exists
+     */
+    QList<QList<Path>>
+    findTopNShortestPathsBatch(const QList<RouteQuery> &queries, int n = 1,
+                               bool skipDelays = true);
+
+    /**
+     * @brief Top N paths for many queries under several cost weightings
+     *
+     * Each weight set overrides per-mode entries of the current cost
+     * function parameters, e.g. {"default": {"carbonEmissions": 5}}. All
+     * weight sets price one topology snapshot, graphs and searches run in
+     * parallel, and the live cost function parameters are left unchanged.
+     * @return Paths per weight set, then per query in query order; empty
+     * when a terminal is unknown or no path exists
+     */
+    QList<QList<QList<Path>>>
+    sweepTopNShortestPaths(const QList<QVariantMap> &weightSets,
+                           const QList<RouteQuery> &queries, int n = 1,
+                           bool skipDelays = true);
+
+    /**
+     * @brief Cheapest path that respects hop, transfer and travel time limits
+     *
+     * Unlike filtering the results of findTopNShortestPaths(), the limits
+     * are enforced during search, so a feasible path is found however far
+     * down the unconstrained ranking it sits. Unset limits are ignored.
+     * @param maxTravelTime Upper bound on the sum of route travelTime
+     * attributes
+     * @return The path, or std::nullopt if no path satisfies the limits
+     */
+    std::optional<Path> findConstrainedShortestPath(
+        const QString &start, const QString &end,
+        TransportationModeMask modes         = TransportationMode::Any,
+        std::optional<int>     maxHops       = std::nullopt,
+        std::optional<int>     maxTransfers  = std::nullopt,
+        std::optional<double>  maxTravelTime = std::nullopt);
+
+    /**
+     * @brief Quantity a reachability budget is measured in
+     */
+    enum class ReachabilityMetric
+    {
+        Cost,      ///< Weighted edge cost, as minimised by findShortestPath()
+        TravelTime ///< Sum of route travelTime attributes
+    };
+
+    /**
+     * @brief Terminals reachable from start within a budget
+     *
+     * A single bounded search that stops at the budget, so its work grows
+     * with the reachable region instead of the network. Closures apply.
+     * @return Terminal and distance pairs, nearest first, excluding start
+     */
+    QList<QPair<QString, double>>
+    findReachableTerminals(const QString &start, double budget,
+                           ReachabilityMetric metric = ReachabilityMetric::Cost,
+                           TransportationModeMask modes =
+                               TransportationMode::Any);
+
+    /**
+     * @brief Exact weighted distance between two terminals
+     *
+     * Answered from a per-mode hub-labeling index that is rebuilt lazily,
+     * in parallel for all modes, after any topology or cost change. The
+     * distance is the same edge-weight sum Dijkstra minimises in
+     * findShortestPath().
+     * @return Distance, or std::nullopt if end is unreachable from start
+     */
+    std::optional<double>
+    getDistance(const QString &start, const QString &end,
+                TransportationModeMask modes = TransportationMode::Any);
+
+    /**
+     * @brief Earliest scheduled arrival using route timetables
+     *
+     * Connections are scanned in departure order; changing trips at a
+     * terminal costs that terminal's estimated container handling time.
+     * @param readyTime Seconds at which the container is ready at start
+     * @return Map with reachable, arrival_time, available_time and legs
+     */
+    QVariantMap
+    findEarliestArrival(const QString &start, const QString &end,
+                        double             readyTime,
+                        TransportationMode mode = TransportationMode::Any);
+
+    /**
+     * @brief All non-dominated (ready time, arrival time) pairs in a window
+     * @return List of maps with departure_time and arrival_time, sorted by
+     * departure_time
+     */
+    QVariantList
+    findArrivalProfile(const QString &start, const QString &end,
+                       double windowStart, double windowEnd,
+                       TransportationMode mode = TransportationMode::Any);
+
+    /**
+     * @brief Equilibrium assignment of an OD demand matrix
+     *
+     * Frank-Wolfe on route-only edge costs plus terminal handling costs
+     * that grow with the volume a terminal handles per mode. The delay part
+     * of a terminal's cost is scaled by its BPR-style delay multiplier at
+     * utilization = volume / (max_service_rate * periodHours); terminals
+     * without system dynamics keep a flat cost. Each iteration loads all
+     * origins in parallel over one graph snapshot. Closures apply.
+     * @param periodHours Length of the period the demand volumes cover
+     * @param gapTolerance Relative gap at which the assignment stops
+     * @return Map with converged, iterations, relative_gap, links,
+     * terminals and demands (each with its used paths and their flows)
+     */
+    QVariantMap
+    assignTraffic(const QList<FlowDemand> &demands,
+                  TransportationModeMask   modes = TransportationMode::Any,
+                  double periodHours = 24.0, int maxIterations = 100,
+                  double gapTolerance = 1e-4);
+
+    /**
+     * @brief Monte Carlo replications of a handling schedule
+     *
+     * Each replication replays the schedule in time order against private
+     * copies of the terminals' handling models and inventories, drawing
+     * dwell, customs and arrival penalties from its own generator seeded
+     * from (seed, replication). Utilization follows the replayed inventory
+     * at every event. Replications run in parallel and leave the live
+     * terminals untouched.
+     * @param replications Number of independent replications
+     * @param seed Base seed; equal seeds give equal results
+     * @return Map with replications, seed and terminals, where each
+     * terminal has mean, std_dev, min, p05, p50, p95 and max of
+     * yard_dwell_seconds, customs_delay_seconds and
+     * arrival_penalty_seconds (per container) and cost_usd (total)
+     */
+    QVariantMap replicateHandling(const QList<HandlingEvent> &schedule,
+                                  int replications, quint64 seed);
+
+    /**
+     * @brief Sampled door-to-door time and cost distributions of paths
+     *
+     * Door-to-door time is the sum of the legs' route travelTime plus, at
+     * every terminal where handling applies, a dwell, customs and arrival
+     * penalty draw from that terminal's handling model at its current
+     * utilization. Handling never applies at the origin and, with
+     * skipDelays, not where a path continues in the same mode. Samples are
+     * drawn in blocks that run in parallel, each from its own generator.
+     * @param paths Connected legs per path; every leg must be a route
+     * @param samples Draws per path
+     * @param seed Base seed; equal seeds give equal results
+     * @param percentiles Percentiles (0-100) to report besides mean and
+     * spread
+     * @return One map per path with legs, travel_time_seconds, stops and
+     * summaries of door_to_door_seconds, handling_seconds and cost_usd
+     */
+    QVariantList
+    evaluatePathDistribution(const QList<QList<PathLeg>> &paths, int samples,
+                             quint64 seed, bool skipDelays = true,
+                             const QList<double> &percentiles = {5.0, 50.0,
+                                                                 95.0});
+
+    /**
+     * @brief Counter bumped on every change to topology or cost weights
+     */
+    quint64 topologyGeneration() const;
+
+    /**
+     * @brief How many hot top-N queries to precompute after each change
+     *
+     * findTopNShortestPaths() counts how often each query is asked. After
+     * every topology or closure change a background thread recomputes the
+     * most frequent ones so that their first call is a cache hit.
+     * @param count Queries to warm per change; 0 disables warming
+     */
+    void setHotRoutePrecomputeCount(int count);
+
+    /**
+     * @brief Block until background route warming has finished
+     * @param msecs Time limit in milliseconds; -1 waits forever
+     * @return true if no warming is running
+     */
+    bool waitForHotRoutePrecompute(int msecs = -1);
+
+    /**
+     * @brief Hit, miss and size counters of the top-N result cache
+     */
+    QVariantMap getPathCacheStatistics() const;
+
+    /**
+     * @brief Close a route in both directions for a time window
+     *
+     * Closures are an overlay that searches consult while relaxing edges;
+     * the graph, its routes and cached indexes stay untouched. Timetable
+     * queries skip departures inside the window. Path, distance,
+     * reachability and assignment queries carry no time, so they only
+     * honour closures without a window, which last until reopen(); a
+     * closure with either bound set never affects them.
+     * @param fromTime Seconds at which the closure starts
+     * @param untilTime Seconds at which the route reopens
+     * @param closureId Id to register under, generated if empty
+     * @return Closure id to pass to reopen()
+     */
+    QString closeRoute(const QString &start, const QString &end,
+                       TransportationMode mode,
+                       double fromTime = -std::numeric_limits<double>::infinity(),
+                       double untilTime = std::numeric_limits<double>::infinity(),
+                       const QString &closureId = QString());
+
+    /**
+     * @brief Close a terminal for a time window; no route may depart from
+     * or arrive at it while closed
+     *
+     * Windows apply as for closeRoute(): queries without a time only
+     * honour a closure with neither bound set.
+     * @return Closure id to pass to reopen()
+     */
+    QString closeTerminal(const QString &name,
+                          double fromTime = -std::numeric_limits<double>::infinity(),
+                          double untilTime = std::numeric_limits<double>::infinity(),
+                          const QString &closureId = QString());
+
+    /**
+     * @brief Remove a closure
+     * @return true if the closure existed
+     */
+    bool reopen(const QString &closureId);
+
+    /**
+     * @brief Registered closures with their targets and windows
+     */
+    QVariantList getClosures() const;
+
+    /**
+     * @brief Counter bumped whenever a closure is added or removed
+     */
+    quint64 closureGeneration() const;
 
 private:
     // New Graph library representation - using QString for vertex IDs and
@@ -130,9 +510,22 @@ private:
     using EdgeType            = GraphLib::Edge<QString, double>;
     using EdgePathType        = typename GraphAlgorithmsType::EdgePath;
     using EdgePathInfoType    = typename GraphAlgorithmsType::EdgePathInfo;
-
-    // The graph object
-    GraphType m_graph;
+    using HubLabelsType       = GraphLib::HubLabels<QString, double>;
+    using ConnectionScanType  = GraphLib::ConnectionScan<QString, double>;
+    using TrafficAssignmentType =
+        GraphLib::TrafficAssignment<QString, double>;
+
+    // All-mode graph for m_graphGeneration, holding every mode in per-mode
+    // adjacency layers. Never modified once published, so searches keep
+    // using their copy while a newer generation replaces it.
+    std::shared_ptr<const GraphType> m_graph =
+        std::make_shared<const GraphType>();
+    quint64 m_graphGeneration = 0;
+
+    // Route travel times per graph edge for m_graphGeneration, published
+    // with m_graph so travel-time searches need no per-query rebuild
+    std::shared_ptr<const QHash<EdgeIdentifier, double>> m_travelTimes =
+        std::make_shared<const QHash<EdgeIdentifier, double>>();
 
     // Edge data
     struct EdgeData
@@ -145,10 +538,42 @@ private:
     {
         double handlingTime;  ///< Seconds. Mirrors Terminal::estimateContainerHandlingTime().
         double handlingCost;  ///< USD per container. Mirrors Terminal::estimateContainerCost().
+        SystemDynamicsParams dynamics; ///< Congestion curve for traffic assignment
+    };
+
+    /**
+     * @brief Consistent copy of everything needed to build a GraphType
+     */
+    struct TopologySnapshot
+    {
+        QStringList                            terminals;
+        QHash<EdgeIdentifier, QList<EdgeData>> edgeData;
+        QHash<QString, TerminalDetails>        terminalData;
+        QVariantMap                            costWeights;
+        quint64                                generation = 0;
+    };
+
+    /**
+     * @brief Connection scan engine plus the route data behind each payload
+     */
+    struct TimetableIndex
+    {
+        struct ConnectionInfo
+        {
+            QString            routeId;
+            QString            tripId;
+            TransportationMode mode;
+        };
+
+        ConnectionScanType    engine;
+        QList<ConnectionInfo> connections; ///< Indexed by Connection::payload
     };
 
     QHash<EdgeIdentifier, QList<EdgeData>> m_edgeData;
 
+    // Departures per route direction, sorted by departure time
+    QHash<EdgeIdentifier, QList<TimetableDeparture>> m_timetables;
+
     QHash<QString, QString>       m_terminalAliases;
     QHash<QString, QSet<QString>> m_canonicalToAliases;
     QHash<QString, Terminal *>    m_terminals;
@@ -158,22 +583,179 @@ private:
     QString        m_pathToTerminalsDirectory;
     QVariantMap    m_costFunctionParametersWeights;
     QVariantMap    m_defaultLinkAttributes;
-    mutable QMutex m_mutex;
+    mutable ProfiledMutex m_mutex{"TerminalGraph::m_mutex"};
+
+    // Parallel work; see setTaskPool()
+    WorkStealingPool *m_taskPool = nullptr;
+
+    // Run epoch followed by every terminal; bumped to reset them all
+    std::shared_ptr<std::atomic<quint64>> m_runtimeEpoch =
+        std::make_shared<std::atomic<quint64>>(0);
+
+    // Bumped under m_mutex whenever terminals, routes or weights change
+    quint64 m_topologyGeneration = 0;
+
+    // Closure overlay keyed by closure id. Closures do not bump the topology
+    // generation, so graph and index caches survive them.
+    struct Closure
+    {
+        QString                       terminal;
+        std::optional<EdgeIdentifier> route;
+        double                        fromTime;
+        double                        untilTime;
+    };
+    QHash<QString, Closure> m_closures;
+    quint64                 m_closureGeneration = 0;
+
+    // Bumped only when the closures without a window change, since those
+    // are the only ones searches without time see
+    quint64 m_searchClosureGeneration = 0;
+    quint64                 m_nextClosureId     = 1;
+
+    // Hub-labeling distance oracles keyed by mode-set bits, valid for
+    // m_distanceOracleGeneration. m_distanceOracleMutex serializes rebuilds.
+    QHash<int, std::shared_ptr<const HubLabelsType>> m_distanceOracles;
+    quint64                                          m_distanceOracleGeneration = 0;
+    QMutex                                           m_distanceOracleMutex;
+
+    // Connection scan engines keyed by mode, valid for
+    // m_timetableIndexGeneration
+    QHash<int, std::shared_ptr<const TimetableIndex>> m_timetableIndexes;
+    quint64                                           m_timetableIndexGeneration = 0;
+    QMutex                                            m_timetableIndexMutex;
+
+    // Top-N searches currently running, keyed by query, topology and
+    // search closure generation.
+    // Guarded by m_mutex; callers with the same key wait on the future,
+    // except that clients never wait on the low-priority warmer.
+    struct InFlightSearch
+    {
+        std::shared_future<QList<Path>> result;
+        bool                            precompute = false;
+    };
+    QHash<QString, InFlightSearch> m_inFlightTopPaths;
+
+    // Finished top-N results keyed by query and topology, valid for
+    // m_topPathsCacheTopology. Closing a terminal or route evicts only the
+    // entries whose paths use it; m_topPathsCacheClosures is the search
+    // closure generation the survivors describe. Guarded by m_mutex.
+    QHash<QString, QList<Path>> m_topPathsCache;
+    quint64                     m_topPathsCacheTopology = 0;
+    quint64                     m_topPathsCacheClosures = 0;
+    quint64                     m_topPathsCacheHits     = 0;
+    quint64                     m_topPathsCacheMisses   = 0;
+    quint64                     m_topPathsPrecomputed   = 0;
+
+    // Client top-N queries by frequency, halved on every warm-up so that
+    // old favourites fade. Guarded by m_mutex.
+    struct HotQuery
+    {
+        QString                start;
+        QString                end;
+        TransportationModeMask modes;
+        int                    n          = 0;
+        bool                   skipDelays = true;
+        quint64                hits       = 0;
+    };
+    QHash<QString, HotQuery> m_hotQueries;
+    int                      m_hotRoutePrecomputeCount = 16;
+    bool                     m_hotRouteWarmupRunning   = false;
+    quint64                  m_hotRouteWarmedTopology  = 0;
+    quint64                  m_hotRouteWarmedClosures  = 0;
+
+    // Single low-priority thread for warming; waited for on destruction
+    QThreadPool m_hotRoutePool;
 
     // Helper methods
     QString getCanonicalName(const QString &name) const;
 
+    // Runs GraphLib's parallel loops on taskPool()
+    GraphAlgorithmsType::ParallelFor poolParallelFor() const;
+
     double computeCost(const QVariantMap &params, const QVariantMap &weights,
                        TransportationMode mode) const;
 
-    // Convert between GraphLib edge path and TerminalSim path
-    Path convertEdgePathToTerminalPath(const EdgePathInfoType &pathInfo,
-                                       int displayPathId,
-                                       TransportationMode mode,
-                                       bool skipDelays) const;
-
-    // Update graph for specific mode
-    void updateGraph(TransportationMode mode);
+    // Convert between GraphLib edge path and TerminalSim path, pricing
+    // with a snapshot's data and weights when given, else the live ones
+    Path convertEdgePathToTerminalPath(
+        const EdgePathInfoType &pathInfo, int displayPathId,
+        TransportationModeMask modes, bool skipDelays,
+        const TopologySnapshot *snapshot = nullptr) const;
+
+    // All-mode graph of the current topology, rebuilt if it changed since
+    // the last build; optionally also the route travel times of the same
+    // generation
+    std::shared_ptr<const GraphType> currentGraph(
+        std::shared_ptr<const QHash<EdgeIdentifier, double>> *travelTimes =
+            nullptr);
+
+    // Copy topology and weights under the lock
+    TopologySnapshot snapshotTopology() const;
+
+    // Build the weighted graph for a mode from a snapshot
+    GraphType buildGraphForMode(const TopologySnapshot &snapshot,
+                                TransportationModeMask  modes,
+                                bool includeTerminalCosts = true) const;
+
+    // Route travelTime per graph edge, first route per (from, to, mode)
+    static QHash<EdgeIdentifier, double>
+    routeTravelTimes(const TopologySnapshot &snapshot);
+
+    // Serve a validated top-N query from the cache, an identical running
+    // search, or a new search whose result is then cached
+    QList<Path> sharedTopNShortestPaths(const QString &start,
+                                        const QString &end, int n,
+                                        TransportationModeMask modes,
+                                        bool skipDelays, bool precompute);
+
+    // Drop the in-flight entry this leader registered; caller holds m_mutex
+    void releaseInFlightLocked(const QString &flightKey, bool precompute);
+
+    // Bump the closure generations after a closure was added or removed and
+    // evict the cached top-N results it may change; caller holds m_mutex
+    void closuresChangedLocked(const Closure &closure, bool closed);
+
+    // Start warming hot queries after a generation bump; caller holds m_mutex
+    void networkChangedLocked();
+
+    // Background loop that warms hot queries until the cache is current
+    void warmHotRoutes();
+
+    // Run the k-shortest-path search behind findTopNShortestPaths()
+    QList<Path> computeTopNShortestPaths(const QString &start,
+                                         const QString &end, int n,
+                                         TransportationModeMask modes,
+                                         bool                   skipDelays);
+
+    // Convert, dedupe and rank k-shortest-path results
+    QList<Path> rankTopPaths(const std::vector<EdgePathInfoType> &kPaths,
+                             const QString &start, const QString &end, int n,
+                             TransportationModeMask  modes,
+                             bool                    skipDelays,
+                             const TopologySnapshot *snapshot = nullptr) const;
+
+    // Get the distance oracle for a mode set, rebuilding the standard sets
+    // if stale and adding mixed sets on first use
+    std::shared_ptr<const HubLabelsType>
+    distanceOracle(TransportationModeMask modes);
+
+    // Get the connection scan engine for a mode, rebuilding it if stale
+    std::shared_ptr<const TimetableIndex>
+    timetableIndex(TransportationMode mode);
+
+    // Overlay of the closures without a window, for searches without time
+    GraphLib::ClosureOverlay<QString> closureOverlay() const;
+
+    // Connections of a timetable index that fall inside a closure window
+    std::vector<bool> cancelledConnections(const TimetableIndex &index) const;
+
+    // Register a closure under a given or generated id
+    QString addClosure(const Closure &closure, const QString &closureId);
+
+    // Validate timetable entries against a route's attributes
+    static QList<TimetableDeparture>
+    parseTimetable(const QVariant &value, const QVariantMap &routeAttributes,
+                   const QString &context);
 
     // Build a path segment with detailed costs
     void buildPathSegment(PathSegment &segment, int sequenceIndex,
@@ -181,7 +763,8 @@ private:
                           bool skipStartTerminal, bool skipEndTerminal,
                           const QString &from, const QString &to,
                           TransportationMode mode,
-                          const QVariantMap &attributes) const;
+                          const QVariantMap &attributes,
+                          const TopologySnapshot *snapshot = nullptr) const;
 
     QPair<QString, QString> addRouteInternal(const QString     &id,
                                              const QString     &start,
@@ -189,7 +772,11 @@ private:
                                              TransportationMode mode,
                                              const QVariantMap &attrs);
 
-    Terminal *addTerminalInternal(const QVariantMap &terminalData);
+    // Build a terminal from validated data; touches no graph state
+    Terminal *createTerminal(const QVariantMap &terminalData) const;
+    // Add a terminal built by createTerminal(); caller holds m_mutex
+    Terminal *addTerminalInternal(const QVariantMap &terminalData,
+                                  Terminal          *term);
 };
 
 } // namespace TerminalSim
@@ -21,6 +21,8 @@ struct Path
     QString            startTerminal;      ///< Canonical start terminal id
     QString            endTerminal;        ///< Canonical end terminal id
     int                requestedMode = 0;  ///< Requested discovery mode
+    TransportationModeMask requestedModes =
+        TransportationMode::Any;           ///< Requested discovery mode set
     int                requestedTopN = 0;  ///< Requested top-N
     bool skipSameModeTerminalDelaysAndCosts = true;
     double             rankingCost = 0.0;  ///< Scalar used for ordering
@@ -65,6 +67,15 @@ struct Path
         discoveryContext["start_terminal"] = startTerminal;
         discoveryContext["end_terminal"] = endTerminal;
         discoveryContext["requested_mode"] = requestedMode;
+        QJsonArray requestedModesArray;
+        for (int mode = 0; mode < TransportationModeMask::ModeCount; ++mode)
+        {
+            if (requestedModes.contains(static_cast<TransportationMode>(mode)))
+            {
+                requestedModesArray.append(mode);
+            }
+        }
+        discoveryContext["requested_modes"] = requestedModesArray;
         discoveryContext["requested_top_n"] = requestedTopN;
         discoveryContext["skip_same_mode_terminal_delays_and_costs"] =
             skipSameModeTerminalDelaysAndCosts;
@@ -1,6 +1,10 @@
+#include <QSet>
 #include <QTest>
+#include <QThread>
 #include <QVariantList>
 #include <QVariantMap>
+#include <atomic>
+#include <memory>
 #include <stdexcept>
 
 #include "terminal/terminal_graph.h"
@@ -374,6 +378,1131 @@ private slots:
         QVERIFY(paths.isEmpty());
     }
 
+    void test_distance_oracle_tracks_topology_changes()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 1800.0, 25.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("D"), 0.0, 0.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C"))});
+
+        const auto ab = graph.getDistance(QStringLiteral("A"),
+                                          QStringLiteral("B"));
+        const auto bc = graph.getDistance(QStringLiteral("B"),
+                                          QStringLiteral("C"));
+        const auto ac = graph.getDistance(QStringLiteral("A"),
+                                          QStringLiteral("C"));
+        QVERIFY(ab.has_value());
+        QVERIFY(bc.has_value());
+        QVERIFY(ac.has_value());
+        QVERIFY(*ab > 0.0);
+        QVERIFY(nearlyEqual(*ac, *ab + *bc));
+        QVERIFY(nearlyEqual(*graph.getDistance(QStringLiteral("C"),
+                                               QStringLiteral("A")),
+                            *ac));
+
+        QVERIFY(!graph.getDistance(QStringLiteral("A"),
+                                   QStringLiteral("D")).has_value());
+        QVERIFY(!graph.getDistance(QStringLiteral("A"),
+                                   QStringLiteral("C"),
+                                   TransportationMode::Ship).has_value());
+
+        const quint64 generation = graph.topologyGeneration();
+        graph.addRoute(QStringLiteral("AC"),
+                       QStringLiteral("A"),
+                       QStringLiteral("C"),
+                       TransportationMode::Train,
+                       makeRoute(QStringLiteral("AC"), QStringLiteral("A"), QStringLiteral("C"))
+                           .value(QStringLiteral("attributes")).toMap());
+        QVERIFY(graph.topologyGeneration() > generation);
+
+        const auto direct = graph.getDistance(QStringLiteral("A"),
+                                              QStringLiteral("C"),
+                                              TransportationMode::Train);
+        QVERIFY(direct.has_value());
+        QVERIFY(*direct < *ac);
+
+        QVERIFY_EXCEPTION_THROWN(
+            graph.getDistance(QStringLiteral("A"), QStringLiteral("missing")),
+            std::invalid_argument);
+    }
+
+    void test_timetable_earliest_arrival_respects_transfer_handling()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 1800.0, 25.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+
+        QVariantMap ab =
+            makeRoute(QStringLiteral("AB"), QStringLiteral("A"), QStringLiteral("B"));
+        ab[QStringLiteral("timetable")] = QVariantList{
+            QVariantMap{{QStringLiteral("departure_time"), 0.0},
+                        {QStringLiteral("arrival_time"), 100.0},
+                        {QStringLiteral("trip_id"), QStringLiteral("T1")}}};
+        QVariantMap bc =
+            makeRoute(QStringLiteral("BC"), QStringLiteral("B"), QStringLiteral("C"));
+        bc[QStringLiteral("timetable")] = QVariantList{
+            QVariantMap{{QStringLiteral("departure_time"), 110.0},
+                        {QStringLiteral("arrival_time"), 200.0}},
+            QVariantMap{{QStringLiteral("departure_time"), 150.0},
+                        {QStringLiteral("arrival_time"), 300.0},
+                        {QStringLiteral("trip_id"), QStringLiteral("T1")}}};
+        graph.addRoutes({ab, bc});
+        QCOMPARE(graph.getRouteTimetable(QStringLiteral("B"),
+                                         QStringLiteral("C"),
+                                         TransportationMode::Train)
+                     .size(),
+                 2);
+
+        // The 110s departure needs a transfer at B, which its handling time
+        // rules out; staying aboard trip T1 does not.
+        const QVariantMap journey = graph.findEarliestArrival(
+            QStringLiteral("A"), QStringLiteral("C"), 0.0);
+        QVERIFY(journey.value(QStringLiteral("reachable")).toBool());
+        QVERIFY(nearlyEqual(
+            journey.value(QStringLiteral("arrival_time")).toDouble(), 300.0));
+        const QVariantList legs =
+            journey.value(QStringLiteral("legs")).toList();
+        QCOMPARE(legs.size(), 1);
+        QCOMPARE(legs.first().toMap().value(QStringLiteral("trip_id")).toString(),
+                 QStringLiteral("T1"));
+
+        QVERIFY(!graph.findEarliestArrival(QStringLiteral("A"),
+                                           QStringLiteral("C"), 1.0)
+                     .value(QStringLiteral("reachable"))
+                     .toBool());
+
+        const QVariantList profile = graph.findArrivalProfile(
+            QStringLiteral("A"), QStringLiteral("C"), 0.0, 1000.0);
+        QCOMPARE(profile.size(), 1);
+        QVERIFY(nearlyEqual(profile.first()
+                                .toMap()
+                                .value(QStringLiteral("arrival_time"))
+                                .toDouble(),
+                            300.0));
+
+        QVERIFY_EXCEPTION_THROWN(
+            graph.setRouteTimetable(
+                QStringLiteral("A"), QStringLiteral("B"),
+                TransportationMode::Train,
+                {QVariantMap{{QStringLiteral("departure_time"), 50.0},
+                             {QStringLiteral("arrival_time"), 10.0}}}),
+            std::invalid_argument);
+    }
+
+    void test_transfer_aware_search_ranks_by_final_cost()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 36000.0, 1000.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+
+        QVariantMap shipRoute = makeRoute(QStringLiteral("AC"),
+                                          QStringLiteral("A"),
+                                          QStringLiteral("C"));
+        shipRoute[QStringLiteral("mode")] =
+            static_cast<int>(TransportationMode::Ship);
+        QVariantMap shipAttributes =
+            shipRoute.value(QStringLiteral("attributes")).toMap();
+        shipAttributes[QStringLiteral("cost")] = 30.0;
+        shipRoute[QStringLiteral("attributes")] = shipAttributes;
+
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C")),
+                         shipRoute});
+
+        // B is expensive but skipped on the same-mode train path, so that
+        // path is cheaper even though the edge-weight search ranks it last
+        const QList<Path> legacy = graph.findTopNShortestPaths(
+            QStringLiteral("A"), QStringLiteral("C"), 1,
+            TransportationMode::Any, true);
+        const QList<Path> aware = graph.findTopNTransferAwarePaths(
+            QStringLiteral("A"), QStringLiteral("C"), 1,
+            TransportationMode::Any, true);
+        QCOMPARE(legacy.size(), 1);
+        QCOMPARE(aware.size(), 1);
+        QCOMPARE(aware.first().segments.size(), 2);
+        QCOMPARE(aware.first().segments.first().to, QStringLiteral("B"));
+        QVERIFY(aware.first().rankingCost < legacy.first().rankingCost);
+
+        const QList<Path> both = graph.findTopNTransferAwarePaths(
+            QStringLiteral("A"), QStringLiteral("C"), 2,
+            TransportationMode::Any, true);
+        QCOMPARE(both.size(), 2);
+        QVERIFY(both[0].rankingCost <= both[1].rankingCost);
+        QCOMPARE(both[1].segments.size(), 1);
+        QCOMPARE(both[1].segments.first().mode, TransportationMode::Ship);
+        QCOMPARE(both[0].pathUid, aware.first().pathUid);
+    }
+
+    void test_transfer_aware_search_returns_cheapest_simple_path()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("S"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 36000.0, 1000.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("T"), 0.0, 0.0));
+
+        auto shipRoute = [](const QString &id, const QString &from,
+                            const QString &to, double cost) {
+            QVariantMap route = makeRoute(id, from, to);
+            route[QStringLiteral("mode")] =
+                static_cast<int>(TransportationMode::Ship);
+            QVariantMap attributes =
+                route.value(QStringLiteral("attributes")).toMap();
+            attributes[QStringLiteral("cost")] = cost;
+            route[QStringLiteral("attributes")] = attributes;
+            return route;
+        };
+
+        graph.addRoutes({makeRoute(QStringLiteral("SA"), QStringLiteral("S"),
+                                   QStringLiteral("A")),
+                         makeRoute(QStringLiteral("AB"), QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         shipRoute(QStringLiteral("AB-ship"),
+                                   QStringLiteral("A"), QStringLiteral("B"),
+                                   10.0),
+                         shipRoute(QStringLiteral("AT"), QStringLiteral("A"),
+                                   QStringLiteral("T"), 10.0),
+                         shipRoute(QStringLiteral("BT"), QStringLiteral("B"),
+                                   QStringLiteral("T"), 200.0)});
+
+        // The cheapest state-graph route avoids the train-to-ship change at
+        // A by going S-A-B-A-T; the cheapest route that visits A once
+        // changes mode at B instead
+        const QList<Path> best = graph.findTopNTransferAwarePaths(
+            QStringLiteral("S"), QStringLiteral("T"), 1,
+            TransportationMode::Any, true);
+        QCOMPARE(best.size(), 1);
+        QCOMPARE(best.first().segments.size(), 3);
+        QCOMPARE(best.first().segments[1].to, QStringLiteral("B"));
+
+        const QList<Path> ranked = graph.findTopNTransferAwarePaths(
+            QStringLiteral("S"), QStringLiteral("T"), 3,
+            TransportationMode::Any, true);
+        QCOMPARE(ranked.size(), 3);
+        QCOMPARE(ranked.first().pathUid, best.first().pathUid);
+        for (const Path &path : ranked)
+        {
+            QSet<QString> visited{path.segments.first().from};
+            for (const PathSegment &segment : path.segments)
+            {
+                QVERIFY(!visited.contains(segment.to));
+                visited.insert(segment.to);
+            }
+        }
+    }
+
+    void test_mode_set_queries_use_only_selected_modes()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+
+        QVariantMap shipRoute = makeRoute(QStringLiteral("BC"),
+                                          QStringLiteral("B"),
+                                          QStringLiteral("C"));
+        shipRoute[QStringLiteral("mode")] =
+            static_cast<int>(TransportationMode::Ship);
+        QVariantMap directRoute = makeRoute(QStringLiteral("AC"),
+                                            QStringLiteral("A"),
+                                            QStringLiteral("C"));
+        QVariantMap directAttributes =
+            directRoute.value(QStringLiteral("attributes")).toMap();
+        directAttributes[QStringLiteral("cost")] = 100.0;
+        directRoute[QStringLiteral("attributes")] = directAttributes;
+
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         shipRoute, directRoute});
+
+        const TransportationModeMask shipOrTrain =
+            TransportationModeMask(TransportationMode::Train)
+            | TransportationMode::Ship;
+        QCOMPARE(EnumUtils::parseTransportationModeMask(
+                     QStringLiteral("train|Ship")),
+                 shipOrTrain);
+        QVERIFY(!shipOrTrain.singleMode().has_value());
+
+        const QList<PathSegment> trainOnly = graph.findShortestPath(
+            QStringLiteral("A"), QStringLiteral("C"),
+            TransportationMode::Train);
+        QCOMPARE(trainOnly.size(), 1);
+
+        const QList<PathSegment> mixed = graph.findShortestPath(
+            QStringLiteral("A"), QStringLiteral("C"), shipOrTrain);
+        QCOMPARE(mixed.size(), 2);
+        QCOMPARE(mixed[0].mode, TransportationMode::Train);
+        QCOMPARE(mixed[1].mode, TransportationMode::Ship);
+
+        QVERIFY(*graph.getDistance(QStringLiteral("A"), QStringLiteral("C"),
+                                   shipOrTrain)
+                < *graph.getDistance(QStringLiteral("A"), QStringLiteral("C"),
+                                     TransportationMode::Train));
+        QVERIFY(!graph.getDistance(QStringLiteral("A"), QStringLiteral("C"),
+                                   TransportationMode::Ship).has_value());
+
+        const QList<Path> paths = graph.findTopNShortestPaths(
+            QStringLiteral("A"), QStringLiteral("C"), 2, shipOrTrain, true);
+        QCOMPARE(paths.size(), 2);
+        for (const Path &path : paths)
+        {
+            QCOMPARE(path.requestedModes, shipOrTrain);
+            QCOMPARE(path.requestedMode,
+                     static_cast<int>(TransportationMode::Any));
+            for (const PathSegment &segment : path.segments)
+            {
+                QVERIFY(shipOrTrain.contains(segment.mode));
+            }
+        }
+        QVERIFY(paths.first().pathUid.contains(QStringLiteral("mode=set-")));
+    }
+
+    void test_closures_overlay_searches_without_topology_changes()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+
+        QVariantMap direct = makeRoute(QStringLiteral("AC"),
+                                       QStringLiteral("A"),
+                                       QStringLiteral("C"));
+        QVariantMap directAttributes =
+            direct.value(QStringLiteral("attributes")).toMap();
+        directAttributes[QStringLiteral("cost")] = 100.0;
+        direct[QStringLiteral("attributes")] = directAttributes;
+        direct[QStringLiteral("timetable")] = QVariantList{
+            QVariantMap{{QStringLiteral("departure_time"), 100.0},
+                        {QStringLiteral("arrival_time"), 150.0}},
+            QVariantMap{{QStringLiteral("departure_time"), 500.0},
+                        {QStringLiteral("arrival_time"), 550.0}}};
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C")),
+                         direct});
+
+        QCOMPARE(graph.findShortestPath(QStringLiteral("A"),
+                                        QStringLiteral("C"))
+                     .size(),
+                 2);
+        const double viaB =
+            *graph.getDistance(QStringLiteral("A"), QStringLiteral("C"));
+
+        // Closing the direct route, which no shortest path uses, leaves the
+        // distance alone
+        const QString offPathClosure = graph.closeRoute(
+            QStringLiteral("A"), QStringLiteral("C"),
+            TransportationMode::Train);
+        QVERIFY(nearlyEqual(
+            *graph.getDistance(QStringLiteral("A"), QStringLiteral("C")),
+            viaB));
+        QVERIFY(graph.reopen(offPathClosure));
+
+        const quint64 topology = graph.topologyGeneration();
+        const quint64 closures = graph.closureGeneration();
+        const QString terminalClosure =
+            graph.closeTerminal(QStringLiteral("B"));
+        QCOMPARE(graph.topologyGeneration(), topology);
+        QVERIFY(graph.closureGeneration() > closures);
+        QCOMPARE(graph.getClosures().size(), 1);
+
+        QCOMPARE(graph.findShortestPath(QStringLiteral("A"),
+                                        QStringLiteral("C"))
+                     .size(),
+                 1);
+        QVERIFY(*graph.getDistance(QStringLiteral("A"), QStringLiteral("C"))
+                > viaB);
+        QVERIFY(!graph.getDistance(QStringLiteral("A"), QStringLiteral("B"))
+                     .has_value());
+
+        // Timetable queries only skip departures inside the window; path
+        // queries have no time and ignore windowed closures
+        const QString windowClosure = graph.closeRoute(
+            QStringLiteral("C"), QStringLiteral("A"),
+            TransportationMode::Train, 0.0, 200.0);
+        const QVariantMap journey = graph.findEarliestArrival(
+            QStringLiteral("A"), QStringLiteral("C"), 0.0);
+        QVERIFY(journey.value(QStringLiteral("reachable")).toBool());
+        QVERIFY(nearlyEqual(
+            journey.value(QStringLiteral("arrival_time")).toDouble(), 550.0));
+        QCOMPARE(graph.findShortestPath(QStringLiteral("A"),
+                                        QStringLiteral("C"))
+                     .size(),
+                 1);
+
+        const QString routeClosure = graph.closeRoute(
+            QStringLiteral("C"), QStringLiteral("A"),
+            TransportationMode::Train);
+        QVERIFY_EXCEPTION_THROWN(
+            graph.findShortestPath(QStringLiteral("A"), QStringLiteral("C")),
+            std::runtime_error);
+
+        QVERIFY(graph.reopen(routeClosure));
+        QVERIFY(graph.reopen(windowClosure));
+        QVERIFY(graph.reopen(terminalClosure));
+        QVERIFY(!graph.reopen(terminalClosure));
+        QVERIFY(nearlyEqual(
+            *graph.getDistance(QStringLiteral("A"), QStringLiteral("C")),
+            viaB));
+        QCOMPARE(graph.topologyGeneration(), topology);
+
+        QVERIFY_EXCEPTION_THROWN(
+            graph.closeTerminal(QStringLiteral("B"), 10.0, 5.0),
+            std::invalid_argument);
+        QVERIFY_EXCEPTION_THROWN(
+            graph.closeRoute(QStringLiteral("A"), QStringLiteral("C"),
+                             TransportationMode::Ship),
+            std::invalid_argument);
+    }
+
+    void test_concurrent_identical_top_path_queries_agree()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 1800.0, 25.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C")),
+                         makeRoute(QStringLiteral("AC"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("C"))});
+
+        QList<QStringList> uids(8);
+        QList<QThread *>   threads;
+        for (int i = 0; i < uids.size(); ++i)
+        {
+            threads.append(QThread::create([&graph, &uids, i]() {
+                for (const Path &path : graph.findTopNShortestPaths(
+                         QStringLiteral("A"), QStringLiteral("C"), 3,
+                         TransportationMode::Any))
+                {
+                    uids[i].append(path.pathUid);
+                }
+            }));
+        }
+        for (QThread *thread : threads)
+        {
+            thread->start();
+        }
+        for (QThread *thread : threads)
+        {
+            QVERIFY(thread->wait(30000));
+            delete thread;
+        }
+
+        QStringList expected;
+        for (const Path &path : graph.findTopNShortestPaths(
+                 QStringLiteral("A"), QStringLiteral("C"), 3,
+                 TransportationMode::Any))
+        {
+            expected.append(path.pathUid);
+        }
+        QCOMPARE(expected.size(), 2);
+        for (const QStringList &result : uids)
+        {
+            QCOMPARE(result, expected);
+        }
+    }
+
+    void test_hot_top_path_queries_are_warmed_after_changes()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 1800.0, 25.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C"))});
+
+        // A-C is hot, B-C is asked once
+        QCOMPARE(graph.findTopNShortestPaths(QStringLiteral("A"),
+                                             QStringLiteral("C"), 3)
+                     .size(),
+                 1);
+        QCOMPARE(graph.findTopNShortestPaths(QStringLiteral("A"),
+                                             QStringLiteral("C"), 3)
+                     .size(),
+                 1);
+        graph.findTopNShortestPaths(QStringLiteral("B"), QStringLiteral("C"),
+                                    3);
+        QVariantMap stats = graph.getPathCacheStatistics();
+        QCOMPARE(stats.value(QStringLiteral("hits")).toULongLong(), 1ULL);
+        QCOMPARE(stats.value(QStringLiteral("misses")).toULongLong(), 2ULL);
+
+        graph.addRoutes({makeRoute(QStringLiteral("AC"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("C"))});
+        QVERIFY(graph.waitForHotRoutePrecompute(30000));
+        stats = graph.getPathCacheStatistics();
+        QCOMPARE(stats.value(QStringLiteral("precomputed")).toULongLong(),
+                 1ULL);
+        QCOMPARE(stats.value(QStringLiteral("cached_queries")).toInt(), 1);
+
+        // The first client query after the change is served warm
+        QCOMPARE(graph.findTopNShortestPaths(QStringLiteral("A"),
+                                             QStringLiteral("C"), 3)
+                     .size(),
+                 2);
+        stats = graph.getPathCacheStatistics();
+        QCOMPARE(stats.value(QStringLiteral("hits")).toULongLong(), 2ULL);
+        QCOMPARE(stats.value(QStringLiteral("misses")).toULongLong(), 2ULL);
+
+        graph.setHotRoutePrecomputeCount(0);
+        QVERIFY_EXCEPTION_THROWN(graph.setHotRoutePrecomputeCount(-1),
+                                 std::invalid_argument);
+    }
+
+    void test_closures_evict_only_cached_paths_that_use_them()
+    {
+        TerminalGraph graph;
+        graph.setHotRoutePrecomputeCount(0);
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("D"), 0.0, 0.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("CD"),
+                                   QStringLiteral("C"),
+                                   QStringLiteral("D"))});
+
+        graph.findTopNShortestPaths(QStringLiteral("A"), QStringLiteral("B"),
+                                    2);
+        graph.findTopNShortestPaths(QStringLiteral("C"), QStringLiteral("D"),
+                                    2);
+        QCOMPARE(graph.getPathCacheStatistics()
+                     .value(QStringLiteral("cached_queries"))
+                     .toInt(),
+                 2);
+
+        // A windowed closure never reaches cached searches
+        const QString windowed =
+            graph.closeTerminal(QStringLiteral("C"), 0.0, 100.0);
+        QCOMPARE(graph.getPathCacheStatistics()
+                     .value(QStringLiteral("cached_queries"))
+                     .toInt(),
+                 2);
+
+        // Closing C-D evicts only the query whose path uses it
+        const QString routeClosure = graph.closeRoute(
+            QStringLiteral("D"), QStringLiteral("C"),
+            TransportationMode::Train);
+        QCOMPARE(graph.getPathCacheStatistics()
+                     .value(QStringLiteral("cached_queries"))
+                     .toInt(),
+                 1);
+        graph.findTopNShortestPaths(QStringLiteral("A"), QStringLiteral("B"),
+                                    2);
+        QCOMPARE(graph.getPathCacheStatistics()
+                     .value(QStringLiteral("hits"))
+                     .toULongLong(),
+                 1ULL);
+        QVERIFY(graph.findTopNShortestPaths(QStringLiteral("C"),
+                                            QStringLiteral("D"), 2)
+                    .isEmpty());
+
+        // Reopening may improve any query
+        QVERIFY(graph.reopen(routeClosure));
+        QCOMPARE(graph.getPathCacheStatistics()
+                     .value(QStringLiteral("cached_queries"))
+                     .toInt(),
+                 0);
+        QCOMPARE(graph.findTopNShortestPaths(QStringLiteral("C"),
+                                             QStringLiteral("D"), 2)
+                     .size(),
+                 1);
+        QVERIFY(graph.reopen(windowed));
+    }
+
+    void test_cost_sweep_ranks_without_touching_live_weights()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+
+        // The direct route is cheap but dirty
+        QVariantMap direct = makeRoute(QStringLiteral("AC"), QStringLiteral("A"),
+                                       QStringLiteral("C"));
+        QVariantMap directAttributes =
+            direct.value(QStringLiteral("attributes")).toMap();
+        directAttributes[QStringLiteral("cost")]            = 1.0;
+        directAttributes[QStringLiteral("carbonEmissions")] = 30.0;
+        direct[QStringLiteral("attributes")] = directAttributes;
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C")),
+                         direct});
+
+        const QString train =
+            QString::number(static_cast<int>(TransportationMode::Train));
+        const QList<QVariantMap> weightSets{
+            QVariantMap{},
+            QVariantMap{{train,
+                         QVariantMap{{QStringLiteral("carbonEmissions"), 0.0}}}}};
+        const QList<RouteQuery> queries{
+            {QStringLiteral("A"), QStringLiteral("C")},
+            {QStringLiteral("A"), QStringLiteral("Z")}};
+
+        const QList<QList<QList<Path>>> sweep =
+            graph.sweepTopNShortestPaths(weightSets, queries, 2);
+        QCOMPARE(sweep.size(), 2);
+        QCOMPARE(sweep[0][0].size(), 2);
+        QCOMPARE(sweep[0][0].first().segments.size(), 2);
+        QCOMPARE(sweep[1][0].first().segments.size(), 1);
+        QVERIFY(sweep[0][1].isEmpty());
+        QVERIFY(sweep[1][1].isEmpty());
+
+        // Paths are priced with their own weights
+        const QList<Path> live = graph.findTopNShortestPaths(
+            QStringLiteral("A"), QStringLiteral("C"), 2);
+        QCOMPARE(live.first().segments.size(), 2);
+        QVERIFY(nearlyEqual(sweep[0][0].first().rankingCost,
+                            live.first().rankingCost));
+        QVERIFY(sweep[1][0].first().rankingCost < live.last().rankingCost);
+
+        QVERIFY_EXCEPTION_THROWN(
+            graph.sweepTopNShortestPaths(
+                {QVariantMap{{QStringLiteral("9"), QVariantMap{}}}}, queries),
+            std::invalid_argument);
+        QVERIFY_EXCEPTION_THROWN(
+            graph.sweepTopNShortestPaths(
+                {QVariantMap{{QStringLiteral("default"),
+                              QVariantMap{{QStringLiteral("bogus"), 1.0}}}}},
+                queries),
+            std::invalid_argument);
+    }
+
+    void test_handling_replications_summarize_independent_draws()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 3600.0, 25.0));
+
+        const QList<HandlingEvent> schedule{
+            {QStringLiteral("A"), 0.0, false, 900, TransportationMode::Train},
+            {QStringLiteral("A"), 10.0, true, 400, TransportationMode::Any},
+            {QStringLiteral("A"), 20.0, false, 600, TransportationMode::Train}};
+
+        const QVariantMap result = graph.replicateHandling(schedule, 200, 7);
+        QCOMPARE(result.value(QStringLiteral("replications")).toInt(), 200);
+        const QVariantMap terminal =
+            result.value(QStringLiteral("terminals"))
+                .toMap()
+                .value(QStringLiteral("A"))
+                .toMap();
+
+        // 900 + 500 fit after the pickup, 100 exceed the capacity of 1000
+        QVERIFY(nearlyEqual(
+            terminal.value(QStringLiteral("containers")).toDouble(), 1400.0));
+        QVERIFY(nearlyEqual(
+            terminal.value(QStringLiteral("rejected")).toDouble(), 100.0));
+
+        const QVariantMap cost =
+            terminal.value(QStringLiteral("cost_usd")).toMap();
+        QVERIFY(nearlyEqual(cost.value(QStringLiteral("mean")).toDouble(),
+                            1400.0 * 25.0));
+        QVERIFY(nearlyEqual(cost.value(QStringLiteral("std_dev")).toDouble(),
+                            0.0));
+
+        // Each replication averages 1400 exponential draws with mean 3600
+        const QVariantMap dwell =
+            terminal.value(QStringLiteral("yard_dwell_seconds")).toMap();
+        QVERIFY(qAbs(dwell.value(QStringLiteral("mean")).toDouble() - 3600.0)
+                < 100.0);
+        QVERIFY(dwell.value(QStringLiteral("std_dev")).toDouble() > 0.0);
+        QVERIFY(dwell.value(QStringLiteral("p05")).toDouble()
+                < dwell.value(QStringLiteral("p95")).toDouble());
+
+        QCOMPARE(graph.replicateHandling(schedule, 200, 7), result);
+        QVERIFY(graph.replicateHandling(schedule, 200, 8) != result);
+        QCOMPARE(graph.getTerminal(QStringLiteral("A"))->getContainerCount(),
+                 0);
+
+        QVERIFY_EXCEPTION_THROWN(graph.replicateHandling(schedule, 0, 7),
+                                 std::invalid_argument);
+        QVERIFY_EXCEPTION_THROWN(
+            graph.replicateHandling({{QStringLiteral("Z"), 0.0, false, 1,
+                                      TransportationMode::Train}},
+                                    10, 7),
+            std::invalid_argument);
+    }
+
+    void test_path_distribution_samples_handling_stops()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 3600.0, 10.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 3600.0, 25.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C"))});
+
+        const QList<PathLeg> legs{
+            {QStringLiteral("A"), QStringLiteral("B"), TransportationMode::Train},
+            {QStringLiteral("B"), QStringLiteral("C"), TransportationMode::Train}};
+
+        // Same-mode continuation at B skips its handling
+        const QVariantMap skipped =
+            graph.evaluatePathDistribution({legs}, 20000, 3, true)
+                .value(0)
+                .toMap();
+        QCOMPARE(skipped.value(QStringLiteral("stops")).toList().size(), 1);
+        QVERIFY(nearlyEqual(
+            skipped.value(QStringLiteral("travel_time_seconds")).toDouble(),
+            10.0));
+        const QVariantMap handling =
+            skipped.value(QStringLiteral("handling_seconds")).toMap();
+        QVERIFY(qAbs(handling.value(QStringLiteral("mean")).toDouble() - 3600.0)
+                < 150.0);
+        QVERIFY(nearlyEqual(
+            skipped.value(QStringLiteral("door_to_door_seconds"))
+                .toMap()
+                .value(QStringLiteral("p50"))
+                .toDouble(),
+            handling.value(QStringLiteral("p50")).toDouble() + 10.0));
+        QVERIFY(nearlyEqual(skipped.value(QStringLiteral("cost_usd"))
+                                .toMap()
+                                .value(QStringLiteral("mean"))
+                                .toDouble(),
+                            25.0));
+
+        const QVariantMap handled =
+            graph.evaluatePathDistribution({legs}, 20000, 3, false, {50.0, 99.0})
+                .value(0)
+                .toMap();
+        QCOMPARE(handled.value(QStringLiteral("stops")).toList().size(), 2);
+        const QVariantMap both =
+            handled.value(QStringLiteral("handling_seconds")).toMap();
+        QVERIFY(qAbs(both.value(QStringLiteral("mean")).toDouble() - 7200.0)
+                < 300.0);
+        QVERIFY(both.value(QStringLiteral("p99")).toDouble()
+                > both.value(QStringLiteral("p50")).toDouble());
+        QVERIFY(!both.contains(QStringLiteral("p95")));
+
+        QCOMPARE(graph.evaluatePathDistribution({legs}, 5000, 9),
+                 graph.evaluatePathDistribution({legs}, 5000, 9));
+        QVERIFY_EXCEPTION_THROWN(
+            graph.evaluatePathDistribution(
+                {{legs[1], legs[0]}}, 100, 9),
+            std::invalid_argument);
+        QVERIFY_EXCEPTION_THROWN(
+            graph.evaluatePathDistribution(
+                {{{QStringLiteral("A"), QStringLiteral("C"),
+                   TransportationMode::Train}}},
+                100, 9),
+            std::invalid_argument);
+    }
+
+    void test_forked_scenario_diverges_from_its_source()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C"))});
+        const double viaB =
+            *graph.getDistance(QStringLiteral("A"), QStringLiteral("C"));
+
+        std::unique_ptr<TerminalGraph> scenario(graph.fork());
+        QCOMPARE(scenario->getTerminalCount(), 3);
+        QCOMPARE(scenario->topologyGeneration(), graph.topologyGeneration());
+        QVERIFY(scenario->getTerminal(QStringLiteral("B"))
+                != graph.getTerminal(QStringLiteral("B")));
+        QVERIFY(nearlyEqual(
+            *scenario->getDistance(QStringLiteral("A"), QStringLiteral("C")),
+            viaB));
+
+        // Changes on either side stay on that side
+        scenario->closeTerminal(QStringLiteral("B"));
+        QVERIFY(!scenario->getDistance(QStringLiteral("A"),
+                                       QStringLiteral("C"))
+                     .has_value());
+        QVERIFY(graph.getClosures().isEmpty());
+        QVERIFY(nearlyEqual(
+            *graph.getDistance(QStringLiteral("A"), QStringLiteral("C")),
+            viaB));
+
+        QVERIFY(graph.removeTerminal(QStringLiteral("C")));
+        QCOMPARE(scenario->getTerminalCount(), 3);
+        QVERIFY(scenario->terminalExists(QStringLiteral("C")));
+
+        // Forks of forks start from the branch, not the base network
+        std::unique_ptr<TerminalGraph> nested(scenario->fork());
+        QCOMPARE(nested->getClosures().size(), 1);
+        QVERIFY(nested->terminalExists(QStringLiteral("C")));
+        scenario.reset();
+        QVERIFY(!nested->getDistance(QStringLiteral("A"),
+                                     QStringLiteral("C"))
+                     .has_value());
+        QCOMPARE(nested->getTerminal(QStringLiteral("A"))->getContainerCount(),
+                 0);
+    }
+
+    void test_batch_path_search_matches_single_queries()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 1800.0, 25.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C"))});
+
+        const QList<QList<Path>> batch = graph.findTopNShortestPathsBatch(
+            {RouteQuery{QStringLiteral("A"), QStringLiteral("C")},
+             RouteQuery{QStringLiteral("B"), QStringLiteral("C")},
+             RouteQuery{QStringLiteral("A"), QStringLiteral("C")},
+             RouteQuery{QStringLiteral("A"), QStringLiteral("C"),
+                        TransportationMode::Ship},
+             RouteQuery{QStringLiteral("A"), QStringLiteral("X")}},
+            2);
+        QCOMPARE(batch.size(), 5);
+        QVariantMap stats = graph.getPathCacheStatistics();
+        QCOMPARE(stats.value(QStringLiteral("misses")).toULongLong(), 3ULL);
+        QCOMPARE(stats.value(QStringLiteral("cached_queries")).toInt(), 3);
+
+        // Single queries and repeated batches are served from the same cache
+        const QList<Path> single = graph.findTopNShortestPaths(
+            QStringLiteral("A"), QStringLiteral("C"), 2,
+            TransportationMode::Any);
+        graph.findTopNShortestPathsBatch(
+            {RouteQuery{QStringLiteral("B"), QStringLiteral("C")}}, 2);
+        stats = graph.getPathCacheStatistics();
+        QCOMPARE(stats.value(QStringLiteral("hits")).toULongLong(), 2ULL);
+        QCOMPARE(stats.value(QStringLiteral("misses")).toULongLong(), 3ULL);
+        QCOMPARE(batch[0].size(), single.size());
+        QCOMPARE(batch[0].first().pathUid, single.first().pathUid);
+        QCOMPARE(batch[2].first().pathUid, batch[0].first().pathUid);
+        QCOMPARE(batch[1].first().segments.size(), 1);
+        QVERIFY(batch[3].isEmpty());
+        QVERIFY(batch[4].isEmpty());
+    }
+
+    void test_constrained_path_enforces_limits_during_search()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+
+        QVariantMap direct = makeRoute(QStringLiteral("AC"),
+                                       QStringLiteral("A"),
+                                       QStringLiteral("C"));
+        QVariantMap directAttributes =
+            direct.value(QStringLiteral("attributes")).toMap();
+        directAttributes[QStringLiteral("cost")]       = 100.0;
+        directAttributes[QStringLiteral("travelTime")] = 30.0;
+        direct[QStringLiteral("attributes")]           = directAttributes;
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C")),
+                         direct});
+
+        const std::optional<Path> unconstrained =
+            graph.findConstrainedShortestPath(QStringLiteral("A"),
+                                              QStringLiteral("C"));
+        QVERIFY(unconstrained.has_value());
+        QCOMPARE(unconstrained->segments.size(), 2);
+
+        const std::optional<Path> oneHop = graph.findConstrainedShortestPath(
+            QStringLiteral("A"), QStringLiteral("C"), TransportationMode::Any,
+            1);
+        QVERIFY(oneHop.has_value());
+        QCOMPARE(oneHop->segments.size(), 1);
+        QVERIFY(oneHop->totalPathCost > unconstrained->totalPathCost);
+
+        const std::optional<Path> fast = graph.findConstrainedShortestPath(
+            QStringLiteral("A"), QStringLiteral("C"), TransportationMode::Any,
+            std::nullopt, std::nullopt, 10.0);
+        QVERIFY(fast.has_value());
+        QCOMPARE(fast->segments.size(), 2);
+
+        QVERIFY(!graph.findConstrainedShortestPath(
+                         QStringLiteral("A"), QStringLiteral("C"),
+                         TransportationMode::Any, 1, std::nullopt, 10.0)
+                     .has_value());
+        QVERIFY_EXCEPTION_THROWN(
+            graph.findConstrainedShortestPath(QStringLiteral("A"),
+                                              QStringLiteral("C"),
+                                              TransportationMode::Any, -1),
+            std::invalid_argument);
+    }
+
+    void test_constrained_path_on_grid_with_only_a_transfer_limit()
+    {
+        // Rows run by train and columns by ship, with travel times that do
+        // not follow cost. Only the transfer limit may prune here.
+        constexpr int      size = 12;
+        TerminalGraph      graph;
+        QList<QVariantMap> terminals;
+        QList<QVariantMap> routes;
+        auto name = [](int row, int column) {
+            return QStringLiteral("G%1_%2").arg(row).arg(column);
+        };
+        for (int row = 0; row < size; ++row)
+        {
+            for (int column = 0; column < size; ++column)
+            {
+                terminals.append(makeTerminal(name(row, column), 0.0, 0.0));
+                for (int step = 0; step < 2; ++step)
+                {
+                    const int nextRow    = row + step;
+                    const int nextColumn = column + 1 - step;
+                    if (nextRow >= size || nextColumn >= size)
+                        continue;
+
+                    const QString routeId =
+                        QStringLiteral("R%1_%2_%3").arg(row).arg(column).arg(step);
+                    QVariantMap route = makeRoute(routeId, name(row, column),
+                                                  name(nextRow, nextColumn));
+                    route[QStringLiteral("mode")] = static_cast<int>(
+                        step == 0 ? TransportationMode::Train
+                                  : TransportationMode::Ship);
+                    QVariantMap attributes =
+                        route.value(QStringLiteral("attributes")).toMap();
+                    attributes[QStringLiteral("travelTime")] =
+                        1.0 + (row * 7 + column * 3 + step) % 11;
+                    route[QStringLiteral("attributes")] = attributes;
+                    routes.append(route);
+                }
+            }
+        }
+        graph.addTerminals(terminals);
+        graph.addRoutes(routes);
+
+        const QString corner = name(size - 1, size - 1);
+        QVERIFY(!graph.findConstrainedShortestPath(name(0, 0), corner,
+                                                   TransportationMode::Any,
+                                                   std::nullopt, 0)
+                     .has_value());
+
+        const std::optional<Path> oneTransfer =
+            graph.findConstrainedShortestPath(name(0, 0), corner,
+                                              TransportationMode::Any,
+                                              std::nullopt, 1);
+        QVERIFY(oneTransfer.has_value());
+        QCOMPARE(oneTransfer->segments.size(), 2 * (size - 1));
+        int transfers = 0;
+        for (int i = 1; i < oneTransfer->segments.size(); ++i)
+        {
+            if (oneTransfer->segments[i].mode
+                != oneTransfer->segments[i - 1].mode)
+                ++transfers;
+        }
+        QCOMPARE(transfers, 1);
+    }
+
+    void test_reachable_terminals_stop_at_budget()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("B"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("D"), 0.0, 0.0));
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C"))});
+
+        // Each route takes 5 time units; D is not connected
+        QList<QPair<QString, double>> reachable =
+            graph.findReachableTerminals(
+                QStringLiteral("A"), 5.0,
+                TerminalGraph::ReachabilityMetric::TravelTime);
+        QCOMPARE(reachable.size(), 1);
+        QCOMPARE(reachable.first().first, QStringLiteral("B"));
+
+        reachable = graph.findReachableTerminals(
+            QStringLiteral("A"), 100.0,
+            TerminalGraph::ReachabilityMetric::TravelTime);
+        QCOMPARE(reachable.size(), 2);
+        QCOMPARE(reachable.last().first, QStringLiteral("C"));
+        QVERIFY(nearlyEqual(reachable.last().second, 10.0));
+
+        // Cost budgets agree with getDistance()
+        const double toC =
+            *graph.getDistance(QStringLiteral("A"), QStringLiteral("C"));
+        QCOMPARE(graph.findReachableTerminals(QStringLiteral("A"), toC).size(),
+                 2);
+        QCOMPARE(graph.findReachableTerminals(QStringLiteral("A"),
+                                              toC * 0.99)
+                     .size(),
+                 1);
+        QVERIFY(graph.findReachableTerminals(QStringLiteral("A"), toC,
+                                             TerminalGraph::ReachabilityMetric::Cost,
+                                             TransportationMode::Ship)
+                    .isEmpty());
+
+        graph.closeTerminal(QStringLiteral("B"));
+        QVERIFY(graph.findReachableTerminals(QStringLiteral("A"), toC)
+                    .isEmpty());
+        QVERIFY_EXCEPTION_THROWN(
+            graph.findReachableTerminals(QStringLiteral("A"), -1.0),
+            std::invalid_argument);
+    }
+
+    void test_searches_outgrowing_their_arena_stay_exact()
+    {
+        // A 400-terminal chain needs far more bookkeeping than a search
+        // arena holds inline, so every search spills to the heap
+        TerminalGraph      graph;
+        QList<QVariantMap> terminals;
+        QList<QVariantMap> routes;
+        for (int i = 0; i < 400; ++i)
+        {
+            terminals.append(
+                makeTerminal(QStringLiteral("C%1").arg(i), 0.0, 0.0));
+            if (i > 0)
+                routes.append(makeRoute(QStringLiteral("R%1").arg(i),
+                                        QStringLiteral("C%1").arg(i - 1),
+                                        QStringLiteral("C%1").arg(i)));
+        }
+        graph.addTerminals(terminals);
+        graph.addRoutes(routes);
+
+        const QList<QPair<QString, double>> reachable =
+            graph.findReachableTerminals(
+                QStringLiteral("C0"), 1.0e9,
+                TerminalGraph::ReachabilityMetric::TravelTime);
+        QCOMPARE(reachable.size(), 399);
+        QCOMPARE(reachable.last().first, QStringLiteral("C399"));
+        QVERIFY(nearlyEqual(reachable.last().second, 399 * 5.0));
+
+        const double toEnd =
+            *graph.getDistance(QStringLiteral("C0"), QStringLiteral("C399"));
+        QCOMPARE(graph.findReachableTerminals(QStringLiteral("C0"), toEnd)
+                     .size(),
+                 399);
+        QCOMPARE(graph.findShortestPath(QStringLiteral("C0"),
+                                        QStringLiteral("C399"))
+                     .size(),
+                 399);
+    }
+
+    void test_traffic_assignment_spreads_flow_around_congested_terminal()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminal(QStringLiteral("A"), 0.0, 0.0));
+        graph.addTerminal(makeTerminal(QStringLiteral("C"), 0.0, 0.0));
+
+        // B handles one TEU per hour and congests quickly
+        QVariantMap hub = makeTerminal(QStringLiteral("B"), 10.0, 0.0);
+        QVariantMap hubConfig =
+            hub.value(QStringLiteral("custom_config")).toMap();
+        hubConfig[QStringLiteral("system_dynamics")] = QVariantMap{
+            {QStringLiteral("enabled"), true},
+            {QStringLiteral("max_service_rate"), 1.0}};
+        hub[QStringLiteral("custom_config")] = hubConfig;
+        graph.addTerminal(hub);
+
+        QVariantMap direct = makeRoute(QStringLiteral("AC"),
+                                       QStringLiteral("A"),
+                                       QStringLiteral("C"));
+        QVariantMap directAttributes =
+            direct.value(QStringLiteral("attributes")).toMap();
+        directAttributes[QStringLiteral("cost")] = 1000.0;
+        direct[QStringLiteral("attributes")]     = directAttributes;
+        graph.addRoutes({makeRoute(QStringLiteral("AB"),
+                                   QStringLiteral("A"),
+                                   QStringLiteral("B")),
+                         makeRoute(QStringLiteral("BC"),
+                                   QStringLiteral("B"),
+                                   QStringLiteral("C")),
+                         direct});
+
+        // A single TEU takes the cheaper route through B
+        QVariantMap light = graph.assignTraffic(
+            {FlowDemand{QStringLiteral("A"), QStringLiteral("C"), 1.0}});
+        QVERIFY(light.value(QStringLiteral("converged")).toBool());
+        QVariantList paths = light.value(QStringLiteral("demands"))
+                                 .toList()
+                                 .first()
+                                 .toMap()
+                                 .value(QStringLiteral("paths"))
+                                 .toList();
+        QCOMPARE(paths.size(), 1);
+        QCOMPARE(paths.first()
+                     .toMap()
+                     .value(QStringLiteral("terminals"))
+                     .toList()
+                     .size(),
+                 3);
+
+        // Heavy demand splits until both routes cost the same
+        QVariantMap heavy = graph.assignTraffic(
+            {FlowDemand{QStringLiteral("A"), QStringLiteral("C"), 1000.0}},
+            TransportationMode::Any, 24.0, 200, 1e-6);
+        QVERIFY(heavy.value(QStringLiteral("converged")).toBool());
+        paths = heavy.value(QStringLiteral("demands"))
+                    .toList()
+                    .first()
+                    .toMap()
+                    .value(QStringLiteral("paths"))
+                    .toList();
+        QCOMPARE(paths.size(), 2);
+
+        double totalFlow = 0.0;
+        for (const QVariant &path : paths)
+        {
+            totalFlow += path.toMap().value(QStringLiteral("flow")).toDouble();
+        }
+        QVERIFY(nearlyEqual(totalFlow, 1000.0));
+        const double firstCost =
+            paths[0].toMap().value(QStringLiteral("cost")).toDouble();
+        const double secondCost =
+            paths[1].toMap().value(QStringLiteral("cost")).toDouble();
+        QVERIFY(qAbs(firstCost - secondCost) < 1e-3 * firstCost);
+
+        QVERIFY_EXCEPTION_THROWN(
+            graph.assignTraffic(
+                {FlowDemand{QStringLiteral("A"), QStringLiteral("X"), 1.0}}),
+            std::invalid_argument);
+    }
+
     void test_strict_enum_parsing_rejects_invalid_values()
     {
         QCOMPARE(EnumUtils::stringToTransportationMode(QStringLiteral("2")),
@@ -387,6 +1516,109 @@ private slots:
             EnumUtils::stringToTerminalInterface(QStringLiteral("RAIL_SIDE")),
             std::invalid_argument);
     }
+
+    void test_edge_hash_and_alias_reuse()
+    {
+        // Reversed and self edges no longer cancel out in the hash
+        const EdgeIdentifier forward(QStringLiteral("A"), QStringLiteral("B"),
+                                     TransportationMode::Truck);
+        const EdgeIdentifier backward(QStringLiteral("B"), QStringLiteral("A"),
+                                      TransportationMode::Truck);
+        QVERIFY(qHash(forward) != qHash(backward));
+        QVERIFY(qHash(EdgeIdentifier(QStringLiteral("A"), QStringLiteral("A"),
+                                     TransportationMode::Truck))
+                != qHash(EdgeIdentifier(QStringLiteral("B"),
+                                        QStringLiteral("B"),
+                                        TransportationMode::Truck)));
+
+        // Aliases of a removed terminal can be reused by a new one
+        TerminalGraph graph;
+        QVariantMap first = makeTerminal(QStringLiteral("X"), 60.0, 1.0);
+        first[QStringLiteral("terminal_names")] =
+            QStringList{QStringLiteral("X"), QStringLiteral("shared")};
+        graph.addTerminal(first);
+        QCOMPARE(graph.getTerminal(QStringLiteral("shared"))->getTerminalName(),
+                 QStringLiteral("X"));
+        QVERIFY(graph.removeTerminal(QStringLiteral("X")));
+        QVariantMap second = makeTerminal(QStringLiteral("Y"), 60.0, 1.0);
+        second[QStringLiteral("terminal_names")] =
+            QStringList{QStringLiteral("Y"), QStringLiteral("shared")};
+        graph.addTerminal(second);
+        QCOMPARE(graph.getTerminal(QStringLiteral("shared"))->getTerminalName(),
+                 QStringLiteral("Y"));
+        QVERIFY_EXCEPTION_THROWN(graph.getTerminal(QStringLiteral("X")),
+                                 std::invalid_argument);
+    }
+
+    void test_parallel_top_paths_match_a_single_worker()
+    {
+        // A 4x4 grid has many near-tied detours, so spur candidates merged
+        // out of order would change the ranking
+        const auto buildGrid = [](TerminalGraph &graph) {
+            QList<QVariantMap> terminals;
+            QList<QVariantMap> routes;
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int col = 0; col < 4; ++col)
+                {
+                    const QString id = QStringLiteral("G%1%2").arg(row).arg(col);
+                    terminals.append(
+                        makeTerminal(id, 600.0 * ((row + col) % 3), row + col));
+                    if (col > 0)
+                        routes.append(makeRoute(
+                            id + QStringLiteral("W"),
+                            QStringLiteral("G%1%2").arg(row).arg(col - 1), id));
+                    if (row > 0)
+                        routes.append(makeRoute(
+                            id + QStringLiteral("N"),
+                            QStringLiteral("G%1%2").arg(row - 1).arg(col), id));
+                }
+            }
+            graph.addTerminals(terminals);
+            graph.addRoutes(routes);
+        };
+
+        WorkStealingPool serialPool(1);
+        WorkStealingPool parallelPool(4);
+        TerminalGraph    serial;
+        TerminalGraph    parallel;
+        serial.setTaskPool(&serialPool);
+        parallel.setTaskPool(&parallelPool);
+        buildGrid(serial);
+        buildGrid(parallel);
+
+        // Terminals built on the pool are all registered
+        QCOMPARE(parallel.getTerminalCount(), 16);
+        QCOMPARE(parallel.getAllTerminalNames(), serial.getAllTerminalNames());
+
+        const QList<Path> expected = serial.findTopNShortestPaths(
+            QStringLiteral("G00"), QStringLiteral("G33"), 12);
+        const QList<Path> actual = parallel.findTopNShortestPaths(
+            QStringLiteral("G00"), QStringLiteral("G33"), 12);
+        QCOMPARE(expected.size(), 12);
+        QCOMPARE(actual.size(), expected.size());
+        for (int i = 0; i < expected.size(); ++i)
+        {
+            QCOMPARE(actual[i].pathUid, expected[i].pathUid);
+            QVERIFY(nearlyEqual(actual[i].totalPathCost,
+                                expected[i].totalPathCost));
+        }
+
+        // Nested loops share the workers, and a task's exception reaches
+        // the caller once the rest have finished
+        std::atomic<int> visited{0};
+        parallelPool.parallelFor(8, [&](size_t) {
+            parallelPool.parallelFor(8, [&](size_t) { ++visited; });
+        });
+        QCOMPARE(visited.load(), 64);
+        QVERIFY_EXCEPTION_THROWN(
+            parallelPool.parallelFor(100,
+                                     [](size_t i) {
+                                         if (i == 42)
+                                             throw std::runtime_error("task");
+                                     }),
+            std::runtime_error);
+    }
 };
 
 QTEST_MAIN(PathFoundContractTest)
@@ -1,12 +1,19 @@
+#include <QDeadlineTimer>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QSet>
 #include <QTest>
 #include <QVariantList>
 #include <QVariantMap>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include <containerLib/container.h>
 
+#include "api/terminal_sim_engine.h"
 #include "server/command_processor.h"
+#include "server/shard_ring.h"
 #include "terminal/terminal_graph.h"
 
 using namespace TerminalSim;
@@ -1024,6 +1031,626 @@ private slots:
         QCOMPARE(state.value(QStringLiteral("departures_this_step")).toInt(),
                  0);
     }
+
+    void test_runtime_reset_is_an_epoch_bump_seen_on_next_access()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminalSpec(QStringLiteral("T1")));
+        graph.addTerminal(makeTerminalSpec(QStringLiteral("T2")));
+
+        auto *first  = graph.getTerminal(QStringLiteral("T1"));
+        auto *second = graph.getTerminal(QStringLiteral("T2"));
+        first->addContainers({makeContainer(QStringLiteral("a")),
+                              makeContainer(QStringLiteral("b"))},
+                             -1.0, TransportationMode::Truck);
+        second->addContainers({makeContainer(QStringLiteral("c"))}, -1.0,
+                              TransportationMode::Truck);
+
+        // A fork keeps its own epoch, so resetting the source leaves it be
+        std::unique_ptr<TerminalGraph> scenario(graph.fork());
+
+        QCOMPARE(graph.resetRuntimeState(), 2);
+        QCOMPARE(first->getContainerCount(), 0);
+        QCOMPARE(second->getContainerCount(), 0);
+        QCOMPARE(scenario->getTerminal(QStringLiteral("T1"))
+                     ->getContainerCount(),
+                 2);
+
+        // State added after the bump belongs to the new run
+        first->addContainers({makeContainer(QStringLiteral("d"))}, -1.0,
+                             TransportationMode::Truck);
+        QCOMPARE(first->getContainerCount(), 1);
+        QCOMPARE(graph.resetRuntimeState({QStringLiteral("T2")}), 1);
+        QCOMPARE(first->getContainerCount(), 1);
+
+        QCOMPARE(scenario->resetRuntimeState(), 2);
+        QCOMPARE(scenario->getTerminal(QStringLiteral("T1"))
+                     ->getContainerCount(),
+                 0);
+        QCOMPARE(first->getContainerCount(), 1);
+    }
+
+    void test_inventory_counts_are_readable_while_containers_arrive()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminalSpec(QStringLiteral("T1"), 100, 3600.0,
+                                           5.0, false));
+        auto *terminal = graph.getTerminal(QStringLiteral("T1"));
+        QCOMPARE(terminal->getContainerCount(), 0);
+        QCOMPARE(terminal->getAvailableCapacity(), 100);
+
+        // Counts move one arrival at a time and always add up to capacity
+        std::thread writer([terminal]() {
+            for (int i = 0; i < 40; ++i)
+            {
+                terminal->addContainers(
+                    {makeContainer(QStringLiteral("c%1").arg(i))}, -1.0,
+                    TransportationMode::Truck);
+            }
+        });
+        int                  lastCount  = 0;
+        bool                 monotonic  = true;
+        bool                 consistent = true;
+        const QDeadlineTimer deadline(30000);
+        while (lastCount < 40 && !deadline.hasExpired())
+        {
+            const QVariantMap status =
+                graph.getTerminalStatus(QStringLiteral("T1"));
+            const int count = status.value("container_count").toInt();
+            monotonic  = monotonic && count >= lastCount;
+            consistent = consistent
+                         && count + status.value("available_capacity").toInt()
+                                == status.value("max_capacity").toInt();
+            lastCount = qMax(lastCount, count);
+        }
+        writer.join();
+        QCOMPARE(lastCount, 40);
+        QVERIFY(monotonic);
+        QVERIFY(consistent);
+        QVERIFY(!terminal->checkCapacityStatus(61).first);
+
+        ContainerCore::ContainerSelectionCriteria criteria;
+        criteria.limit = 15;
+        QCOMPARE(terminal->dequeueContainers(criteria).size(), 15);
+        QCOMPARE(terminal->getContainerCount(), 25);
+        QCOMPARE(terminal->getAvailableCapacity(), 75);
+
+        // A pending epoch reset reads as empty before anything syncs
+        QCOMPARE(graph.resetRuntimeState(), 1);
+        QCOMPARE(terminal->getContainerCount(), 0);
+        QCOMPARE(terminal->getAvailableCapacity(), 100);
+        QCOMPARE(terminal->getMaxCapacity(), 100);
+    }
+
+    void test_system_dynamics_reads_never_see_a_partial_update()
+    {
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminalSpec(QStringLiteral("T1"), 100));
+        auto *terminal = graph.getTerminal(QStringLiteral("T1"));
+
+        // Every update keeps delta_t five seconds ahead of the update time,
+        // so a torn copy of the state would break the pairing
+        std::thread writer([terminal]() {
+            for (int step = 1; step <= 2000; ++step)
+            {
+                terminal->updateSystemDynamics(step * 10.0, step * 10.0 + 5.0);
+                if (step % 100 == 0)
+                {
+                    terminal->addContainers(
+                        {makeContainer(QStringLiteral("c%1").arg(step))}, -1.0,
+                        TransportationMode::Truck);
+                }
+            }
+        });
+        std::vector<std::thread> readers;
+        std::vector<int>         torn(4, 0);
+        for (int r = 0; r < 4; ++r)
+        {
+            readers.emplace_back([terminal, &torn, r]() {
+                double last = 0.0;
+                while (last < 20000.0)
+                {
+                    const SystemDynamicsState state =
+                        terminal->systemDynamicsState();
+                    if (state.lastUpdateTime > 0.0
+                        && state.deltaT != state.lastUpdateTime + 5.0)
+                        ++torn[r];
+                    const QJsonObject snapshot =
+                        terminal->getRuntimeTerminalSnapshot();
+                    if (snapshot.value("terminal_id").toString()
+                        != QStringLiteral("T1"))
+                        ++torn[r];
+                    last = state.lastUpdateTime;
+                }
+            });
+        }
+        writer.join();
+        for (auto &reader : readers)
+            reader.join();
+        int tornReads = 0;
+        for (const int count : torn)
+            tornReads += count;
+        QCOMPARE(tornReads, 0);
+        QCOMPARE(terminal->getContainerCount(), 20);
+
+        // A pending epoch reset is applied before a lock-free read
+        QCOMPARE(graph.resetRuntimeState(), 1);
+        QCOMPARE(terminal->systemDynamicsState().lastUpdateTime, 0.0);
+        QCOMPARE(terminal->getCongestionLevel(), 0.0);
+        QCOMPARE(terminal->getContainerCount(), 0);
+    }
+
+    void test_embedded_engine_matches_command_semantics()
+    {
+        TerminalSimEngine engine;
+        engine.addTerminals({makeTerminalSpec(QStringLiteral("T1"))});
+
+        TerminalGraph graph;
+        graph.addTerminal(makeTerminalSpec(QStringLiteral("T1")));
+        CommandProcessor processor(&graph);
+
+        QList<ContainerCore::Container> containers;
+        QJsonArray                      containersJson;
+        for (int i = 0; i < 3; ++i)
+        {
+            ContainerCore::Container container =
+                makeContainer(QStringLiteral("embedded_%1").arg(i));
+            container.addDestination(QStringLiteral("T2"));
+            containers.append(container);
+            containersJson.append(container.toJson());
+        }
+
+        engine.addContainers(QStringLiteral("T1"), containers,
+                             {100.0, TransportationMode::Train,
+                              TerminalArrivalSemantics::Infer});
+        QVERIFY(processor
+                    .processJsonCommand(command(
+                        QStringLiteral("add_containers"),
+                        QJsonObject{
+                            {QStringLiteral("terminal_id"),
+                             QStringLiteral("T1")},
+                            {QStringLiteral("adding_time"), 100.0},
+                            {QStringLiteral("arrival_mode"),
+                             static_cast<int>(TransportationMode::Train)},
+                            {QStringLiteral("containers"), containersJson}}))
+                    .value(QStringLiteral("success"))
+                    .toBool());
+        QCOMPARE(engine.containerCount(QStringLiteral("T1")),
+                 graph.getTerminal(QStringLiteral("T1"))->getContainerCount());
+
+        ContainerCore::ContainerSelectionCriteria criteria;
+        criteria.nextDestination = QStringLiteral("T2");
+        criteria.limit           = 2;
+        const ContainerReservationResult reserved = engine.reserveContainers(
+            QStringLiteral("T1"), QStringLiteral("res-1"), criteria);
+        const QJsonObject reservedByCommand =
+            processor
+                .processJsonCommand(command(
+                    QStringLiteral("reserve_containers"),
+                    QJsonObject{{QStringLiteral("terminal_id"),
+                                 QStringLiteral("T1")},
+                                {QStringLiteral("reservation_id"),
+                                 QStringLiteral("res-1")},
+                                {QStringLiteral("criteria"),
+                                 QJsonObject{{QStringLiteral("next_destination"),
+                                              QStringLiteral("T2")},
+                                             {QStringLiteral("limit"), 2}}}}))
+                .value(QStringLiteral("result"))
+                .toObject();
+        QCOMPARE(reserved.state,
+                 reservedByCommand.value(QStringLiteral("state")).toString());
+        QCOMPARE(reserved.containerCount,
+                 reservedByCommand.value(QStringLiteral("container_count"))
+                     .toInt());
+        QCOMPARE(reserved.containers.size(), 2);
+
+        const ContainerReservationResult committed =
+            engine.commitContainerReservation(QStringLiteral("T1"),
+                                              QStringLiteral("res-1"), 200.0);
+        QCOMPARE(committed.state, QStringLiteral("committed"));
+        QCOMPARE(committed.containers.size(), 2);
+        QCOMPARE(engine.commitContainerReservation(QStringLiteral("T1"),
+                                                   QStringLiteral("res-1"))
+                     .containerCount,
+                 2);
+        QCOMPARE(engine.containerCount(QStringLiteral("T1")), 1);
+
+        const SystemDynamicsState state = engine.updateSystemDynamics(
+            QStringLiteral("T1"), 3600.0, 3600.0);
+        const QJsonObject stateByCommand =
+            processor
+                .processJsonCommand(command(
+                    QStringLiteral("update_system_dynamics"),
+                    QJsonObject{{QStringLiteral("terminal_id"),
+                                 QStringLiteral("T1")},
+                                {QStringLiteral("current_time"), 3600.0},
+                                {QStringLiteral("delta_t"), 3600.0}}))
+                .value(QStringLiteral("result"))
+                .toObject()
+                .value(QStringLiteral("state"))
+                .toObject();
+        // The command side still holds all three containers
+        QVERIFY(state.utilization
+                < stateByCommand.value(QStringLiteral("utilization"))
+                      .toDouble());
+        QCOMPARE(state.lastUpdateTime, 3600.0);
+        QCOMPARE(engine.updateAllSystemDynamics(7200.0).size(), 1);
+
+        QVERIFY_EXCEPTION_THROWN(engine.containerCount(QStringLiteral("T9")),
+                                 std::invalid_argument);
+        QVERIFY_EXCEPTION_THROWN(
+            engine.reserveContainers(QStringLiteral("T1"), QString(),
+                                     criteria),
+            std::invalid_argument);
+    }
+
+    void test_sharded_processors_partition_runtime_state()
+    {
+        // Three shards behind a broker stand-in that delivers by the
+        // routing keys each shard queue is bound to
+        constexpr int shardCount = 3;
+        ShardRing     ring(shardCount);
+        std::vector<std::unique_ptr<TerminalGraph>>    graphs;
+        std::vector<std::unique_ptr<CommandProcessor>> shards;
+        for (int shard = 0; shard < shardCount; ++shard)
+        {
+            graphs.push_back(std::make_unique<TerminalGraph>());
+            shards.push_back(
+                std::make_unique<CommandProcessor>(graphs.back().get()));
+            shards.back()->setShard(shard, shardCount);
+        }
+        const auto publish = [&](const QJsonObject &message) {
+            const QString routingKey = ring.routingKeyFor(message);
+            QList<QJsonObject> responses;
+            for (int shard = 0; shard < shardCount; ++shard)
+            {
+                if (routingKey == ShardRing::broadcastRoutingKey()
+                    || routingKey == ShardRing::shardRoutingKey(shard))
+                    responses.append(shards[shard]->processJsonCommand(message));
+            }
+            ring.bindAliases(message);
+            return responses;
+        };
+
+        QStringList terminalIds;
+        QSet<int>   owners;
+        for (int i = 0; i < 12; ++i)
+        {
+            terminalIds.append(QStringLiteral("T%1").arg(i));
+            owners.insert(ring.shardFor(terminalIds.last()));
+            QCOMPARE(publish(command(QStringLiteral("add_terminal"),
+                                     QJsonObject::fromVariantMap(
+                                         makeTerminalSpec(terminalIds.last()))))
+                         .size(),
+                     shardCount);
+        }
+        QCOMPARE(owners.size(), shardCount);
+        for (const auto &graph : graphs)
+            QCOMPARE(graph->getTerminalCount(), 12);
+
+        for (const QString &terminalId : terminalIds)
+        {
+            const QList<QJsonObject> added = publish(command(
+                QStringLiteral("add_containers"),
+                QJsonObject{{QStringLiteral("terminal_id"), terminalId},
+                            {QStringLiteral("containers"),
+                             QJsonArray{makeContainer(terminalId + QStringLiteral("_c"))
+                                            .toJson()}}}));
+            QCOMPARE(added.size(), 1);
+            QVERIFY(added.first().value(QStringLiteral("success")).toBool());
+
+            // Only the owner holds the containers; the others refuse
+            const int owner = ring.shardFor(terminalId);
+            for (int shard = 0; shard < shardCount; ++shard)
+            {
+                QCOMPARE(graphs[shard]->getTerminal(terminalId)
+                             ->getContainerCount(),
+                         shard == owner ? 1 : 0);
+            }
+            const QJsonObject misrouted =
+                shards[(owner + 1) % shardCount]->processJsonCommand(
+                    command(QStringLiteral("get_container_count"),
+                            QJsonObject{{QStringLiteral("terminal_id"),
+                                         terminalId}}));
+            QVERIFY(!misrouted.value(QStringLiteral("success")).toBool());
+            QVERIFY(misrouted.value(QStringLiteral("error"))
+                        .toString()
+                        .contains(ShardRing::shardRoutingKey(owner)));
+        }
+
+        // An alias hashing to another shard still reaches the owner once
+        // the ring has seen it bound; an unaware ring is refused
+        QString alias;
+        for (int i = 0; alias.isEmpty(); ++i)
+        {
+            const QString candidate = QStringLiteral("T0_alias%1").arg(i);
+            if (ring.shardFor(candidate) != ring.shardFor(QStringLiteral("T0")))
+                alias = candidate;
+        }
+        publish(command(QStringLiteral("add_alias_to_terminal"),
+                        QJsonObject{{QStringLiteral("terminal_name"),
+                                     QStringLiteral("T0")},
+                                    {QStringLiteral("alias"), alias}}));
+        QCOMPARE(ring.canonicalName(alias), QStringLiteral("T0"));
+        const QJsonObject byAlias =
+            command(QStringLiteral("get_container_count"),
+                    QJsonObject{{QStringLiteral("terminal_id"), alias}});
+        QCOMPARE(ring.routingKeyFor(byAlias),
+                 ShardRing::shardRoutingKey(ring.shardFor(QStringLiteral("T0"))));
+        const QList<QJsonObject> counted = publish(byAlias);
+        QCOMPARE(counted.size(), 1);
+        QVERIFY(counted.first().value(QStringLiteral("success")).toBool());
+        QCOMPARE(counted.first().value(QStringLiteral("result")).toInt(), 1);
+
+        const ShardRing unaware(shardCount);
+        const int       guessed = unaware.shardFor(alias);
+        QCOMPARE(unaware.routingKeyFor(byAlias),
+                 ShardRing::shardRoutingKey(guessed));
+        const QJsonObject refused = shards[guessed]->processJsonCommand(byAlias);
+        QVERIFY(!refused.value(QStringLiteral("success")).toBool());
+        QVERIFY(refused.value(QStringLiteral("error"))
+                    .toString()
+                    .contains(ShardRing::shardRoutingKey(
+                        ring.shardFor(QStringLiteral("T0")))));
+
+        // A fleet-wide SD step covers every terminal exactly once
+        int updated = 0;
+        for (const QJsonObject &response :
+             publish(command(QStringLiteral("update_all_terminals_sd"),
+                             QJsonObject{{QStringLiteral("current_time"),
+                                          3600.0}})))
+        {
+            updated += response.value(QStringLiteral("result"))
+                           .toObject()
+                           .value(QStringLiteral("terminals_updated"))
+                           .toInt();
+        }
+        QCOMPARE(updated, 12);
+
+        // Any shard routes over the replicated topology
+        publish(command(QStringLiteral("add_route"),
+                        QJsonObject{{QStringLiteral("route_id"),
+                                     QStringLiteral("R1")},
+                                    {QStringLiteral("start_terminal"),
+                                     QStringLiteral("T0")},
+                                    {QStringLiteral("end_terminal"),
+                                     QStringLiteral("T1")},
+                                    {QStringLiteral("mode"),
+                                     static_cast<int>(
+                                         TransportationMode::Truck)},
+                                    {QStringLiteral("attributes"),
+                                     QJsonObject{{QStringLiteral("distance"),
+                                                  10.0}}}}));
+        const QList<QJsonObject> path = publish(command(
+            QStringLiteral("find_shortest_path"),
+            QJsonObject{{QStringLiteral("start_terminal"), QStringLiteral("T0")},
+                        {QStringLiteral("end_terminal"), QStringLiteral("T1")}}));
+        QCOMPARE(path.size(), 1);
+        QVERIFY(path.first().value(QStringLiteral("success")).toBool());
+
+        // Growing the ring moves only a minority of terminals
+        const ShardRing grown(shardCount + 1);
+        int moved = 0;
+        for (int i = 0; i < 1000; ++i)
+        {
+            const QString terminalId = QStringLiteral("terminal_%1").arg(i);
+            if (ring.shardFor(terminalId) != grown.shardFor(terminalId))
+                ++moved;
+        }
+        QVERIFY(moved > 0);
+        QVERIFY(moved < 500);
+    }
+
+    void test_replica_applies_primary_mutation_stream()
+    {
+        TerminalGraph    primaryGraph;
+        TerminalGraph    replicaGraph;
+        CommandProcessor primary(&primaryGraph);
+        CommandProcessor replica(&replicaGraph);
+        primary.setReplication(ReplicationStream(ReplicationRole::Primary));
+        replica.setReplication(
+            ReplicationStream(ReplicationRole::Replica, false, 60000));
+
+        QList<QJsonObject> records;
+        QObject::connect(&primary, &CommandProcessor::mutationRecorded,
+                         [&records](const QJsonObject &record) {
+                             records.append(record);
+                         });
+
+        const QJsonObject findPath = command(
+            QStringLiteral("find_shortest_path"),
+            QJsonObject{{QStringLiteral("start_terminal"), QStringLiteral("T1")},
+                        {QStringLiteral("end_terminal"), QStringLiteral("T2")}});
+
+        // Never current yet, so the staleness bound refuses reads
+        const QJsonObject early = replica.processJsonCommand(findPath);
+        QVERIFY(!early.value(QStringLiteral("success")).toBool());
+        QCOMPARE(early.value(QStringLiteral("replication"))
+                     .toObject()
+                     .value(QStringLiteral("staleness_ms"))
+                     .toInt(),
+                 -1);
+
+        for (const QString &terminalId :
+             {QStringLiteral("T1"), QStringLiteral("T2")})
+        {
+            primary.processJsonCommand(
+                command(QStringLiteral("add_terminal"),
+                        QJsonObject::fromVariantMap(
+                            makeTerminalSpec(terminalId))));
+        }
+        primary.processJsonCommand(command(
+            QStringLiteral("add_route"),
+            QJsonObject{{QStringLiteral("route_id"), QStringLiteral("R1")},
+                        {QStringLiteral("start_terminal"), QStringLiteral("T1")},
+                        {QStringLiteral("end_terminal"), QStringLiteral("T2")},
+                        {QStringLiteral("mode"),
+                         static_cast<int>(TransportationMode::Truck)},
+                        {QStringLiteral("attributes"),
+                         QJsonObject{{QStringLiteral("distance"), 10.0}}}}));
+        // Runtime commands are not streamed unless asked for
+        primary.processJsonCommand(command(
+            QStringLiteral("add_containers"),
+            QJsonObject{{QStringLiteral("terminal_id"), QStringLiteral("T1")},
+                        {QStringLiteral("containers"),
+                         QJsonArray{makeContainer(QStringLiteral("c1"))
+                                        .toJson()}}}));
+        // The minted scenario ID travels with the record
+        const QString scenarioId =
+            primary
+                .processJsonCommand(command(QStringLiteral("fork_scenario"),
+                                            QJsonObject{}))
+                .value(QStringLiteral("result"))
+                .toObject()
+                .value(QStringLiteral("scenario_id"))
+                .toString();
+        QCOMPARE(records.size(), 4);
+        QCOMPARE(records.last()
+                     .value(QStringLiteral("params"))
+                     .toObject()
+                     .value(QStringLiteral("new_scenario_id"))
+                     .toString(),
+                 scenarioId);
+
+        for (const QJsonObject &record : records)
+            QVERIFY(replica.applyReplicatedMutation(record));
+        QVERIFY(!replica.applyReplicatedMutation(records.first()));
+        QVERIFY(!replica.applyReplicatedMutation(
+            primary.replicationHeartbeat()));
+        QCOMPARE(replicaGraph.getTerminalCount(), 2);
+        QCOMPARE(replicaGraph.getTerminal(QStringLiteral("T1"))
+                     ->getContainerCount(),
+                 0);
+
+        const QJsonObject path = replica.processJsonCommand(findPath);
+        QVERIFY(path.value(QStringLiteral("success")).toBool());
+        const QJsonObject status =
+            path.value(QStringLiteral("replication")).toObject();
+        QCOMPARE(status.value(QStringLiteral("sequence")).toInt(), 4);
+        QVERIFY(status.value(QStringLiteral("staleness_ms")).toInt() >= 0);
+        QJsonObject scenarioParams =
+            findPath.value(QStringLiteral("params")).toObject();
+        scenarioParams[QStringLiteral("scenario_id")] = scenarioId;
+        QVERIFY(replica
+                    .processJsonCommand(command(
+                        QStringLiteral("find_shortest_path"), scenarioParams))
+                    .value(QStringLiteral("success"))
+                    .toBool());
+
+        // Replicas refuse mutations from clients
+        QVERIFY(!replica
+                     .processJsonCommand(command(
+                         QStringLiteral("add_terminal"),
+                         QJsonObject::fromVariantMap(
+                             makeTerminalSpec(QStringLiteral("T9")))))
+                     .value(QStringLiteral("success"))
+                     .toBool());
+
+        // A gap takes the replica out of service
+        for (const QString &terminalId :
+             {QStringLiteral("T3"), QStringLiteral("T4")})
+        {
+            primary.processJsonCommand(
+                command(QStringLiteral("add_terminal"),
+                        QJsonObject::fromVariantMap(
+                            makeTerminalSpec(terminalId))));
+        }
+        QVERIFY_EXCEPTION_THROWN(
+            replica.applyReplicatedMutation(records.last()),
+            std::runtime_error);
+        const QJsonObject outOfSync = replica.processJsonCommand(findPath);
+        QVERIFY(!outOfSync.value(QStringLiteral("success")).toBool());
+        QVERIFY(!outOfSync.value(QStringLiteral("replication"))
+                     .toObject()
+                     .value(QStringLiteral("in_sync"))
+                     .toBool());
+    }
+
+    void test_lock_profile_reports_waits_by_call_site()
+    {
+        TerminalGraph    graph;
+        CommandProcessor processor(&graph);
+        graph.addTerminal(makeTerminalSpec(QStringLiteral("T1"), 100));
+        auto *terminal = graph.getTerminal(QStringLiteral("T1"));
+
+        QJsonObject response = processor.processJsonCommand(
+            command(QStringLiteral("get_lock_profile"),
+                    QJsonObject{{QStringLiteral("enabled"), true},
+                                {QStringLiteral("reset"), true}}));
+        QVERIFY(response.value("success").toBool());
+        QCOMPARE(response.value("event").toString(),
+                 QStringLiteral("lockProfile"));
+        QVERIFY(response.value("result").toObject().value("enabled").toBool());
+
+        std::thread writer([terminal]() {
+            for (int step = 1; step <= 500; ++step)
+                terminal->updateSystemDynamics(step * 10.0, 10.0);
+        });
+        std::thread reader([terminal]() {
+            for (int i = 0; i < 500; ++i)
+                terminal->getRuntimeTerminalSnapshot();
+        });
+        writer.join();
+        reader.join();
+        for (int i = 0; i < 10; ++i)
+        {
+            processor.processJsonCommand(
+                command(QStringLiteral("get_terminal_count"), QJsonObject{}));
+        }
+
+        response = processor.processJsonCommand(
+            command(QStringLiteral("get_lock_profile"),
+                    QJsonObject{{QStringLiteral("enabled"), false},
+                                {QStringLiteral("reset"), true}}));
+        const QJsonObject profile = response.value("result").toObject();
+        QVERIFY(!profile.value("enabled").toBool());
+
+        QHash<QString, QJsonObject> locks;
+        for (const QJsonValue &lock : profile.value("locks").toArray())
+            locks.insert(lock.toObject().value("name").toString(),
+                         lock.toObject());
+        const auto sitesOf = [&locks](const QString &name) {
+            QSet<QString> sites;
+            for (const QJsonValue &site :
+                 locks.value(name).value("sites").toArray())
+                sites.insert(site.toObject().value("site").toString());
+            return sites;
+        };
+
+        // Every terminal reports under one name, each wait in one bucket
+        const QJsonObject terminalLock =
+            locks.value(QStringLiteral("Terminal::m_lock"));
+        QVERIFY(terminalLock.value("acquisitions").toDouble() >= 1000);
+        double bucketed = 0;
+        for (const QJsonValue &bucket :
+             terminalLock.value("wait_histogram").toArray())
+            bucketed += bucket.toObject().value("count").toDouble();
+        QCOMPARE(bucketed, terminalLock.value("acquisitions").toDouble());
+        QVERIFY(sitesOf(QStringLiteral("Terminal::m_lock"))
+                    .contains(QStringLiteral("updateSystemDynamics")));
+        QVERIFY(sitesOf(QStringLiteral("Terminal::m_lock"))
+                    .contains(QStringLiteral("getRuntimeTerminalSnapshot")));
+
+        QVERIFY(locks.value(QStringLiteral("CommandProcessor::m_mutex"))
+                    .value("acquisitions")
+                    .toDouble()
+                >= 10);
+        QVERIFY(sitesOf(QStringLiteral("CommandProcessor::m_mutex"))
+                    .contains(QStringLiteral("processCommand")));
+        QVERIFY(sitesOf(QStringLiteral("TerminalGraph::m_mutex"))
+                    .contains(QStringLiteral("getTerminalCount")));
+
+        // Disabled locks record nothing
+        processor.processJsonCommand(
+            command(QStringLiteral("get_terminal_count"), QJsonObject{}));
+        response = processor.processJsonCommand(
+            command(QStringLiteral("get_lock_profile"), QJsonObject{}));
+        for (const QJsonValue &lock : response.value("result")
+                                          .toObject()
+                                          .value("locks")
+                                          .toArray())
+            QCOMPARE(lock.toObject().value("acquisitions").toDouble(), 0.0);
+    }
 };
 
 QTEST_MAIN(TerminalActualsContractTest)